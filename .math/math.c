@@ -3,81 +3,96 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <time.h>
-
-#define GEMINI_API_KEY " "
-#define API_URL "https://api.gemini.com/v1/speed-math"
-
-// Global Variables for Timer
-static int timer_running = 0;
-static time_t start_time;
-static GtkLabel *timer_label;
-static double total_time = 0;
-static int questions_answered = 0;
-
-// Timer Update Function
-static gboolean update_timer(gpointer data) {
-    if (timer_running) {
-        time_t current_time = time(NULL);
-        int elapsed = (int)difftime(current_time, start_time);
-        char time_str[50];
-        sprintf(time_str, "%02d:%02d:%02d", elapsed / 3600, (elapsed % 3600) / 60, elapsed % 60);
-        gtk_label_set_text(timer_label, time_str);
+#include "../speedmath.h"
+
+// Endpoint, key and request settings shared with the other front ends
+static SpeedmathApi api;
+static RequestTemplate request_template;
+static ResponseBuffer response;
+
+// Timer: the shared per-question stopwatch (monotonic, microseconds)
+static QuestionTimer question_timer;
+static StreamStats solve_times;   // seconds per answered question
+
+// Timer Update Function: runs once per frame, touches the label only when
+// the shown hundredths change
+static gboolean update_timer(GtkWidget *widget, GdkFrameClock *clock, gpointer data) {
+    static char shown[32];
+    char text[32];
+    timer_format(question_timer_elapsed(&question_timer), text, sizeof(text));
+    if (strcmp(text, shown) != 0) {
+        memcpy(shown, text, sizeof(shown));
+        gtk_label_set_text(GTK_LABEL(widget), shown);
     }
-    return TRUE;
+    return G_SOURCE_CONTINUE;
 }
 
 // Start Timer Function
 void start_timer() {
-    timer_running = 1;
-    start_time = time(NULL);
+    question_timer_start(&question_timer);
 }
 
 // Stop Timer Function
 void stop_timer() {
-    timer_running = 0;
-    time_t current_time = time(NULL);
-    total_time += difftime(current_time, start_time);
-    questions_answered++;
+    if (question_timer.running) stream_stats_add(&solve_times, question_timer_stop(&question_timer) / 1e6);
 }
 
 // Average Time Calculation
-char* calculate_average_time() {
-    static char avg_time[50];
-    double avg = (questions_answered > 0) ? (total_time / questions_answered) : 0;
-    sprintf(avg_time, "Average Time: %.2f seconds", avg);
+const char* calculate_average_time() {
+    static char avg_time[160];
+    char stats[128];
+    stream_stats_format(&solve_times, stats, sizeof(stats));
+    snprintf(avg_time, sizeof(avg_time), "Average Time: %s", stats);
     return avg_time;
 }
 
-// HTTP POST Request to Gemini API
-char* send_to_gemini(const char* question, const char* user_answer) {
-    CURL *curl;
-    CURLcode res;
-    char post_fields[512];
-    sprintf(post_fields, "api_key=%s&question=%s&answer=%s", GEMINI_API_KEY, question, user_answer);
+// HTTP POST Request to Gemini API; NULL on failure
+const char* send_to_gemini(const char* question, const char* user_answer) {
+    if (api.offline) return NULL;
+    response_buffer_reset(&response);
+
+    // Escaped into the JSON body, so any question or answer text is safe
+    char *query = g_strdup_printf("Question: %s\nMy answer: %s\nIs my answer correct? "
+                                  "Show the quickest way to solve it.", question, user_answer);
+    RequestBody post_data;
+    request_body_init(&post_data);
+    int built = request_body_build(&post_data, &request_template, query);
+    g_free(query);
+    if (!built) {
+        fprintf(stderr, "Failed to build the request body\n");
+        request_body_free(&post_data);
+        return NULL;
+    }
 
-    curl = curl_easy_init();
+    CURL *curl = curl_easy_init();
     if (!curl) {
         fprintf(stderr, "Failed to initialize CURL\n");
+        request_body_free(&post_data);
         return NULL;
     }
 
-    curl_easy_setopt(curl, CURLOPT_URL, API_URL);
-    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, post_fields);
+    char url[512];
+    speedmath_api_url(&api, 0, url, sizeof(url));
+
+    struct curl_slist *headers = NULL;
+    SpeedmathHeaders storage;
+    for (const char *const *header = speedmath_api_headers(&api, &storage); *header; header++)
+        headers = curl_slist_append(headers, *header);
 
-    static char response[1024];
-    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, (void *)strncpy);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, response);
+    curl_easy_setopt(curl, CURLOPT_URL, url);
+    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, post_data.data);
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, response_buffer_write_callback);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
 
-    res = curl_easy_perform(curl);
-    if (res != CURLE_OK) {
+    CURLcode res = curl_easy_perform(curl);
+    if (res != CURLE_OK)
         fprintf(stderr, "CURL request failed: %s\n", curl_easy_strerror(res));
-        curl_easy_cleanup(curl);
-        return NULL;
-    }
 
+    curl_slist_free_all(headers);
     curl_easy_cleanup(curl);
-    return response;
+    request_body_free(&post_data);
+    return res == CURLE_OK ? response_buffer_str(&response) : NULL;
 }
 
 // Submit Button Callback
@@ -89,10 +104,14 @@ void on_submit_clicked(GtkButton *button, gpointer user_data) {
     const char *user_answer = gtk_entry_get_text(GTK_ENTRY(answer_entry));
 
     stop_timer();
-    char *response = send_to_gemini(question, user_answer);
+    const char *reply = send_to_gemini(question, user_answer);
+    start_timer();   // the next question starts now
 
     GtkLabel *result_label = GTK_LABEL(g_object_get_data(G_OBJECT(button), "result_label"));
-    gtk_label_set_text(result_label, response ? response : "Error connecting to API");
+    if (reply) gtk_label_set_text(result_label, reply);
+    else gtk_label_set_text(result_label, api.offline ? "Offline: no API key or SPEEDMATH_API_URL"
+                                          : response.truncated ? "Error: response too large"
+                                          : "Error connecting to API");
 
     GtkLabel *average_label = GTK_LABEL(g_object_get_data(G_OBJECT(button), "average_label"));
     gtk_label_set_text(average_label, calculate_average_time());
@@ -114,6 +133,12 @@ void on_toggle_theme(GtkSwitch *switch_btn, gpointer user_data) {
 // Main Function
 int main(int argc, char *argv[]) {
     gtk_init(&argc, &argv);
+    response_buffer_init(&response, RESPONSE_BUFFER_DEFAULT_LIMIT);
+    RequestOptions options;
+    speedmath_request_options(&options);
+    request_template_init(&request_template, &options);
+    // Without a key the timer and averages still work; answers are not checked
+    speedmath_api_init(&api);
 
     // Main Window
     GtkWidget *window = gtk_window_new(GTK_WINDOW_TOPLEVEL);
@@ -143,22 +168,24 @@ int main(int argc, char *argv[]) {
     GtkWidget *submit_button = gtk_button_new_with_label("Submit");
     gtk_grid_attach(GTK_GRID(grid), submit_button, 0, 2, 2, 1);
     g_object_set_data(G_OBJECT(submit_button), "answer_entry", answer_entry);
-    g_object_set_data(G_OBJECT(submit_button), "result_label", gtk_label_new(NULL));
     g_signal_connect(submit_button, "clicked", G_CALLBACK(on_submit_clicked), question_entry);
 
     // Result Label
-    GtkWidget *result_label = gtk_label_new("Result:");
+    GtkWidget *result_label = gtk_label_new(api.offline ? "Result: offline, answers are not checked" : "Result:");
+    gtk_label_set_line_wrap(GTK_LABEL(result_label), TRUE);
     gtk_grid_attach(GTK_GRID(grid), result_label, 0, 3, 2, 1);
+    g_object_set_data(G_OBJECT(submit_button), "result_label", result_label);
 
     // Timer
-    timer_label = GTK_LABEL(gtk_label_new("00:00:00"));
-    gtk_grid_attach(GTK_GRID(grid), GTK_WIDGET(timer_label), 0, 4, 2, 1);
+    GtkWidget *timer_label = gtk_label_new("00:00.00");
+    gtk_grid_attach(GTK_GRID(grid), timer_label, 0, 4, 2, 1);
 
-    g_timeout_add(1000, update_timer, NULL);
+    stream_stats_init(&solve_times);
+    gtk_widget_add_tick_callback(timer_label, update_timer, NULL, NULL);
     start_timer();
 
     // Average Time Label
-    GtkWidget *average_label = gtk_label_new("Average Time: 0.00 seconds");
+    GtkWidget *average_label = gtk_label_new("Average Time: -");
     gtk_grid_attach(GTK_GRID(grid), average_label, 0, 5, 2, 1);
     g_object_set_data(G_OBJECT(submit_button), "average_label", average_label);
 
@@ -171,6 +198,8 @@ int main(int argc, char *argv[]) {
     gtk_widget_show_all(window);
     gtk_main();
 
+    request_template_free(&request_template);
+    response_buffer_free(&response);
     return 0;
 }
 
@@ -4,12 +4,12 @@
 #include <string.h>
 #include <curl/curl.h>
 #include <ctype.h> // For isdigit and ispunct
-#include <unistd.h> // For sleep
-#include "../env_loader.h"
+#include "../speedmath.h"
 
 // Global Variables
-char api_key[256];
-char response_buffer[8192];
+SpeedmathApi api;
+RequestTemplate request_template;
+ResponseBuffer response;
 GtkWidget *response_label;
 GtkWidget *entry;
 GtkWidget *status_label;
@@ -18,7 +18,6 @@ GtkWidget *window;
 // Function Prototypes
 void load_api_key();
 void send_query(const char *query);
-size_t write_callback(void *contents, size_t size, size_t nmemb, void *userp);
 void handle_user_query(GtkWidget *widget, gpointer data);
 void update_status(const char *status);
 
@@ -26,7 +25,13 @@ void update_status(const char *status);
 const char *default_query = "give me simplification, approximation and speed math question for preparation practice for Indian banking exam. You will give pyq question one question at a time and we will give the answer (give option also and do mention that the option could be given wrong). After user sends an answer to you, you will give stepwise complete answer. And then mention a note: for next question press 1 or any numeric or special character. If user did, then show them the next question. One question at a time";
 
 int main(int argc, char *argv[]) {
+    Startup *startup = startup_new();
+    guint phase = startup_begin(startup, "window");
     gtk_init(&argc, &argv);
+    response_buffer_init(&response, RESPONSE_BUFFER_DEFAULT_LIMIT);
+    RequestOptions options;
+    speedmath_request_options(&options);
+    request_template_init(&request_template, &options);
 
     // Main Window
     window = gtk_window_new(GTK_WINDOW_TOPLEVEL);
@@ -59,21 +64,24 @@ int main(int argc, char *argv[]) {
     g_signal_connect(submit_button, "clicked", G_CALLBACK(handle_user_query), NULL);
 
     gtk_widget_show_all(window);
-
-    // Update Status Step-by-Step
     update_status("App Working...");
-    sleep(1); // Reduced sleep time for better responsiveness
+    startup_end(startup, phase, TRUE);
 
+    phase = startup_begin(startup, "api_key");
     load_api_key();
     update_status("API Key Loaded...");
-    sleep(1);
-
-    update_status("Connecting to Network...");
-    sleep(1);
+    startup_end(startup, phase, TRUE);
 
+    // The first request is blocking here, so it is timed as part of startup
+    phase = startup_begin(startup, "first_response");
     send_query(default_query);
+    startup_end(startup, phase, response.len > 0);
+    startup_print(startup, stderr);
+    startup_free(startup);
 
     gtk_main();
+    request_template_free(&request_template);
+    response_buffer_free(&response);
     return 0;
 }
 
@@ -83,71 +91,65 @@ void update_status(const char *status) {
     while (gtk_events_pending()) gtk_main_iteration();
 }
 
-// Load API Key from .env file (more secure)
+// Load API Key from .env file (more secure), or use SPEEDMATH_API_URL
 void load_api_key() {
-    char env_file[256];
-    snprintf(env_file, sizeof(env_file), "%s/Desktop/.env", getenv("HOME"));
-    const char *key = get_env_variable(env_file, "GEMINI_API_KEY");
-    if (!key) {
+    if (!speedmath_api_init(&api)) {
         update_status("Failed: API Key Missing");
         fprintf(stderr, "Failed to load API Key.\n");
         exit(1);
     }
-    strncpy(api_key, key, sizeof(api_key));
 }
 
 // Send Query to Gemini API
 void send_query(const char *query) {
     update_status("Sending Request...");
+    response_buffer_reset(&response);
+
+    // Escaped, so quotes and newlines in the query still give valid JSON
+    RequestBody post_data;
+    request_body_init(&post_data);
+    if (!request_body_build(&post_data, &request_template, query)) {
+        update_status("Failed: Request Body");
+        fprintf(stderr, "Failed to build the request body.\n");
+        request_body_free(&post_data);
+        return;
+    }
 
     CURL *curl = curl_easy_init();
     if (!curl) {
         update_status("Failed: CURL Initialization");
         fprintf(stderr, "Failed to initialize CURL.\n");
+        request_body_free(&post_data);
         return;
     }
 
-    // Replace with actual Gemini API endpoint URL
+    // Same endpoint and headers as the app; the raw reply is shown as is
     char url[512];
-    snprintf(url, sizeof(url), "https://<actual_gemini_api_url>/v1/query"); 
+    speedmath_api_url(&api, 0, url, sizeof(url));
 
     struct curl_slist *headers = NULL;
-    // Load API key securely from environment variable
-    headers = curl_slist_append(headers, "Authorization: Bearer "); 
-    headers = curl_slist_append(headers, api_key); 
-    headers = curl_slist_append(headers, "Content-Type: application/json");
-
-    char post_data[1024];
-    snprintf(post_data, sizeof(post_data), "{\"query\": \"%s\"}", query);
+    SpeedmathHeaders storage;
+    for (const char *const *header = speedmath_api_headers(&api, &storage); *header; header++)
+        headers = curl_slist_append(headers, *header);
 
     curl_easy_setopt(curl, CURLOPT_URL, url);
-    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, post_data);
+    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, post_data.data);
     curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_callback);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, response_buffer);
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, response_buffer_write_callback);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
 
     CURLcode res = curl_easy_perform(curl);
     if (res != CURLE_OK) {
-        update_status("Failed: Request Error");
+        update_status(response.truncated ? "Failed: Response Too Large" : "Failed: Request Error");
         fprintf(stderr, "CURL error: %s\n", curl_easy_strerror(res));
     } else {
         update_status("Received response from Gemini...");
-        gtk_label_set_text(GTK_LABEL(response_label), response_buffer);
+        gtk_label_set_text(GTK_LABEL(response_label), response_buffer_str(&response));
     }
 
     curl_slist_free_all(headers);
     curl_easy_cleanup(curl);
-}
-
-// Write Callback for CURL
-size_t write_callback(void *contents, size_t size, size_t nmemb, void *userp) {
-    if (!contents) {
-        update_status("Error receiving data from Gemini");
-        return 0;
-    }
-    size_t total_size = size * nmemb;
-    strncat(userp, contents, total_size);
-    return total_size;
+    request_body_free(&post_data);
 }
 
 // Handle User Query
@@ -3,41 +3,65 @@
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
-#include "../env_loader.h"
+#include <unistd.h>
+#include "../speedmath.h"
 
 // Global Variables
-char api_key[256];
-int current_question = 0;
-double total_time = 0;
-int answered_questions = 0;
-double question_times[100]; // Array to store time for each question
-
-// Questions (Mock Data for Now)
-typedef struct {
-    char question[256];
-    char year[10];
-} Question;
-
-Question questions[] = {
-    {"What is 25 + 35?", "2022"},
-    {"What is 50 x 2?", "2021"}
-};
-int total_questions = 2;
+SessionStats session_stats;   // solve times, overall and per topic
+AttemptLog *attempt_log;      // answers from every session (NULL if it could not be opened)
+
+// Questions: the weakest topics first (question_select.h), drawn from the
+// question bank if there is one, else generated offline
+QuestionBank *bank;
+QuestionSelect *selector;     // over the bank's ids; without a bank it only tracks weakness
+QuestionGen question_gen;
+Question question;
+uint32_t question_id;         // in the bank, or NO_BANK_QUESTION
+#define NO_BANK_QUESTION UINT32_MAX
+char question_text[512];
+GtkWidget *result_label;
+GtkWidget *timer_label;
+GtkWidget *avg_time_label;
+GtkWidget *answer_entry;
+GtkWidget *pause_button;
 
 // Function prototypes
 static void submit_answer(GtkWidget *widget, gpointer data);
 static void next_question(GtkWidget *widget, gpointer data);
-static gboolean update_timer(gpointer data);
-void load_api_key();
+static gboolean update_timer(GtkWidget *widget, GdkFrameClock *clock, gpointer data);
+static gboolean on_entry_focus(GtkWidget *widget, GdkEvent *event, gpointer data);
+static void on_entry_changed(GtkEditable *editable, gpointer data);
+static void on_pause_toggled(GtkToggleButton *button, gpointer data);
+static void start_question_timer(void);
+static void pick_question(void);
 
 // Timer variables
-gboolean running = FALSE;
-guint timer_id = 0;
-time_t start_time;
+QuestionTimer question_timer;
 
 // Initialize GTK Application
 int main(int argc, char *argv[]) {
-    load_api_key();
+    unsigned long long seed = (unsigned long long)time(NULL) ^ (unsigned long long)getpid();
+    question_gen_init(&question_gen, seed);
+    bank = speedmath_open_bank();
+    uint32_t bank_count = bank ? question_bank_count(bank) : 0;
+    selector = question_select_new(bank_count, seed);
+    for (uint32_t id = 0; id < bank_count; id++) {
+        const QuestionRecord *record = question_bank_record(bank, id);
+        if (!question_select_add(selector, id, (QuestionTopic)record->topic, record->difficulty)) {
+            fprintf(stderr, "Error: Out of memory indexing the question bank\n");
+            break;
+        }
+    }
+
+    // Earlier sessions say where to start
+    attempt_log = speedmath_open_history();
+    if (attempt_log) {
+        SessionStats history;
+        attempt_log_stats(attempt_log, &history);
+        for (int t = 0; t < TOPIC_COUNT; t++)
+            question_select_seed_topic(selector, (QuestionTopic)t, &history.topic[t], history.topic_correct[t]);
+    }
+    pick_question();
 
     gtk_init(&argc, &argv);
 
@@ -52,23 +76,36 @@ int main(int argc, char *argv[]) {
     gtk_container_add(GTK_CONTAINER(window), grid);
 
     // Question Label
-    GtkWidget *question_label = gtk_label_new(questions[current_question].question);
+    question_format(&question, question_text, sizeof(question_text));
+    GtkWidget *question_label = gtk_label_new(question_text);
     gtk_grid_attach(GTK_GRID(grid), question_label, 0, 0, 1, 1);
 
     // Year Label
-    GtkWidget *year_label = gtk_label_new(questions[current_question].year);
+    GtkWidget *year_label = gtk_label_new(question.year);
     gtk_grid_attach(GTK_GRID(grid), year_label, 0, 1, 1, 1);
 
     // Answer Entry
     GtkWidget *entry = gtk_entry_new();
     gtk_grid_attach(GTK_GRID(grid), entry, 0, 2, 1, 1);
+    answer_entry = entry;
+    g_signal_connect(entry, "focus-in-event", G_CALLBACK(on_entry_focus), NULL);
+    g_signal_connect(entry, "changed", G_CALLBACK(on_entry_changed), NULL);
+
+    // Result Label (local grading)
+    result_label = gtk_label_new("");
+    gtk_grid_attach(GTK_GRID(grid), result_label, 1, 2, 1, 1);
 
-    // Timer Label (to display the timer)
-    GtkWidget *timer_label = gtk_label_new("00:00:00");
+    // Timer Label (redrawn on the frame clock)
+    timer_label = gtk_label_new("00:00.00");
     gtk_grid_attach(GTK_GRID(grid), timer_label, 0, 3, 1, 1);
 
+    // Pause Button
+    pause_button = gtk_toggle_button_new_with_label("Pause");
+    gtk_grid_attach(GTK_GRID(grid), pause_button, 1, 3, 1, 1);
+    g_signal_connect(pause_button, "toggled", G_CALLBACK(on_pause_toggled), NULL);
+
     // Average Time Label
-    GtkWidget *avg_time_label = gtk_label_new("Average Time: 00:00:00");
+    avg_time_label = gtk_label_new("Average Time: 00:00.00");
     gtk_grid_attach(GTK_GRID(grid), avg_time_label, 0, 4, 3, 1);
 
     // Submit Button
@@ -85,89 +122,129 @@ int main(int argc, char *argv[]) {
     gtk_widget_show_all(window);
 
     // Start Timer
-    running = TRUE;
-    start_time = time(NULL);
-
-    // Start updating timer
-    timer_id = g_timeout_add(1000, update_timer, timer_label);
+    start_question_timer();
+    gtk_widget_add_tick_callback(timer_label, update_timer, NULL, NULL);
 
     gtk_main();
+    attempt_log_close(attempt_log);
+    question_select_free(selector);
+    if (bank) question_bank_close(bank);
     return 0;
 }
 
-// Load API Key from .env
-void load_api_key() {
-    char env_file[256];
-    snprintf(env_file, sizeof(env_file), "%s/Desktop/.env", getenv("HOME"));
-    const char *key = get_env_variable(env_file, "GEMINI_API_KEY");
-    if (!key) {
-        fprintf(stderr, "Failed to load API Key.\n");
-        exit(1);
-    }
-    strncpy(api_key, key, sizeof(api_key));
-}
-
 // Submit Answer Handler
 static void submit_answer(GtkWidget *widget, gpointer data) {
     const char *user_answer = gtk_entry_get_text(GTK_ENTRY(data));
-    printf("User Answer: %s\n", user_answer); // Simulate API interaction
+    const Question *q = &question;
+
+    // Grade locally against the exact answer
+    char result_text[128];
+    AnswerGrade grade = answer_check(q, user_answer, ANSWER_CHECK_DEFAULT_TOLERANCE);
+    switch (grade) {
+    case GRADE_CORRECT:
+        snprintf(result_text, sizeof(result_text), "Correct!");
+        break;
+    case GRADE_WRONG:
+        snprintf(result_text, sizeof(result_text), "Wrong. Answer: %c) %s", 'A' + q->correct_option, q->options[q->correct_option]);
+        break;
+    default:
+        snprintf(result_text, sizeof(result_text), "Enter a number, fraction or option letter");
+        gtk_label_set_text(GTK_LABEL(result_label), result_text);
+        return;
+    }
+    gtk_label_set_text(GTK_LABEL(result_label), result_text);
 
     // Stop Timer and calculate time taken for the current question
-    if (running) {
-        time_t end_time = time(NULL);
-        double elapsed = difftime(end_time, start_time);
-        question_times[current_question] = elapsed;
-        total_time += elapsed;
-        answered_questions++;
-        running = FALSE;
-        g_source_remove(timer_id);
+    if (question_timer.running) {
+        double elapsed = question_timer_stop(&question_timer) / 1e6;
+        session_stats_record(&session_stats, q->topic, elapsed, grade == GRADE_CORRECT);
+        if (question_id != NO_BANK_QUESTION) question_select_record(selector, question_id, elapsed, grade == GRADE_CORRECT);
+        else question_select_record_group(selector, q->topic, q->difficulty, elapsed, grade == GRADE_CORRECT);
+        if (attempt_log) {
+            Attempt attempt;
+            attempt_init(&attempt, q, user_answer, grade, &question_timer);
+            attempt_log_append(attempt_log, &attempt);
+        }
     }
 
-    // Update Average Time
-    double avg_time = total_time / answered_questions;
-    char avg_time_text[50];
-    snprintf(avg_time_text, sizeof(avg_time_text), "Average Time: %.2f seconds", avg_time);  // Corrected line
-
-    // Find the average time label and update it
-    GtkWidget *avg_time_label = gtk_widget_get_parent(widget);
-    while (!GTK_IS_LABEL(avg_time_label)) {
-        avg_time_label = gtk_widget_get_parent(avg_time_label);
+    // Update Average Time (session and this topic), with this question's read/think/type split
+    char session_text[160], topic_text[160], history_text[200] = "", avg_time_text[768];
+    stream_stats_format(&session_stats.all, session_text, sizeof(session_text));
+    if (attempt_log) {
+        SessionStats history;
+        attempt_log_stats(attempt_log, &history);
+        char all_time[160];
+        stream_stats_format(&history.all, all_time, sizeof(all_time));
+        snprintf(history_text, sizeof(history_text), "\nAll time: %s", all_time);
     }
-    gtk_label_set_text(GTK_LABEL(avg_time_label), avg_time_text); // Update average time label
+    stream_stats_format(&session_stats.topic[q->topic], topic_text, sizeof(topic_text));
+    snprintf(avg_time_text, sizeof(avg_time_text), "Session: %s\n%s: %s\nLast: read %.2f s, think %.2f s, type %.2f s%s",
+             session_text, question_topic_name(q->topic), topic_text,
+             question_timer_phase(&question_timer, TIMER_PHASE_READ) / 1e6,
+             question_timer_phase(&question_timer, TIMER_PHASE_THINK) / 1e6,
+             question_timer_phase(&question_timer, TIMER_PHASE_TYPE) / 1e6, history_text);
+    gtk_label_set_text(GTK_LABEL(avg_time_label), avg_time_text);
+}
+
+// The bank's question the selector picks, or a generated one for the
+// weakest topic and difficulty; O(log n) even for a million questions
+static void pick_question(void) {
+    if (bank && question_select_next(selector, QUESTION_GEN_ANY_TOPIC, 0, &question_id) &&
+        question_bank_get(bank, question_id, &question))
+        return;
+    QuestionTopic topic;
+    int difficulty;
+    question_select_group(selector, QUESTION_GEN_ANY_TOPIC, 0, &topic, &difficulty);
+    question_gen_next(&question_gen, topic, difficulty, &question);
+    question_id = NO_BANK_QUESTION;
 }
 
 // Next Question Handler
 static void next_question(GtkWidget *widget, gpointer data) {
-    current_question++;
-    if (current_question < total_questions) {
-        // Update the question
-        gtk_label_set_text(GTK_LABEL(data), questions[current_question].question);
-
-        // Reset Timer
-        GtkWidget *timer_label = gtk_widget_get_parent(widget);
-        while (!GTK_IS_LABEL(timer_label)) {
-            timer_label = gtk_widget_get_parent(timer_label);
-        }
-        gtk_label_set_text(GTK_LABEL(timer_label), "00:00:00");
-
-        running = TRUE;
-        start_time = time(NULL);
-        timer_id = g_timeout_add(1000, update_timer, timer_label);
-    }
+    // Update the question
+    pick_question();
+    question_format(&question, question_text, sizeof(question_text));
+    gtk_label_set_text(GTK_LABEL(data), question_text);
+
+    // Reset Timer; a pause was for the old question
+    gtk_entry_set_text(GTK_ENTRY(answer_entry), "");
+    gtk_label_set_text(GTK_LABEL(result_label), "");
+    gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(pause_button), FALSE);
+    start_question_timer();
 }
 
-// Timer Update Handler
-static gboolean update_timer(gpointer data) {
-    if (!running) return FALSE;
+// Reading starts when the question is shown; the entry is cleared first so
+// that does not count as typing
+static void start_question_timer(void) {
+    question_timer_start(&question_timer);
+}
 
-    time_t elapsed_time = time(NULL) - start_time;
-    int hours = elapsed_time / 3600;
-    int minutes = (elapsed_time / 60) % 60;
-    int seconds = elapsed_time % 60;
+// Attention moved to the answer box: reading is over
+static gboolean on_entry_focus(GtkWidget *widget, GdkEvent *event, gpointer data) {
+    question_timer_advance(&question_timer, TIMER_PHASE_THINK);
+    return FALSE;
+}
 
-    // Update the timer label
-    gtk_label_set_text(GTK_LABEL(data), g_strdup_printf("%02d:%02d:%02d", hours, minutes, seconds));
+// First keystroke: thinking is over
+static void on_entry_changed(GtkEditable *editable, gpointer data) {
+    if (*gtk_entry_get_text(GTK_ENTRY(editable)))
+        question_timer_advance(&question_timer, TIMER_PHASE_TYPE);
+}
 
-    return TRUE;
+static void on_pause_toggled(GtkToggleButton *button, gpointer data) {
+    if (gtk_toggle_button_get_active(button)) question_timer_pause(&question_timer);
+    else question_timer_resume(&question_timer);
 }
 
+// Timer Update Handler: runs once per frame, touches the label only when
+// the shown hundredths change and never allocates
+static gboolean update_timer(GtkWidget *widget, GdkFrameClock *clock, gpointer data) {
+    static char shown[32];
+    char text[32];
+    timer_format(question_timer_elapsed(&question_timer), text, sizeof(text));
+    if (strcmp(text, shown) != 0) {
+        memcpy(shown, text, sizeof(shown));
+        gtk_label_set_text(GTK_LABEL(widget), shown);
+    }
+    return G_SOURCE_CONTINUE;
+}
@@ -4,35 +4,116 @@
 #include <string.h>
 #include <curl/curl.h>
 #include <ctype.h> // For isdigit and ispunct
-#include <unistd.h> // For sleep
-#include "../env_loader.h"
+#include <unistd.h> // For getpid
+#include "../speedmath.h"
+#include "../response_view.h"
+
+#define DEFAULT_PREFETCH_DEPTH 2
+#define MAX_PREFETCH_DEPTH 16         // each is a request in flight
+#define MAX_CONTEXT_TOKENS 1000000    // the model's context window
+#define NO_PHASE G_MAXUINT
+// First turn of every request about a question; the question itself follows as Gemini's turn
+#define GRADING_INSTRUCTION "You asked me this practice question for an Indian banking exam. Grade my answer, then give the stepwise complete solution."
 
 // Global Variables
-char api_key[256];
-char response_buffer[8192];
-GtkWidget *response_label;
+SpeedmathApi api;            // endpoint and key (SPEEDMATH_API_URL, e.g. bench/mock_server)
+RequestEngine *engine;
+QuestionQueue *question_queue;
+QuestionGen question_gen;
+QuestionBank *question_bank;  // past-paper questions for offline practice (optional)
+ResponseCache *response_cache;
+RequestTemplate request_template;  // system prompt and generation config, serialized once
+GBytes *question_request;          // body of every prefetch, built once and shared
+Conversation conversation;         // turns about the question on screen
+gboolean offline;           // no API key (or SPEEDMATH_OFFLINE set): questions are generated locally
+double answer_tolerance = ANSWER_CHECK_DEFAULT_TOLERANCE;
+ResponseView *response_view;   // the session's questions, answers and replies
 GtkWidget *entry;
 GtkWidget *status_label;
+GtkWidget *stream_toggle;
+GtkWidget *timer_label;
+QuestionTimer question_timer;   // time on the question currently shown
+SessionStats session_stats;     // solve times of locally graded questions
+AttemptLog *attempt_log;        // every locally graded answer, across runs (optional)
+NetTrace *net_trace;            // where each request's time went
+NetTraceTotals question_traffic;   // bytes spent on the question on screen
+GtkWidget *network_label;
 GtkWidget *window;
 
+// Startup timeline; freed once every phase has finished and been printed
+Startup *startup;
+GThread *startup_thread;    // key, curl and cache setup while the window draws
+guint connect_phase = NO_PHASE;
+guint first_question_phase = NO_PHASE;
+
+// State of one Gemini request until its reply is shown
+typedef struct {
+    gboolean stream;     // streamGenerateContent (SSE) rather than generateContent
+    gboolean prefetch;   // question for the queue rather than for the response label
+    GeminiStream parser; // streamed replies
+    GeminiJson json;     // whole replies, still parsed as they arrive
+    GString *text;       // decoded text so far
+    GString *raw;        // bytes as received, for the response cache
+    ResponseCachePolicy cache_policy;
+    char cache_key[RESPONSE_CACHE_KEY_SIZE];
+    gboolean cached;     // answered from the response cache
+    gboolean turn;       // a conversation turn: the reply is kept as Gemini's
+    unsigned long question;   // conversation.question when it was asked
+} GeminiReply;
+
+// A question waiting in (or taken from) the prefetch queue
+typedef struct {
+    char *text;          // what is shown to the user
+    Question question;   // structured form, valid when local is TRUE
+    gboolean local;      // generated offline, so the exact answer is known
+    NetTraceTotals traffic;   // what fetching it cost
+} PracticeQuestion;
+
+PracticeQuestion *current_question;
+
 // Function Prototypes
 void load_api_key();
-void send_query(const char *query);
-size_t write_callback(void *contents, size_t size, size_t nmemb, void *userp);
+void send_query(const char *query, ResponseCachePolicy policy);
+void on_stream_text(const char *text, size_t len, void *data);
+void on_stream_data(guint id, const char *data, size_t len, gpointer user_data);
+void on_query_done(guint id, CURLcode result, long http_status, const char *body, size_t body_len, gpointer data);
 void handle_user_query(GtkWidget *widget, gpointer data);
+void practice_question_free(gpointer data);
+void fetch_question(QuestionQueue *queue, gpointer data);
+void show_question(gpointer question, gpointer data);
+void handle_next_question(GtkWidget *widget, gpointer data);
+void handle_show_solution(GtkWidget *widget, gpointer data);
+void update_queue_status(void);
 void update_status(const char *status);
+gpointer startup_worker(gpointer data);
+gboolean on_startup_ready(gpointer data);
+gboolean on_first_draw(GtkWidget *widget, gpointer cr, gpointer data);
+void on_warm_done(guint id, CURLcode result, long http_status, const char *body, size_t body_len, gpointer data);
+void end_startup_phase(guint *phase, gboolean ok);
+NetTrace* open_trace(void);
+gboolean trace_request(guint id, const char *label, CURLcode result, long http_status, NetTraceEntry *entry);
+void update_network_status(void);
+gboolean update_timer(GtkWidget *widget, GdkFrameClock *clock, gpointer data);
+gboolean on_entry_focus(GtkWidget *widget, GdkEvent *event, gpointer data);
+void on_entry_changed(GtkEditable *editable, gpointer data);
 
 // Default Query
 const char *default_query = "give me simplification, approximation and speed math question for preparation practice for Indian banking exam. You will give pyq question one question at a time and we will give the answer (give option also and do mention that the option could be given wrong). After user sends an answer to you, you will give stepwise complete answer. And then mention a note: for next question press 1 or any numeric or special character. If user did, then show them the next question. One question at a time";
 
 int main(int argc, char *argv[]) {
+    startup = startup_new();
+    guint window_phase = startup_begin(startup, "window");
     gtk_init(&argc, &argv);
 
+    // Slow, GTK-free setup runs in parallel with building and drawing the window
+    startup_thread = g_thread_new("startup", startup_worker, NULL);
+
     // Main Window
     window = gtk_window_new(GTK_WINDOW_TOPLEVEL);
     gtk_window_set_title(GTK_WINDOW(window), "Gemini Speed Math Practice");
     gtk_window_set_default_size(GTK_WINDOW(window), 600, 400);
     g_signal_connect(window, "destroy", G_CALLBACK(gtk_main_quit), NULL);
+    g_signal_connect(window, "draw", G_CALLBACK(on_first_draw), GUINT_TO_POINTER(window_phase));
 
     // Main Layout
     GtkWidget *grid = gtk_grid_new();
@@ -42,114 +123,541 @@ int main(int argc, char *argv[]) {
     status_label = gtk_label_new("App Loading...");
     gtk_grid_attach(GTK_GRID(grid), status_label, 0, 0, 1, 1);
 
-    // Response Label
-    response_label = gtk_label_new("Waiting for response...");
-    gtk_label_set_line_wrap(GTK_LABEL(response_label), TRUE);
-    gtk_label_set_xalign(GTK_LABEL(response_label), 0);
-    gtk_grid_attach(GTK_GRID(grid), response_label, 0, 1, 1, 1);
+    // Transcript (replies are appended as they stream, with their markdown rendered)
+    response_view = response_view_new();
+    response_view_note(response_view, RESPONSE_NOTE_APP, "Waiting for response...");
+    gtk_grid_attach(GTK_GRID(grid), response_view_widget(response_view), 0, 1, 3, 1);
 
     // User Input Entry
     entry = gtk_entry_new();
-    gtk_entry_set_placeholder_text(GTK_ENTRY(entry), "Enter your answer (numeric/special characters only)");
+    gtk_entry_set_placeholder_text(GTK_ENTRY(entry), "Enter your answer (number, fraction or option letter)");
     gtk_grid_attach(GTK_GRID(grid), entry, 0, 2, 1, 1);
+    g_signal_connect(entry, "focus-in-event", G_CALLBACK(on_entry_focus), NULL);
+    g_signal_connect(entry, "changed", G_CALLBACK(on_entry_changed), NULL);
 
     // Submit Button
     GtkWidget *submit_button = gtk_button_new_with_label("Submit");
     gtk_grid_attach(GTK_GRID(grid), submit_button, 0, 3, 1, 1);
     g_signal_connect(submit_button, "clicked", G_CALLBACK(handle_user_query), NULL);
 
-    gtk_widget_show_all(window);
+    // Next Question Button (served from the prefetch queue)
+    GtkWidget *next_button = gtk_button_new_with_label("Next Question");
+    gtk_grid_attach(GTK_GRID(grid), next_button, 1, 3, 1, 1);
+    g_signal_connect(next_button, "clicked", G_CALLBACK(handle_next_question), NULL);
 
-    // Update Status Step-by-Step
-    update_status("App Working...");
-    sleep(4);
+    // Solution Button (the only thing that needs Gemini for generated questions)
+    GtkWidget *solution_button = gtk_button_new_with_label("Show Solution");
+    gtk_grid_attach(GTK_GRID(grid), solution_button, 2, 3, 1, 1);
+    g_signal_connect(solution_button, "clicked", G_CALLBACK(handle_show_solution), NULL);
 
-    load_api_key();
-    update_status("File Checked...");
-    sleep(4);
+    // Streaming Toggle (show text as it is generated)
+    stream_toggle = gtk_check_button_new_with_label("Stream responses");
+    gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(stream_toggle), TRUE);
+    gtk_grid_attach(GTK_GRID(grid), stream_toggle, 0, 4, 1, 1);
+
+    // Question Timer (redrawn on the frame clock)
+    timer_label = gtk_label_new("00:00.00");
+    gtk_grid_attach(GTK_GRID(grid), timer_label, 1, 4, 1, 1);
+    gtk_widget_add_tick_callback(timer_label, update_timer, NULL, NULL);
+
+    // Rolling summary of where request time goes
+    network_label = gtk_label_new("Network: no requests yet");
+    gtk_label_set_line_wrap(GTK_LABEL(network_label), TRUE);
+    gtk_grid_attach(GTK_GRID(grid), network_label, 0, 5, 3, 1);
 
-    update_status("Connecting to Network...");
-    sleep(4);
+    gtk_widget_show_all(window);
 
-    send_query(default_query);
+    // Local question sources are ready before the network is
+    guint local_phase = startup_begin(startup, "questions");
+    question_gen_init(&question_gen, (guint64)g_get_real_time() ^ (guint64)getpid());
+    answer_tolerance = speedmath_setting_number("SPEEDMATH_TOLERANCE", 0, 100, ANSWER_CHECK_DEFAULT_TOLERANCE);
+    question_bank = speedmath_open_bank();
+    guint depth = (guint)speedmath_setting_integer("SPEEDMATH_PREFETCH_DEPTH", 1, MAX_PREFETCH_DEPTH, DEFAULT_PREFETCH_DEPTH);
+    question_queue = question_queue_new(depth, fetch_question, NULL, practice_question_free);
+    startup_end(startup, local_phase, TRUE);
+
+    RequestOptions options;
+    speedmath_request_options(&options);
+    request_template_init(&request_template, &options);
+    // 0 is the conversation's default budget
+    long context_tokens = speedmath_setting_integer("SPEEDMATH_CONTEXT_TOKENS", 1, MAX_CONTEXT_TOKENS, 0);
+    conversation_init(&conversation, GRADING_INSTRUCTION, (size_t)context_tokens);
+
+    guint history_phase = startup_begin(startup, "history");
+    attempt_log = speedmath_open_history();
+    startup_end(startup, history_phase, attempt_log != NULL);
+    net_trace = open_trace();
 
     gtk_main();
+
+    // Closed before startup finished: wait for the worker before tearing down
+    if (startup_thread) g_thread_join(startup_thread);
+
+    // Detach the queue first so cancelled prefetches do not report into it
+    QuestionQueue *queue = question_queue;
+    question_queue = NULL;
+    request_engine_free(engine);
+    question_queue_free(queue);
+    ResponseViewStats view_stats = response_view_stats(response_view);
+    if (view_stats.batches)
+        fprintf(stderr, "Transcript: %d lines, %" G_GUINT64_FORMAT " insertions, %.0f µs average, %" G_GINT64_FORMAT " µs worst\n",
+                view_stats.lines, view_stats.batches, (double)view_stats.total_apply_us / view_stats.batches,
+                view_stats.worst_apply_us);
+    response_view_free(response_view);
+    practice_question_free(current_question);
+    if (question_bank) question_bank_close(question_bank);
+    response_cache_free(response_cache);
+    if (question_request) g_bytes_unref(question_request);
+    request_template_free(&request_template);
+    conversation_free(&conversation);
+    attempt_log_close(attempt_log);
+    net_trace_close(net_trace);
+    startup_free(startup);
+    curl_global_cleanup();
     return 0;
 }
 
 // Update Status
 void update_status(const char *status) {
     gtk_label_set_text(GTK_LABEL(status_label), status);
-    while (gtk_events_pending()) gtk_main_iteration();
 }
 
-// Load API Key from .env
+// Startup thread: nothing here may touch GTK
+gpointer startup_worker(gpointer data) {
+    guint phase = startup_begin(startup, "curl_init");
+    CURLcode rc = curl_global_init(CURL_GLOBAL_DEFAULT);
+    startup_end(startup, phase, rc == CURLE_OK);
+
+    phase = startup_begin(startup, "api_key");
+    load_api_key();
+    startup_end(startup, phase, !offline);
+
+    // Replies to identical requests are kept across runs (SPEEDMATH_CACHE=off disables)
+    const char *cache_mode = speedmath_setting("SPEEDMATH_CACHE");
+    if (!offline && !(cache_mode && strcmp(cache_mode, "off") == 0)) {
+        phase = startup_begin(startup, "response_cache");
+        const char *ttl = speedmath_setting("SPEEDMATH_CACHE_TTL");
+        char *cache_dir = g_build_filename(g_get_user_cache_dir(), "speedmath", "responses", NULL);
+        response_cache = response_cache_new(cache_dir, RESPONSE_CACHE_DEFAULT_MEMORY, RESPONSE_CACHE_DEFAULT_DISK,
+                                            ttl ? atoll(ttl) : RESPONSE_CACHE_DEFAULT_TTL);
+        g_free(cache_dir);
+        startup_end(startup, phase, TRUE);
+    }
+
+    g_idle_add(on_startup_ready, NULL);
+    return NULL;
+}
+
+// Back on the main loop: connect and fetch the first question at the same time
+gboolean on_startup_ready(gpointer data) {
+    g_thread_join(startup_thread);
+    startup_thread = NULL;
+    engine = request_engine_new();
+
+    // Both phases are open before either can finish
+    if (!offline) connect_phase = startup_begin(startup, "connect");
+    first_question_phase = startup_begin(startup, "first_question");
+
+    if (offline) {
+        update_status("Offline: questions are generated locally");
+    } else {
+        update_status("Connecting to Network...");
+        if (!request_engine_warm(engine, api.url, on_warm_done, NULL))
+            end_startup_phase(&connect_phase, FALSE);
+    }
+
+    // The first prefetch shares the warming connection (HTTP/2 waits for it)
+    question_queue_refill(question_queue);
+    question_queue_next(question_queue, show_question, NULL);
+    end_startup_phase(NULL, TRUE);
+    return G_SOURCE_REMOVE;
+}
+
+gboolean on_first_draw(GtkWidget *widget, gpointer cr, gpointer data) {
+    guint phase = GPOINTER_TO_UINT(data);
+    g_signal_handlers_disconnect_by_func(widget, on_first_draw, data);
+    end_startup_phase(&phase, TRUE);
+    return FALSE;
+}
+
+// The warm-up request is done: DNS, TCP and TLS are behind us
+void on_warm_done(guint id, CURLcode result, long http_status, const char *body, size_t body_len, gpointer data) {
+    if (result == CURLE_ABORTED_BY_CALLBACK) return;
+    RequestTimings timings;
+    if (startup && request_engine_timings(engine, id, &timings)) {
+        gint64 begin = startup_elapsed(startup) - timings.total;
+        if (timings.dns) startup_add(startup, "dns", begin, begin + timings.dns, TRUE);
+        if (timings.connect) startup_add(startup, "tcp", begin + timings.dns, begin + timings.connect, TRUE);
+        if (timings.tls) startup_add(startup, "tls", begin + timings.connect, begin + timings.tls, TRUE);
+    }
+    NetTraceEntry entry;
+    if (trace_request(id, "warm", result, http_status, &entry)) update_network_status();
+    if (result != CURLE_OK) {
+        fprintf(stderr, "Connection failed: %s\n", curl_easy_strerror(result));
+        update_status("Failed: Could not reach Gemini");
+    } else if (!current_question) {
+        update_status("Connected, fetching the first question...");
+    }
+    end_startup_phase(&connect_phase, result == CURLE_OK);
+}
+
+// Close a startup phase (NULL: none); once startup is over, print the timeline
+void end_startup_phase(guint *phase, gboolean ok) {
+    if (!startup) return;
+    if (phase && *phase != NO_PHASE) {
+        startup_end(startup, *phase, ok);
+        *phase = NO_PHASE;
+    }
+    if (startup_thread || startup_pending(startup)) return;
+    startup_print(startup, stderr);
+    startup_free(startup);
+    startup = NULL;
+}
+
+// Request trace (SPEEDMATH_TRACE: the file's path, or "off" for the on-screen
+// summary only), rotated past SPEEDMATH_TRACE_BYTES
+NetTrace* open_trace(void) {
+    const char *path = speedmath_setting("SPEEDMATH_TRACE");
+    const char *max_bytes = speedmath_setting("SPEEDMATH_TRACE_BYTES");
+    char *default_path = NULL;
+    if (path && strcmp(path, "off") == 0) {
+        path = NULL;
+    } else if (!path) {
+        char *dir = g_build_filename(g_get_user_cache_dir(), "speedmath", NULL);
+        g_mkdir_with_parents(dir, 0700);
+        path = default_path = g_build_filename(dir, "net-trace.tsv", NULL);
+        g_free(dir);
+    }
+    NetTrace *trace = net_trace_open(path, max_bytes ? (size_t)atol(max_bytes) : NET_TRACE_DEFAULT_BYTES,
+                                     NET_TRACE_DEFAULT_KEEP);
+    if (!trace) {
+        fprintf(stderr, "Could not open the request trace %s\n", path);
+        trace = net_trace_open(NULL, 0, 0);
+    }
+    g_free(default_path);
+    return trace;
+}
+
+// Record a finished request (from its done callback) into entry and the trace
+gboolean trace_request(guint id, const char *label, CURLcode result, long http_status, NetTraceEntry *entry) {
+    RequestTimings timings;
+    if (!net_trace || !id || result == CURLE_ABORTED_BY_CALLBACK || !request_engine_timings(engine, id, &timings))
+        return FALSE;
+    memset(entry, 0, sizeof(*entry));
+    entry->when = g_get_real_time();
+    g_strlcpy(entry->label, label, sizeof(entry->label));
+    entry->result = result;
+    entry->status = (int)http_status;
+    entry->http_version = timings.http_version;
+    entry->reused = timings.reused;
+    entry->dns = timings.dns;
+    entry->connect = timings.connect;
+    entry->tls = timings.tls;
+    entry->pretransfer = timings.pretransfer;
+    entry->first_byte = timings.first_byte;
+    entry->total = timings.total;
+    entry->bytes_up = timings.bytes_up;
+    entry->bytes_down = timings.bytes_down;
+    entry->decoded = timings.body_decoded;
+    g_strlcpy(entry->encoding, timings.encoding, sizeof(entry->encoding));
+    net_trace_add(net_trace, entry);
+    return TRUE;
+}
+
+// Phase summary, then bytes for this question and the session
+void update_network_status(void) {
+    NetTraceSummary summary;
+    NetTraceTotals session = net_trace_totals(net_trace);
+    char text[640];
+    net_trace_summary(net_trace, &summary);
+    int n = net_trace_format(&summary, text, sizeof(text));
+    if (n < (int)sizeof(text)) n += snprintf(text + n, sizeof(text) - n, "\nThis question: ");
+    if (n < (int)sizeof(text)) n += net_trace_format_totals(&question_traffic, text + n, sizeof(text) - n);
+    if (n < (int)sizeof(text)) n += snprintf(text + n, sizeof(text) - n, " | Session: ");
+    if (n < (int)sizeof(text)) net_trace_format_totals(&session, text + n, sizeof(text) - n);
+    gtk_label_set_text(GTK_LABEL(network_label), text);
+}
+
+// Load API Key from .env (without one the app runs offline, unless
+// SPEEDMATH_API_URL points at a stand-in, which takes any key)
 void load_api_key() {
-    char env_file[256];
-    snprintf(env_file, sizeof(env_file), "%s/Desktop/speedmath/.env", getenv("HOME"));
-    const char *key = get_env_variable(env_file, "key");
-    if (!key) {
-        update_status("Failed: API Key Missing");
-        fprintf(stderr, "Failed to load API Key.\n");
-        exit(1);
-    }
-    strncpy(api_key, key, sizeof(api_key));
-    printf("API Key Loaded: %s\n", api_key);  // Optional: Debug print to ensure it's loaded
-}
-
-// Send Query to Gemini API
-void send_query(const char *query) {
-    update_status("Sending Request...");
-
-    CURL *curl = curl_easy_init();
-    if (!curl) {
-        update_status("Failed: CURL Initialization");
-        fprintf(stderr, "Failed to initialize CURL.\n");
-        return;
+    offline = !speedmath_api_init(&api);
+    if (offline && !speedmath_setting("SPEEDMATH_OFFLINE")) fprintf(stderr, "Failed to load API Key, running offline.\n");
+}
+
+static GeminiReply* gemini_reply_new(gboolean stream, gboolean prefetch, ResponseCachePolicy policy) {
+    GeminiReply *reply = g_new0(GeminiReply, 1);
+    reply->stream = stream;
+    reply->prefetch = prefetch;
+    reply->cache_policy = response_cache ? policy : RESPONSE_CACHE_BYPASS;
+    reply->text = g_string_new(NULL);
+    if (reply->cache_policy != RESPONSE_CACHE_BYPASS) reply->raw = g_string_new(NULL);
+    if (stream) gemini_stream_init(&reply->parser, on_stream_text, reply);
+    else gemini_json_init(&reply->json, on_stream_text, reply);
+    return reply;
+}
+
+static void gemini_reply_free(GeminiReply *reply) {
+    if (reply->stream) gemini_stream_free(&reply->parser);
+    g_string_free(reply->text, TRUE);
+    if (reply->raw) g_string_free(reply->raw, TRUE);
+    g_free(reply);
+}
+
+// Usage counts and error fields of the reply
+static const GeminiJson* gemini_reply_json(const GeminiReply *reply) {
+    return reply->stream ? &reply->parser.json : &reply->json;
+}
+
+// Bytes of the reply body, from the network or the cache
+static void gemini_reply_feed(GeminiReply *reply, const char *data, size_t len) {
+    if (reply->stream) gemini_stream_feed(&reply->parser, data, len);
+    else gemini_json_feed(&reply->json, data, len);
+}
+
+// Replay a cached body through the normal completion path
+static void serve_cached(GeminiReply *reply, GBytes *cached) {
+    gsize len;
+    const char *data = g_bytes_get_data(cached, &len);
+    reply->cached = TRUE;
+    reply->cache_policy = RESPONSE_CACHE_BYPASS;   // already stored
+    gemini_reply_feed(reply, data, len);
+    on_query_done(0, CURLE_OK, 200, "", 0, reply);
+}
+
+// A finished body (ok: it was built) as one allocation, handed to curl
+// without another copy
+static GBytes* take_body(RequestBody *body, gboolean ok) {
+    size_t len = 0;
+    char *data = ok ? request_body_steal(body, &len) : NULL;
+    request_body_free(body);
+    return data ? g_bytes_new_with_free_func(data, len, free, data) : NULL;
+}
+
+// Request body for query alone: the template's head, the escaped query, the end
+static GBytes* build_request(const char *query) {
+    RequestBody body;
+    request_body_init(&body);
+    return take_body(&body, request_body_build(&body, &request_template, query));
+}
+
+// Queue a Gemini request, or answer it from the response cache right away.
+// Returns FALSE (reply still owned by the caller) if it could not be sent.
+static gboolean post_gemini(GBytes *body, GeminiReply *reply) {
+    const char *endpoint = reply->stream ? "streamGenerateContent" : "generateContent";
+
+    // Same model, endpoint and body give the same key (the API key is not part of it)
+    if (reply->cache_policy != RESPONSE_CACHE_BYPASS) {
+        response_cache_key(SPEEDMATH_MODEL, endpoint, g_bytes_get_data(body, NULL), reply->cache_key);
+        GBytes *cached = response_cache_lookup(response_cache, reply->cache_key, reply->cache_policy);
+        if (cached) {
+            serve_cached(reply, cached);
+            g_bytes_unref(cached);
+            return TRUE;
+        }
     }
 
     // Correct URL for Gemini API
     char url[512];
-    snprintf(url, sizeof(url), "https://generativelanguage.googleapis.com/v1beta/models/gemini-1.5-flash:generateContent?key=%s", api_key);
+    speedmath_api_url(&api, reply->stream, url, sizeof(url));
+    SpeedmathHeaders headers;
 
-    struct curl_slist *headers = NULL;
-    headers = curl_slist_append(headers, "Content-Type: application/json");
+    // Whole replies are parsed as they arrive too, so the body is never held in full
+    return request_engine_post_bytes(engine, url, body, speedmath_api_headers(&api, &headers),
+                                     on_stream_data, on_query_done, reply) != 0;
+}
 
-    // Increased size for authorization header buffer to avoid truncation
-    char authorization_header[512];  // Make this large enough for the full "Bearer <api_key>" string
-    snprintf(authorization_header, sizeof(authorization_header), "Authorization: Bearer %s", api_key);
-    headers = curl_slist_append(headers, authorization_header);
+// Send Query to Gemini API (returns immediately, on_query_done gets the reply).
+// About a Gemini question, the query goes with the question and the recent
+// turns about it; otherwise it goes alone.
+void send_query(const char *query, ResponseCachePolicy policy) {
+    if (!engine) {
+        update_status("Still starting up...");
+        return;
+    }
+    gtk_label_set_text(GTK_LABEL(status_label), "Sending Request...");
+    gboolean streaming = gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(stream_toggle));
+
+    GeminiReply *reply = gemini_reply_new(streaming, FALSE, policy);
+    reply->turn = TRUE;
+    reply->question = conversation.question;
+    RequestBody request;
+    request_body_init(&request);
+    GBytes *body = take_body(&request, conversation_ask(&conversation, &request, &request_template, query, strlen(query)));
+    if (!body || !post_gemini(body, reply)) {
+        gemini_reply_free(reply);
+        gtk_label_set_text(GTK_LABEL(status_label), "Failed: CURL Initialization");
+    }
+    if (body) g_bytes_unref(body);
+}
 
-    char post_data[1024];
-    snprintf(post_data, sizeof(post_data), "{\"contents\": [{\"parts\": [{\"text\": \"%s\"}]}]}", query);
+void practice_question_free(gpointer data) {
+    PracticeQuestion *practice = data;
+    if (!practice) return;
+    g_free(practice->text);
+    g_free(practice);
+}
 
-    curl_easy_setopt(curl, CURLOPT_URL, url);
-    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, post_data);
-    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_callback);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, response_buffer);
+// QuestionFetchFunc: generate one question locally or in the background
+void fetch_question(QuestionQueue *queue, gpointer data) {
+    if (offline) {
+        PracticeQuestion *practice = g_new0(PracticeQuestion, 1);
+        // Past-paper questions from the bank when there is one, else generated
+        if (!question_bank ||
+            !question_bank_get(question_bank, g_random_int_range(0, question_bank_count(question_bank)), &practice->question))
+            question_gen_next(&question_gen, QUESTION_GEN_ANY_TOPIC, 0, &practice->question);
+        char text[512];
+        question_format(&practice->question, text, sizeof(text));
+        practice->text = g_strdup(text);
+        practice->local = TRUE;
+        question_queue_push(queue, practice);
+        return;
+    }
 
-    // Enable verbose mode for more details
-    curl_easy_setopt(curl, CURLOPT_VERBOSE, 1L);
+    // Every prefetch should bring a new question, so the cache is bypassed
+    GeminiReply *reply = gemini_reply_new(TRUE, TRUE, RESPONSE_CACHE_BYPASS);
+    if (!question_request) question_request = build_request(default_query);
+    if (!question_request || !post_gemini(question_request, reply)) {
+        gemini_reply_free(reply);
+        question_queue_push(queue, NULL);
+    }
+}
 
-    CURLcode res = curl_easy_perform(curl);
-    if (res != CURLE_OK) {
-        update_status("Failed: Request Error");
-        fprintf(stderr, "CURL error: %s\n", curl_easy_strerror(res));
-    } else {
-        update_status("Response Achieved...");
-        gtk_label_set_text(GTK_LABEL(response_label), response_buffer);
+// Each decoded piece of candidate text is appended to the transcript
+void on_stream_text(const char *text, size_t len, void *data) {
+    GeminiReply *reply = data;
+    g_string_append_len(reply->text, text, len);
+    if (!reply->prefetch) response_view_markdown(response_view, text, len);
+}
+
+// Raw body bytes (SSE or JSON) as they arrive from the network
+void on_stream_data(guint id, const char *data, size_t len, gpointer user_data) {
+    GeminiReply *reply = user_data;
+    if (reply->raw) g_string_append_len(reply->raw, data, len);
+    gemini_reply_feed(reply, data, len);
+}
+
+// Completion of a Gemini request (runs on the GTK main loop)
+void on_query_done(guint id, CURLcode result, long http_status, const char *body, size_t body_len, gpointer data) {
+    GeminiReply *reply = data;
+    gboolean ok = result == CURLE_OK && http_status < 400;
+    NetTraceEntry entry;
+    gboolean traced = trace_request(id, reply->prefetch ? "question" : "query", result, http_status, &entry);
+    if (traced && !reply->prefetch) net_trace_count(&question_traffic, &entry);
+    if (traced) update_network_status();
+    gboolean stream = reply->stream, prefetch = reply->prefetch, cached = reply->cached;
+
+    if (stream) gemini_stream_finish(&reply->parser);
+    else gemini_json_finish(&reply->json);
+    const GeminiJson *json = gemini_reply_json(reply);
+    GeminiUsage usage = json->usage;
+    char problem[320] = "";   // why there is no answer to show, if there is none
+    if (json->error_message[0])
+        snprintf(problem, sizeof(problem), "Gemini error %d (%s): %s", json->error_code, json->error_status, json->error_message);
+    else if (json->block_reason[0])
+        snprintf(problem, sizeof(problem), "Gemini blocked the prompt: %s", json->block_reason);
+    else if (ok && json->failed)
+        snprintf(problem, sizeof(problem), "Gemini sent a reply that is not JSON");
+    ok = ok && !problem[0];
+
+    if (ok && reply->cache_policy != RESPONSE_CACHE_BYPASS)
+        response_cache_store(response_cache, reply->cache_key, reply->raw->str, reply->raw->len, reply->cache_policy);
+    if (ok && reply->turn) {
+        conversation_reply(&conversation, reply->question, reply->text->str, reply->text->len);
+        if (!cached) conversation_observe(&conversation, usage.prompt_tokens);
     }
 
-    curl_slist_free_all(headers);
-    curl_easy_cleanup(curl);
+    if (prefetch && question_queue) {
+        if (ok && reply->text->len > 0) {
+            PracticeQuestion *practice = g_new0(PracticeQuestion, 1);
+            practice->text = g_string_free(reply->text, FALSE);
+            if (traced) net_trace_count(&practice->traffic, &entry);
+            reply->text = g_string_new(NULL);
+            question_queue_push(question_queue, practice);
+        } else {
+            question_queue_push(question_queue, NULL);
+            if (result != CURLE_ABORTED_BY_CALLBACK) {
+                fprintf(stderr, "Prefetch failed: %s (HTTP %ld) %s\n", curl_easy_strerror(result), http_status, problem);
+                end_startup_phase(&first_question_phase, FALSE);
+            }
+        }
+    }
+    gemini_reply_free(reply);
+    if (prefetch) {
+        if (question_queue) update_queue_status();
+        return;
+    }
+
+    response_view_end(response_view);
+    if (result == CURLE_ABORTED_BY_CALLBACK) return;
+    if (result != CURLE_OK) {
+        gtk_label_set_text(GTK_LABEL(status_label), "Failed: Request Error");
+        fprintf(stderr, "CURL error: %s\n", curl_easy_strerror(result));
+        return;
+    }
+    if (http_status >= 400 || problem[0]) {
+        gtk_label_set_text(GTK_LABEL(status_label), "Failed: Gemini returned an error");
+        fprintf(stderr, "HTTP error: %ld %s\n", http_status, problem);
+        if (problem[0]) response_view_note(response_view, RESPONSE_NOTE_ERROR, problem);
+        return;
+    }
+    ConnectionStats conn = request_engine_connection_stats(engine);
+    char status[320];
+    int n = snprintf(status, sizeof(status), "%s (connections: %lu reused, %lu new)",
+                     request_engine_in_flight(engine) ? "Waiting for more responses..." :
+                     cached ? "Response Achieved (cached)..." : "Response Achieved...",
+                     conn.reused, conn.fresh);
+    if (usage.total_tokens >= 0)
+        n += snprintf(status + n, sizeof(status) - n, " | tokens: %ld in, %ld out",
+                      usage.prompt_tokens, usage.candidates_tokens);
+    ConversationStats context = conversation_stats(&conversation);
+    if (context.turns_sent && n < (int)sizeof(status))
+        n += snprintf(status + n, sizeof(status) - n, " | sent %d turns, %zu B (%lu B/turn)",
+                      context.last_turns, context.last_bytes, context.bytes_sent / context.turns_sent);
+    if (response_cache && n < (int)sizeof(status)) {
+        ResponseCacheStats cache = response_cache_stats(response_cache);
+        gulong lookups = cache.hits + cache.misses;
+        snprintf(status + n, sizeof(status) - n, " | cache: %lu/%lu hits (%.0f%%), %.1f KB saved",
+                 cache.hits, lookups, lookups ? 100.0 * cache.hits / lookups : 0.0, cache.bytes_saved / 1024.0);
+    }
+    gtk_label_set_text(GTK_LABEL(status_label), status);
 }
 
-// Write Callback for CURL
-size_t write_callback(void *contents, size_t size, size_t nmemb, void *userp) {
-    size_t total_size = size * nmemb;
-    strncat(userp, contents, total_size);
-    return total_size;
+// QuestionReadyFunc: put the next question on screen
+void show_question(gpointer question, gpointer data) {
+    practice_question_free(current_question);
+    current_question = question;
+    // Gemini's questions are graded by Gemini, which needs to see them again
+    if (current_question->local) conversation_clear(&conversation);
+    else conversation_begin(&conversation, current_question->text, strlen(current_question->text));
+    question_traffic = current_question->traffic;
+    if (net_trace) update_network_status();
+    response_view_begin(response_view);
+    response_view_markdown(response_view, current_question->text, strlen(current_question->text));
+    response_view_end(response_view);
+    gtk_entry_set_text(GTK_ENTRY(entry), "");
+    question_timer_start(&question_timer);
+    update_queue_status();
+    end_startup_phase(&first_question_phase, TRUE);
+}
+
+// Next Question (instant when the prefetch queue has one ready)
+void handle_next_question(GtkWidget *widget, gpointer data) {
+    if (!engine) {
+        update_status("Still starting up...");
+        return;
+    }
+    question_queue_next(question_queue, show_question, NULL);
+    update_queue_status();
+}
+
+// Show prefetch queue depth and hit/miss counts
+void update_queue_status(void) {
+    QuestionQueueStats stats = question_queue_stats(question_queue);
+    char status[128];
+    snprintf(status, sizeof(status), "Questions ready: %u/%u (fetching %u) | hits %lu, misses %lu",
+             stats.ready, stats.capacity, stats.in_flight, stats.hits, stats.misses);
+    gtk_label_set_text(GTK_LABEL(status_label), status);
 }
 
 // Handle User Query
@@ -157,16 +665,107 @@ void handle_user_query(GtkWidget *widget, gpointer data) {
     const char *user_input = gtk_entry_get_text(GTK_ENTRY(entry));
 
     // Validate user input
-    for (const char *c = user_input; *c; c++) {
-        if (!(isdigit(*c) || ispunct(*c))) {
-            gtk_label_set_text(GTK_LABEL(response_label), "Invalid input. Only numeric and special characters are allowed.");
-            return;
+    if (answer_parse_option(user_input) < 0) {
+        for (const char *c = user_input; *c; c++) {
+            if (!(isdigit(*c) || ispunct(*c) || *c == ' ')) {
+                response_view_note(response_view, RESPONSE_NOTE_ERROR, "Invalid input. Enter a number, a fraction or an option letter (A-D).");
+                return;
+            }
         }
     }
 
-    // Send query to Gemini
-    send_query(user_input);
+    char said[320];
+    snprintf(said, sizeof(said), "Your answer: %s", user_input);
+    response_view_note(response_view, RESPONSE_NOTE_USER, said);
+
+    // Generated questions are graded locally; everything else goes to Gemini
+    if (current_question && current_question->local) {
+        const Question *q = &current_question->question;
+        gint64 start = timer_now_us();
+        AnswerGrade grade = answer_check(q, user_input, answer_tolerance);
+        gint64 elapsed = timer_now_us() - start;
+
+        char result[1024];
+        if (grade == GRADE_INVALID) {
+            snprintf(result, sizeof(result), "Could not read \"%s\" as an answer.", user_input);
+        } else {
+            char total[32], topic_stats[160], history[96] = "";
+            if (question_timer.running) {
+                session_stats_record(&session_stats, q->topic, question_timer_stop(&question_timer) / 1e6,
+                                     grade == GRADE_CORRECT);
+                if (attempt_log) {
+                    AttemptSummary seen;
+                    if (attempt_log_summary(attempt_log, attempt_question_id(q), &seen))
+                        snprintf(history, sizeof(history), "\nAnswered %u time(s) before, %u correct",
+                                 seen.attempts, seen.correct);
+                    Attempt attempt;
+                    attempt_init(&attempt, q, user_input, grade, &question_timer);
+                    attempt_log_append(attempt_log, &attempt);
+                }
+            }
+            timer_format(question_timer_elapsed(&question_timer), total, sizeof(total));
+            stream_stats_format(&session_stats.topic[q->topic], topic_stats, sizeof(topic_stats));
+            snprintf(result, sizeof(result), "%s Correct answer: %c) %s (graded in %" G_GINT64_FORMAT " µs)\n"
+                     "Time: %s (read %.2f s, think %.2f s, type %.2f s)\n%s: %s%s",
+                     grade == GRADE_CORRECT ? "Correct!" : "Wrong.",
+                     'A' + q->correct_option, q->options[q->correct_option], elapsed, total,
+                     question_timer_phase(&question_timer, TIMER_PHASE_READ) / 1e6,
+                     question_timer_phase(&question_timer, TIMER_PHASE_THINK) / 1e6,
+                     question_timer_phase(&question_timer, TIMER_PHASE_TYPE) / 1e6,
+                     question_topic_name(q->topic), topic_stats, history);
+        }
+        response_view_note(response_view, grade == GRADE_INVALID ? RESPONSE_NOTE_ERROR : RESPONSE_NOTE_APP, result);
+    } else {
+        question_timer_stop(&question_timer);
+        // An answer only means something with its question: sent alone
+        // (no question on screen), a cached reply to "B" would be for another
+        send_query(user_input, conversation.count ? RESPONSE_CACHE_NORMAL : RESPONSE_CACHE_BYPASS);
+    }
 
     // Clear the entry box for new input
     gtk_entry_set_text(GTK_ENTRY(entry), "");
 }
+
+// Timer label, once per frame; only touched when the shown hundredths change
+gboolean update_timer(GtkWidget *widget, GdkFrameClock *clock, gpointer data) {
+    static char shown[32];
+    char text[32];
+    timer_format(question_timer_elapsed(&question_timer), text, sizeof(text));
+    if (strcmp(text, shown) != 0) {
+        memcpy(shown, text, sizeof(shown));
+        gtk_label_set_text(GTK_LABEL(widget), shown);
+    }
+    return G_SOURCE_CONTINUE;
+}
+
+// Attention moved to the answer box: reading is over
+gboolean on_entry_focus(GtkWidget *widget, GdkEvent *event, gpointer data) {
+    question_timer_advance(&question_timer, TIMER_PHASE_THINK);
+    return FALSE;
+}
+
+// First keystroke: thinking is over
+void on_entry_changed(GtkEditable *editable, gpointer data) {
+    if (*gtk_entry_get_text(GTK_ENTRY(editable)))
+        question_timer_advance(&question_timer, TIMER_PHASE_TYPE);
+}
+
+// Ask Gemini for a step-by-step solution of the current question
+void handle_show_solution(GtkWidget *widget, gpointer data) {
+    if (!current_question) return;
+    if (offline) {
+        gtk_label_set_text(GTK_LABEL(status_label), "Offline: step-by-step solutions need an API key");
+        return;
+    }
+    response_view_note(response_view, RESPONSE_NOTE_USER, "Show solution");
+    if (!current_question->local) {
+        // Sent with the question, so a cached reply is for this one
+        send_query("Show the stepwise complete solution of this question.", RESPONSE_CACHE_NORMAL);
+        return;
+    }
+    const Question *q = &current_question->question;
+    char *query = g_strdup_printf("Give a stepwise complete solution, using the fastest exam shortcut, for: %s Options: A) %s, B) %s, C) %s, D) %s. The correct answer is %c.",
+                                  q->question, q->options[0], q->options[1], q->options[2], q->options[3], 'A' + q->correct_option);
+    send_query(query, RESPONSE_CACHE_NORMAL);
+    g_free(query);
+}
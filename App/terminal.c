@@ -0,0 +1,628 @@
+#include <glib.h>
+#include <glib-unix.h>
+#include <curses.h>
+#include <locale.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#include <curl/curl.h>
+#include "../speedmath.h"
+
+// Keyboard-only drills in a terminal (works over SSH), on the same question,
+// grading, timing and request code as the GTK app. Questions come from the
+// bank or the generator and are graded locally, so a keypress is graded and
+// the next question drawn before the screen is refreshed. Nothing network
+// related is set up until the first solution is asked for.
+
+#define ANSWER_LENGTH 32
+#define DRILL_ROWS 14          // status bar, question, answer and result; the solution gets the rest
+#define TIMER_REDRAW_MS 100    // the clock shows tenths, so this is every change
+
+// Color pairs
+enum { PAIR_MATH = 1, PAIR_CODE, PAIR_CORRECT, PAIR_WRONG };
+
+// Global Variables
+SpeedmathApi api;
+gboolean offline;            // no API key: drills work, solutions do not
+RequestEngine *engine;       // created with the first solution request
+RequestTemplate request_template;
+QuestionGen question_gen;
+QuestionBank *question_bank;
+QuestionTopic topic = QUESTION_GEN_ANY_TOPIC;
+int difficulty;              // 0 for any
+double answer_tolerance = ANSWER_CHECK_DEFAULT_TOLERANCE;
+Question question;           // on screen
+Question last_question;      // just answered, what 's' explains
+gboolean have_last;
+char answer[ANSWER_LENGTH];  // typed so far
+size_t answer_len;
+char result[3][320];         // feedback on the last answer
+int result_pair;             // PAIR_CORRECT, PAIR_WRONG or 0
+QuestionTimer question_timer;
+SessionStats session_stats;
+AttemptLog *attempt_log;
+gboolean history_opened;     // attempt_log is opened after the first frame
+int answered, streak, best_streak, answer_limit;
+gint64 feedback_total_us, feedback_worst_us;   // keypress to refreshed screen
+int feedback_count;
+GMainLoop *loop;
+WINDOW *drill_win, *solution_win, *help_win;
+Startup *startup;
+guint first_frame_phase;
+gboolean exit_after_first_frame;
+
+// Streamed solution: SSE -> candidate text -> markdown spans -> the window
+typedef struct {
+    guint id;
+    GeminiStream parser;
+    MarkdownParser markdown;
+} Solution;
+
+Solution *solution;               // in flight
+GString *solution_text;           // markdown so far, to redraw after a resize
+char solution_title[QUESTION_TEXT_LENGTH + 16];
+gboolean solution_done;
+
+// Function Prototypes
+AttemptLog* history(void);
+gboolean start_network(void);
+void next_question(void);
+void grade(const char *input);
+void handle_key(int key);
+void request_solution(void);
+void on_solution_text(const char *text, size_t len, void *data);
+void on_solution_data(guint id, const char *data, size_t len, gpointer user_data);
+void on_solution_done(guint id, CURLcode result, long http_status, const char *body, size_t body_len, gpointer data);
+void on_span(const char *text, size_t len, unsigned style, void *data);
+void layout(void);
+void draw_status(void);
+void draw_drill(void);
+void draw_solution(void);
+void draw_help(void);
+gboolean on_input(GIOChannel *channel, GIOCondition condition, gpointer data);
+gboolean on_timer(gpointer data);
+gboolean on_first_frame(gpointer data);
+gboolean on_resize(gpointer data);
+gboolean on_quit(gpointer data);
+void print_summary(void);
+
+static void usage(const char *name) {
+    fprintf(stderr, "Usage: %s [-t topic] [-d difficulty] [-n questions] [-x]\n"
+                    "  -t  first letters of a topic, e.g. perc (default: mixed)\n"
+                    "  -d  1 (easy) to 3 (hard) (default: any)\n"
+                    "  -n  stop after this many answers\n"
+                    "  -x  exit once the first question is on screen (to time cold start)\n", name);
+}
+
+int main(int argc, char *argv[]) {
+    startup = startup_new();
+    int opt;
+    while ((opt = getopt(argc, argv, "t:d:n:xh")) != -1) {
+        switch (opt) {
+        case 't':
+            for (topic = 0; *optarg && topic < TOPIC_COUNT; topic++)
+                if (g_ascii_strncasecmp(optarg, question_topic_name(topic), strlen(optarg)) == 0) break;
+            if (!*optarg || topic == TOPIC_COUNT) {
+                fprintf(stderr, "Error: No topic starts with '%s'. Topics:", optarg);
+                for (int t = 0; t < TOPIC_COUNT; t++) fprintf(stderr, " %s", question_topic_name(t));
+                fprintf(stderr, "\n");
+                return 1;
+            }
+            break;
+        case 'd': difficulty = CLAMP(atoi(optarg), 0, 3); break;
+        case 'n': answer_limit = atoi(optarg); break;
+        case 'x': exit_after_first_frame = TRUE; break;
+        default: usage(argv[0]); return opt == 'h' ? 0 : 1;
+        }
+    }
+
+    guint phase = startup_begin(startup, "questions");
+    question_gen_init(&question_gen, (guint64)g_get_real_time() ^ (guint64)getpid());
+    answer_tolerance = speedmath_setting_number("SPEEDMATH_TOLERANCE", 0, 100, ANSWER_CHECK_DEFAULT_TOLERANCE);
+    question_bank = speedmath_open_bank();
+    session_stats_init(&session_stats);
+    startup_end(startup, phase, TRUE);
+
+    phase = startup_begin(startup, "terminal");
+    setlocale(LC_ALL, "");   // UTF-8 in questions and replies
+    if (!initscr()) return 1;
+    raw();                   // Ctrl-C is a key, so quitting always flushes the history
+    noecho();
+    set_escdelay(25);
+    curs_set(1);
+    if (has_colors()) {
+        start_color();
+        use_default_colors();
+        init_pair(PAIR_MATH, COLOR_CYAN, -1);
+        init_pair(PAIR_CODE, COLOR_YELLOW, -1);
+        init_pair(PAIR_CORRECT, COLOR_GREEN, -1);
+        init_pair(PAIR_WRONG, COLOR_RED, -1);
+    }
+    solution_text = g_string_new(NULL);
+    layout();
+    startup_end(startup, phase, TRUE);
+
+    first_frame_phase = startup_begin(startup, "first_question");
+    next_question();
+    snprintf(result[0], sizeof(result[0]), "Ready in %.1f ms. Type an option letter, or a number and Enter.",
+             startup_elapsed(startup) / 1e3);
+    draw_status();
+    draw_drill();
+    draw_help();
+    doupdate();
+    startup_end(startup, first_frame_phase, TRUE);
+
+    loop = g_main_loop_new(NULL, FALSE);
+    GIOChannel *input = g_io_channel_unix_new(STDIN_FILENO);
+    g_io_add_watch(input, G_IO_IN | G_IO_HUP | G_IO_ERR, on_input, NULL);
+    g_io_channel_unref(input);
+    g_timeout_add(TIMER_REDRAW_MS, on_timer, NULL);
+    g_unix_signal_add(SIGWINCH, on_resize, NULL);
+    g_unix_signal_add(SIGHUP, on_quit, NULL);   // the SSH session went away
+    g_unix_signal_add(SIGTERM, on_quit, NULL);
+    g_idle_add(on_first_frame, NULL);
+    g_main_loop_run(loop);
+
+    // Cancels a solution still streaming; it is no longer the shown one, so
+    // its completion does not draw (and bring curses back) after endwin
+    solution = NULL;
+    request_engine_free(engine);
+    endwin();
+    if (engine) {
+        request_template_free(&request_template);
+        curl_global_cleanup();
+    }
+    print_summary();
+    attempt_log_close(attempt_log);
+    if (question_bank) question_bank_close(question_bank);
+    g_string_free(solution_text, TRUE);
+    g_main_loop_unref(loop);
+    startup_print(startup, stderr);
+    startup_free(startup);
+    return 0;
+}
+
+// Answer history, opened on first use: replaying it is the slowest part of
+// startup, so it waits for the first frame unless an answer comes in sooner
+AttemptLog* history(void) {
+    if (history_opened) return attempt_log;
+    history_opened = TRUE;
+    guint phase = startup_begin(startup, "history");
+    attempt_log = speedmath_open_history();
+    startup_end(startup, phase, attempt_log != NULL);
+    return attempt_log;
+}
+
+// curl, the request engine and the request template, on first need
+gboolean start_network(void) {
+    if (engine) return TRUE;
+    if (offline) return FALSE;
+    if (speedmath_api_init(&api) && curl_global_init(CURL_GLOBAL_DEFAULT) == CURLE_OK) {
+        RequestOptions options;
+        speedmath_request_options(&options);
+        request_template_init(&request_template, &options);
+        engine = request_engine_new();
+    }
+    if (!engine) offline = TRUE;
+    return engine != NULL;
+}
+
+// Put a new question on screen: a past paper's from the bank when there is
+// one for the topic, else a generated one
+void next_question(void) {
+    gboolean found = FALSE;
+    if (question_bank && topic == QUESTION_GEN_ANY_TOPIC && !difficulty) {
+        found = question_bank_get(question_bank, g_random_int_range(0, question_bank_count(question_bank)), &question);
+    } else if (question_bank) {
+        const uint32_t *ids;
+        uint32_t count = question_bank_find(question_bank, topic == QUESTION_GEN_ANY_TOPIC ? (QuestionTopic)g_random_int_range(0, TOPIC_COUNT) : topic,
+                                            difficulty ? difficulty : g_random_int_range(1, 4), 0, 0, &ids);
+        found = count && question_bank_get(question_bank, ids[g_random_int_range(0, count)], &question);
+    }
+    if (!found) question_gen_next(&question_gen, topic, difficulty, &question);
+    answer_len = 0;
+    answer[0] = '\0';
+    question_timer_start(&question_timer);
+}
+
+// Grade input against the question on screen. The feedback and the next
+// question are drawn together, so there is a single refresh per answer.
+void grade(const char *input) {
+    gint64 start = timer_now_us();
+    AnswerGrade grade = answer_check(&question, input, answer_tolerance);
+    gint64 elapsed = timer_now_us() - start;
+    if (grade == GRADE_INVALID) {
+        snprintf(result[0], sizeof(result[0]), "Could not read \"%s\" as an answer.", input);
+        result[1][0] = result[2][0] = '\0';
+        result_pair = PAIR_WRONG;
+        answer_len = 0;
+        answer[0] = '\0';
+        return;
+    }
+
+    gboolean correct = grade == GRADE_CORRECT;
+    double seconds = question_timer_stop(&question_timer) / 1e6;
+    session_stats_record(&session_stats, question.topic, seconds, correct);
+    answered++;
+    streak = correct ? streak + 1 : 0;
+    if (streak > best_streak) best_streak = streak;
+
+    char history_text[64] = "";
+    AttemptLog *log = history();
+    if (log) {
+        AttemptSummary seen;
+        if (attempt_log_summary(log, attempt_question_id(&question), &seen))
+            snprintf(history_text, sizeof(history_text), " | seen %u time(s), %u correct", seen.attempts, seen.correct);
+        Attempt attempt;
+        attempt_init(&attempt, &question, input, grade, &question_timer);
+        attempt_log_append(log, &attempt);
+    }
+
+    char total[32], topic_stats[160];
+    timer_format(question_timer_elapsed(&question_timer), total, sizeof(total));
+    stream_stats_format(&session_stats.topic[question.topic], topic_stats, sizeof(topic_stats));
+    snprintf(result[0], sizeof(result[0]), "%s %c) %s in %s (read %.2f s, type %.2f s, graded in %" G_GINT64_FORMAT " µs)",
+             correct ? "Correct!" : "Wrong, it was", 'A' + question.correct_option, question.options[question.correct_option],
+             total, question_timer_phase(&question_timer, TIMER_PHASE_READ) / 1e6,
+             question_timer_phase(&question_timer, TIMER_PHASE_TYPE) / 1e6, elapsed);
+    snprintf(result[1], sizeof(result[1]), "%s: %s%s", question_topic_name(question.topic), topic_stats, history_text);
+    snprintf(result[2], sizeof(result[2]), "Press s for the solution of: %.100s", question.question);
+    result_pair = correct ? PAIR_CORRECT : PAIR_WRONG;
+
+    last_question = question;
+    have_last = TRUE;
+    if (answer_limit && answered >= answer_limit) {
+        g_main_loop_quit(loop);
+        return;
+    }
+    next_question();
+}
+
+// One key. There is no answer box to focus, so reading runs until the first
+// keystroke and an option letter is graded as it is pressed.
+void handle_key(int key) {
+    switch (key) {
+    case 'q': case 'Q': case 3: case 4:   // Ctrl-C, Ctrl-D
+        g_main_loop_quit(loop);
+        return;
+    case '\t': case 'n':
+        next_question();
+        return;
+    case 't':
+        topic = topic == QUESTION_GEN_ANY_TOPIC ? 0 : topic + 1;
+        next_question();
+        return;
+    case 's':
+        request_solution();
+        return;
+    case 27:   // Esc
+        answer_len = 0;
+        answer[0] = '\0';
+        return;
+    case KEY_BACKSPACE: case 127: case 8:
+        if (answer_len) answer[--answer_len] = '\0';
+        return;
+    case '\r': case '\n': case KEY_ENTER:
+        if (answer_len) grade(answer);
+        return;
+    case KEY_RESIZE:
+        layout();
+        return;
+    }
+    if (!answer_len && ((key >= 'a' && key <= 'd') || (key >= 'A' && key <= 'D'))) {
+        char option[2] = { (char)key, '\0' };
+        grade(option);
+        return;
+    }
+    if (((key >= '0' && key <= '9') || strchr(".,/-%", key) || (key == ' ' && answer_len)) && key &&
+        answer_len + 1 < sizeof(answer)) {
+        question_timer_advance(&question_timer, TIMER_PHASE_TYPE);
+        answer[answer_len++] = (char)key;
+        answer[answer_len] = '\0';
+    }
+}
+
+// Every key waiting is handled before one refresh, so typing ahead over a
+// slow link costs one screen update, not one per key
+gboolean on_input(GIOChannel *channel, GIOCondition condition, gpointer data) {
+    gint64 key_us = timer_now_us();
+    int answered_before = answered;
+    int key;
+    while ((key = wgetch(drill_win)) != ERR) handle_key(key);
+    if (condition & (G_IO_HUP | G_IO_ERR)) g_main_loop_quit(loop);
+    draw_status();
+    draw_drill();
+    doupdate();
+    if (answered != answered_before) {
+        gint64 feedback = timer_now_us() - key_us;
+        feedback_total_us += feedback;
+        feedback_count++;
+        if (feedback > feedback_worst_us) feedback_worst_us = feedback;
+    }
+    return G_SOURCE_CONTINUE;
+}
+
+// Clock in the status bar; curses sends only the characters that changed
+gboolean on_timer(gpointer data) {
+    draw_status();
+    wnoutrefresh(drill_win);
+    doupdate();
+    return G_SOURCE_CONTINUE;
+}
+
+// The first question is on screen: now the history can be replayed
+gboolean on_first_frame(gpointer data) {
+    if (exit_after_first_frame) {
+        g_main_loop_quit(loop);
+        return G_SOURCE_REMOVE;
+    }
+    history();
+    return G_SOURCE_REMOVE;
+}
+
+gboolean on_resize(gpointer data) {
+    struct winsize size;
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &size) == 0) resizeterm(size.ws_row, size.ws_col);
+    layout();
+    doupdate();
+    return G_SOURCE_CONTINUE;
+}
+
+gboolean on_quit(gpointer data) {
+    g_main_loop_quit(loop);
+    return G_SOURCE_CONTINUE;
+}
+
+// Ask Gemini to explain the question just answered (or the one on screen);
+// the reply streams into the lower part of the screen
+void request_solution(void) {
+    const Question *q = have_last ? &last_question : &question;
+    if (!start_network()) {
+        werase(solution_win);
+        waddstr(solution_win, "Offline: step-by-step solutions need an API key.");
+        wnoutrefresh(solution_win);
+        return;
+    }
+    if (solution) request_engine_cancel(engine, solution->id);
+
+    char *query = g_strdup_printf("Give a stepwise complete solution, using the fastest exam shortcut, for: %s Options: A) %s, B) %s, C) %s, D) %s. The correct answer is %c.",
+                                  q->question, q->options[0], q->options[1], q->options[2], q->options[3], 'A' + q->correct_option);
+    RequestBody request;
+    request_body_init(&request);
+    size_t len = 0;
+    char *data = request_body_build(&request, &request_template, query) ? request_body_steal(&request, &len) : NULL;
+    request_body_free(&request);
+    g_free(query);
+    if (!data) return;
+    GBytes *body = g_bytes_new_with_free_func(data, len, free, data);
+
+    char url[512];
+    speedmath_api_url(&api, TRUE, url, sizeof(url));
+    SpeedmathHeaders headers;
+
+    Solution *next = g_new0(Solution, 1);
+    gemini_stream_init(&next->parser, on_solution_text, next);
+    markdown_init(&next->markdown, on_span, solution_win);
+    next->id = request_engine_post_bytes(engine, url, body, speedmath_api_headers(&api, &headers), on_solution_data, on_solution_done, next);
+    g_bytes_unref(body);
+    if (!next->id) {
+        gemini_stream_free(&next->parser);
+        g_free(next);
+        return;
+    }
+    solution = next;
+    solution_done = FALSE;
+    g_string_truncate(solution_text, 0);
+    snprintf(solution_title, sizeof(solution_title), "Solution: %s", q->question);
+    draw_solution();
+    wnoutrefresh(solution_win);
+}
+
+// Candidate text as it is decoded; the spans go straight to the window
+void on_solution_text(const char *text, size_t len, void *data) {
+    Solution *reply = data;
+    if (reply != solution) return;
+    g_string_append_len(solution_text, text, len);
+    markdown_feed(&reply->markdown, text, len);
+}
+
+void on_solution_data(guint id, const char *data, size_t len, gpointer user_data) {
+    Solution *reply = user_data;
+    gemini_stream_feed(&reply->parser, data, len);
+    if (reply == solution) {
+        wnoutrefresh(solution_win);
+        doupdate();
+    }
+}
+
+void on_solution_done(guint id, CURLcode result, long http_status, const char *body, size_t body_len, gpointer data) {
+    Solution *reply = data;
+    gboolean current = reply == solution;
+    gemini_stream_finish(&reply->parser);
+    if (current) {
+        markdown_finish(&reply->markdown);
+        const GeminiJson *json = &reply->parser.json;
+        char problem[400] = "";
+        if (result != CURLE_OK)
+            snprintf(problem, sizeof(problem), "Request failed: %s", curl_easy_strerror(result));
+        else if (json->error_message[0])
+            snprintf(problem, sizeof(problem), "Gemini error %d (%s): %s", json->error_code, json->error_status, json->error_message);
+        else if (json->block_reason[0])
+            snprintf(problem, sizeof(problem), "Gemini blocked the prompt: %s", json->block_reason);
+        else if (http_status >= 400)
+            snprintf(problem, sizeof(problem), "Gemini returned HTTP %ld", http_status);
+        if (problem[0] && result != CURLE_ABORTED_BY_CALLBACK) {
+            g_string_append_printf(solution_text, "\n%s", problem);
+            waddstr(solution_win, "\n");
+            wattron(solution_win, COLOR_PAIR(PAIR_WRONG));
+            waddstr(solution_win, problem);
+            wattroff(solution_win, COLOR_PAIR(PAIR_WRONG));
+        }
+        solution = NULL;
+        solution_done = TRUE;
+        wnoutrefresh(solution_win);
+        doupdate();
+    }
+    gemini_stream_free(&reply->parser);
+    g_free(reply);
+}
+
+// Superscript characters that have a Unicode form; the rest stay on the line
+static const char* superscript(char c) {
+    static const char *const digits[] = { "⁰", "¹", "²", "³", "⁴", "⁵", "⁶", "⁷", "⁸", "⁹" };
+    if (c >= '0' && c <= '9') return digits[c - '0'];
+    switch (c) {
+    case '+': return "⁺";
+    case '-': return "⁻";
+    case '(': return "⁽";
+    case ')': return "⁾";
+    case 'n': return "ⁿ";
+    }
+    return NULL;
+}
+
+// Columns a UTF-8 run takes, assuming one per character
+static int text_width(const char *text, size_t len) {
+    int width = 0;
+    for (size_t i = 0; i < len; i++) width += ((unsigned char)text[i] & 0xC0) != 0x80;
+    return width;
+}
+
+// MarkdownSpanFunc: add a styled span to the window, wrapping at spaces
+void on_span(const char *text, size_t len, unsigned style, void *data) {
+    WINDOW *win = data;
+    attr_t attr = 0;
+    if (style & (MARKDOWN_BOLD | MARKDOWN_HEADING | MARKDOWN_BULLET)) attr |= A_BOLD;
+    if (style & MARKDOWN_ITALIC) attr |= A_UNDERLINE;
+    if (style & MARKDOWN_CODE) attr |= COLOR_PAIR(PAIR_CODE);
+    else if (style & MARKDOWN_MATH) attr |= COLOR_PAIR(PAIR_MATH);
+    wattron(win, attr);
+    int cols = getmaxx(win);
+    size_t i = 0;
+    while (i < len) {
+        if (text[i] == '\n') {
+            waddch(win, '\n');
+            i++;
+        } else if (text[i] == ' ') {
+            if (getcurx(win) > 0) waddch(win, ' ');
+            i++;
+        } else {
+            size_t end = i;
+            while (end < len && text[end] != ' ' && text[end] != '\n') end++;
+            int width = text_width(text + i, end - i);
+            if (getcurx(win) > 0 && getcurx(win) + width > cols) waddch(win, '\n');
+            for (; (style & MARKDOWN_SUPERSCRIPT) && i < end; i++) {
+                const char *sup = superscript(text[i]);
+                if (sup) waddstr(win, sup);
+                else waddnstr(win, text + i, 1);
+            }
+            if (i < end) waddnstr(win, text + i, (int)(end - i));
+            i = end;
+        }
+    }
+    wattroff(win, attr);
+}
+
+// Windows for the current terminal size
+void layout(void) {
+    if (drill_win) delwin(drill_win);
+    if (solution_win) delwin(solution_win);
+    if (help_win) delwin(help_win);
+    int drill_rows = MIN(DRILL_ROWS, MAX(LINES - 1, 1));
+    drill_win = newwin(drill_rows, COLS, 0, 0);
+    solution_win = newwin(MAX(LINES - drill_rows - 1, 1), COLS, drill_rows, 0);
+    help_win = newwin(1, COLS, LINES - 1, 0);
+    keypad(drill_win, TRUE);
+    nodelay(drill_win, TRUE);
+    scrollok(solution_win, TRUE);
+    leaveok(solution_win, TRUE);
+    leaveok(help_win, TRUE);
+    draw_status();
+    draw_drill();
+    draw_solution();
+    draw_help();
+}
+
+// Top line: topic, score and the running clock
+void draw_status(void) {
+    char clock[32];
+    size_t n = timer_format(question_timer_elapsed(&question_timer), clock, sizeof(clock));
+    if (n) clock[n - 1] = '\0';   // tenths
+    int correct = (int)session_stats.correct;
+    int y, x;
+    getyx(drill_win, y, x);   // the cursor stays at the answer
+    wattron(drill_win, A_REVERSE);
+    mvwhline(drill_win, 0, 0, ' ', getmaxx(drill_win));
+    mvwprintw(drill_win, 0, 1, "SpeedMath drill | %s%s | %d/%d correct | streak %d | %s",
+              question_topic_name(topic), difficulty ? (difficulty == 1 ? " (easy)" : difficulty == 2 ? " (medium)" : " (hard)") : "",
+              correct, answered, streak, clock);
+    wattroff(drill_win, A_REVERSE);
+    wmove(drill_win, y, x);
+    wnoutrefresh(drill_win);
+}
+
+// Question, the answer being typed and the feedback on the last one
+void draw_drill(void) {
+    char text[512];
+    question_format(&question, text, sizeof(text));
+    wmove(drill_win, 1, 0);
+    wclrtobot(drill_win);
+    mvwaddstr(drill_win, 2, 0, text);
+    int row = getcury(drill_win) + 2;
+    int rows = getmaxy(drill_win);
+    for (int i = 0; i < 3 && row + 2 + i < rows; i++) {
+        if (!result[i][0]) continue;
+        if (i == 0 && result_pair) wattron(drill_win, COLOR_PAIR(result_pair) | A_BOLD);
+        mvwaddnstr(drill_win, row + 2 + i, 0, result[i], getmaxx(drill_win));
+        if (i == 0 && result_pair) wattroff(drill_win, COLOR_PAIR(result_pair) | A_BOLD);
+    }
+    if (row < rows) mvwprintw(drill_win, row, 0, "> %s", answer);
+    wnoutrefresh(drill_win);
+}
+
+// Title and the reply so far, parsed again from its markdown (a resize)
+void draw_solution(void) {
+    werase(solution_win);
+    if (!solution_title[0]) return;
+    wattron(solution_win, A_BOLD);
+    wmove(solution_win, 0, 0);
+    on_span(solution_title, strlen(solution_title), 0, solution_win);
+    wattroff(solution_win, A_BOLD);
+    waddstr(solution_win, "\n\n");
+    MarkdownParser markdown;
+    markdown_init(&markdown, on_span, solution_win);
+    markdown_feed(&markdown, solution_text->str, solution_text->len);
+    // While the reply streams, the live parser holds back the same bytes
+    if (solution_done) markdown_finish(&markdown);
+    if (solution) solution->markdown.user_data = solution_win;
+}
+
+void draw_help(void) {
+    werase(help_win);
+    wattron(help_win, A_DIM);
+    mvwaddnstr(help_win, 0, 0, "A-D answer | digits + Enter | Tab skip | s solution | t topic | Esc clear | q quit",
+               getmaxx(help_win));
+    wattroff(help_win, A_DIM);
+    wnoutrefresh(help_win);
+}
+
+// After the terminal is restored: the session in numbers
+void print_summary(void) {
+    char line[160];
+    if (!answered) return;
+    printf("Answered %d, %d correct (%.0f%%), best streak %d\n", answered, (int)session_stats.correct,
+           100.0 * session_stats.correct / answered, best_streak);
+    stream_stats_format(&session_stats.all, line, sizeof(line));
+    printf("All topics: %s\n", line);
+    for (int t = 0; t < TOPIC_COUNT; t++) {
+        if (!session_stats.topic[t].count) continue;
+        stream_stats_format(&session_stats.topic[t], line, sizeof(line));
+        printf("%s: %s\n", question_topic_name(t), line);
+    }
+    if (feedback_count)
+        printf("Keypress to feedback on screen: %.0f µs average, %" G_GINT64_FORMAT " µs worst\n",
+               (double)feedback_total_us / feedback_count, feedback_worst_us);
+}
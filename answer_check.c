@@ -0,0 +1,190 @@
+#include <ctype.h>
+#include <string.h>
+#include "answer_check.h"
+
+typedef __int128 wide;
+
+#define MAX_DIGITS 18   // keeps every parsed numerator and denominator in a long long
+
+static wide wide_abs(wide v) {
+    return v < 0 ? -v : v;
+}
+
+static wide wide_gcd(wide a, wide b) {
+    a = wide_abs(a);
+    b = wide_abs(b);
+    while (b) { wide r = a % b; a = b; b = r; }
+    return a;
+}
+
+// Reduce num/den into out; fails if the result does not fit a long long
+static int make_rational(wide num, wide den, Rational *out) {
+    if (den == 0) return 0;
+    if (den < 0) { num = -num; den = -den; }
+    wide g = wide_gcd(num, den);
+    if (g > 1) { num /= g; den /= g; }
+    if (num > (wide)__LONG_LONG_MAX__ || num < -(wide)__LONG_LONG_MAX__ || den > (wide)__LONG_LONG_MAX__)
+        return 0;
+    out->num = (long long)num;
+    out->den = (long long)den;
+    return 1;
+}
+
+static const char* skip_spaces(const char *p) {
+    while (*p && isspace((unsigned char)*p)) p++;
+    return p;
+}
+
+// Digits with optional thousands separators and decimal part: value = num/den
+static const char* parse_decimal(const char *p, wide *num, wide *den) {
+    int digits = 0, seen_digit = 0;
+    *num = 0;
+    *den = 1;
+    for (;; p++) {
+        if (isdigit((unsigned char)*p)) {
+            if (++digits > MAX_DIGITS) return NULL;
+            *num = *num * 10 + (*p - '0');
+            seen_digit = 1;
+        } else if (*p == ',' && seen_digit && isdigit((unsigned char)p[1])) {
+            continue;
+        } else {
+            break;
+        }
+    }
+    if (*p == '.') {
+        for (p++; isdigit((unsigned char)*p); p++) {
+            if (++digits > MAX_DIGITS) return NULL;
+            *num = *num * 10 + (*p - '0');
+            *den *= 10;
+            seen_digit = 1;
+        }
+    }
+    return seen_digit ? p : NULL;
+}
+
+int answer_parse_number(const char *input, Rational *out, int *is_percent) {
+    const char *p = skip_spaces(input);
+    int negative = 0;
+    if (*p == '-' || *p == '+') {
+        negative = *p == '-';
+        p = skip_spaces(p + 1);
+    }
+
+    wide num, den;
+    p = parse_decimal(p, &num, &den);
+    if (!p) return 0;
+
+    const char *after = skip_spaces(p);
+    if (*after == '/') {
+        // a/b
+        wide dnum, dden;
+        p = parse_decimal(skip_spaces(after + 1), &dnum, &dden);
+        if (!p || dnum == 0) return 0;
+        num *= dden;
+        den *= dnum;
+    } else if (den == 1 && after != p && isdigit((unsigned char)*after)) {
+        // mixed number "1 1/2"
+        wide fnum, fden, dnum, dden;
+        const char *q = parse_decimal(after, &fnum, &fden);
+        if (!q || fden != 1) return 0;
+        q = skip_spaces(q);
+        if (*q != '/') return 0;
+        q = parse_decimal(skip_spaces(q + 1), &dnum, &dden);
+        if (!q || dnum == 0 || dden != 1) return 0;
+        num = num * dnum + fnum;
+        den = dnum;
+        p = q;
+    }
+
+    p = skip_spaces(p);
+    int percent = 0;
+    if (*p == '%') {
+        percent = 1;
+        p = skip_spaces(p + 1);
+    }
+    if (*p) return 0;
+
+    if (is_percent) *is_percent = percent;
+    if (percent) den *= 100;
+    return make_rational(negative ? -num : num, den, out);
+}
+
+int answer_parse_option(const char *input) {
+    const char *p = skip_spaces(input);
+    if (*p == '(') p++;
+    char letter = (char)toupper((unsigned char)*p);
+    if (letter < 'A' || letter >= 'A' + QUESTION_OPTION_COUNT) return -1;
+    p++;
+    if (*p == ')' || *p == '.') p++;
+    return *skip_spaces(p) ? -1 : letter - 'A';
+}
+
+static int rational_equal(Rational a, wide num, wide den) {
+    return (wide)a.num * den == num * (wide)a.den;
+}
+
+// |a - b| <= tolerance_ppm / 1e6 * |b|, evaluated exactly
+static int within_tolerance(Rational a, Rational b, long long tolerance_ppm) {
+    wide diff = (wide)a.num * b.den - (wide)b.num * a.den;   // (a - b) * a.den * b.den
+    wide bound = wide_abs((wide)b.num) * a.den;               // |b| * a.den * b.den / b.den
+    if (wide_abs(diff) > ((wide)1 << 100) || bound > ((wide)1 << 100))
+        return (long double)wide_abs(diff) * 1e6L <= (long double)bound * tolerance_ppm;
+    return wide_abs(diff) * 1000000 <= bound * tolerance_ppm;
+}
+
+static long double option_distance(const Question *q, int i, long double value) {
+    Rational option;
+    int option_percent;
+    if (!answer_parse_number(q->options[i], &option, &option_percent)) return -1;
+    long double distance = (long double)option.num / option.den - value;
+    return distance < 0 ? -distance : distance;
+}
+
+// Whether another option is strictly nearer to value than the correct one
+static int nearer_distractor(const Question *q, Rational value) {
+    long double v = (long double)value.num / value.den;
+    long double correct = option_distance(q, q->correct_option, v);
+    if (correct < 0) return 0;
+    for (int i = 0; i < QUESTION_OPTION_COUNT; i++) {
+        long double distance = option_distance(q, i, v);
+        if (i != q->correct_option && distance >= 0 && distance < correct) return 1;
+    }
+    return 0;
+}
+
+AnswerGrade answer_check(const Question *q, const char *input, double tolerance_percent) {
+    int option = answer_parse_option(input);
+    if (option >= 0)
+        return option == q->correct_option ? GRADE_CORRECT : GRADE_WRONG;
+
+    Rational value;
+    int percent = 0;
+    if (!answer_parse_number(input, &value, &percent))
+        return GRADE_INVALID;
+
+    // Read "x%" as a plain x as well, since answers carry no units
+    Rational candidates[2] = { value, value };
+    int count = 1;
+    if (percent && make_rational((wide)value.num * 100, value.den, &candidates[1]))
+        count = 2;
+
+    Rational answer = { q->answer_num, q->answer_den };
+    for (int i = 0; i < count; i++) {
+        if (rational_equal(candidates[i], answer.num, answer.den))
+            return GRADE_CORRECT;
+        if (!q->approximate) continue;
+
+        // A typed estimate stands for the option it is nearest to, as a
+        // letter would: a distractor's value is wrong even within tolerance
+        if (nearer_distractor(q, candidates[i])) continue;
+        Rational shown;
+        int shown_percent;
+        if (answer_parse_number(q->options[q->correct_option], &shown, &shown_percent) &&
+            rational_equal(candidates[i], shown.num, shown.den))
+            return GRADE_CORRECT;
+        long long tolerance_ppm = (long long)(tolerance_percent * 10000.0 + 0.5);
+        if (within_tolerance(candidates[i], answer, tolerance_ppm))
+            return GRADE_CORRECT;
+    }
+    return GRADE_WRONG;
+}
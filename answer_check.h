@@ -0,0 +1,35 @@
+// answer_check.h
+#ifndef ANSWER_CHECK_H
+#define ANSWER_CHECK_H
+
+#include "question.h"
+
+#define ANSWER_CHECK_DEFAULT_TOLERANCE 2.0   // percent, approximation questions only
+
+// Exact rational number; den > 0 and num/den is fully reduced
+typedef struct {
+    long long num;
+    long long den;
+} Rational;
+
+typedef enum {
+    GRADE_INVALID,    // input could not be read as a number or option letter
+    GRADE_WRONG,
+    GRADE_CORRECT
+} AnswerGrade;
+
+// Parse "42", "-1,250", "12.75", "3/4", "1 1/2", "12.5%" (as 12.5/100).
+// Returns 0 on malformed input or overflow.
+int answer_parse_number(const char *input, Rational *out, int *is_percent);
+
+// Option letter "B", "b)", "(c)" -> 0-based index, or -1
+int answer_parse_option(const char *input);
+
+// Grade input against the stored answer. Option letters must match the
+// correct option; numbers must match exactly, or for approximation
+// questions be no farther from the correct option than from any other,
+// and within tolerance_percent of the exact value (or equal the correct
+// option). "x%" is accepted as either x or x/100.
+AnswerGrade answer_check(const Question *q, const char *input, double tolerance_percent);
+
+#endif
@@ -0,0 +1,565 @@
+#define _GNU_SOURCE   // fdatasync, pthread_condattr_setclock
+#include <errno.h>
+#include <fcntl.h>
+#include <libgen.h>
+#include <pthread.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "attempt_log.h"
+#include "crc32.h"
+
+#define FRAME_HEADER 8   // uint32_t length, uint32_t crc
+#define ATTEMPT_FIXED offsetof(Attempt, answer)
+
+typedef struct {
+    unsigned char *data;
+    size_t size;
+    size_t capacity;
+} FrameBuffer;
+
+struct AttemptLog {
+    char *path;
+    char *snapshot_path;
+    int fd;
+    pthread_t writer;
+
+    pthread_mutex_t lock;      // guards everything below
+    pthread_cond_t wake;       // writer: work arrived
+    pthread_cond_t done;       // flushers: a batch reached the disk
+    FrameBuffer pending;       // encoded frames not yet written
+    size_t pending_count;
+    uint64_t appended;         // attempts appended since open
+    uint64_t durable;          // of those, how many are on disk
+    int flush_waiters;
+    int compact_requested;
+    int stopping;
+    int failed;                // a write or sync failed; later batches are still tried
+    uint64_t generation;
+    size_t log_bytes;          // size of the log file
+
+    // Whole history: snapshot + log + pending
+    SessionStats stats;
+    uint64_t attempts;
+    AttemptSummary *summaries; // open addressing on question_id (0 = empty)
+    size_t summary_capacity;   // power of two
+    size_t summary_count;
+};
+
+uint64_t attempt_question_id(const Question *q) {
+    uint64_t h = 14695981039346656037ull;   // FNV-1a over topic and text
+    h = (h ^ (uint64_t)q->topic) * 1099511628211ull;
+    for (const char *p = q->question; *p; p++) h = (h ^ (unsigned char)*p) * 1099511628211ull;
+    return h ? h : 1;
+}
+
+void attempt_init(Attempt *attempt, const Question *q, const char *answer, AnswerGrade grade,
+                  const QuestionTimer *timer) {
+    memset(attempt, 0, sizeof(*attempt));
+    attempt->question_id = attempt_question_id(q);
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    attempt->when = (int64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+    for (int p = 0; p < TIMER_PHASE_COUNT; p++)
+        attempt->phase_us[p] = question_timer_phase(timer, (TimerPhase)p);
+    attempt->topic = (uint8_t)q->topic;
+    attempt->grade = (uint8_t)grade;
+    size_t len = answer ? strlen(answer) : 0;
+    if (len > ATTEMPT_ANSWER_LENGTH) len = ATTEMPT_ANSWER_LENGTH;
+    memcpy(attempt->answer, answer ? answer : "", len);
+    attempt->answer_length = (uint8_t)len;
+}
+
+// --- In-memory history ---
+
+static AttemptSummary* summary_slot(AttemptSummary *slots, size_t capacity, uint64_t id) {
+    size_t mask = capacity - 1;
+    for (size_t i = (size_t)(id ^ id >> 32) & mask;; i = (i + 1) & mask)
+        if (!slots[i].question_id || slots[i].question_id == id) return &slots[i];
+}
+
+static int summaries_reserve(AttemptLog *log, size_t count) {
+    if ((count + 1) * 2 <= log->summary_capacity) return 1;
+    size_t capacity = log->summary_capacity ? log->summary_capacity : 64;
+    while ((count + 1) * 2 > capacity) capacity *= 2;
+    AttemptSummary *slots = calloc(capacity, sizeof(AttemptSummary));
+    if (!slots) return 0;
+    for (size_t i = 0; i < log->summary_capacity; i++)
+        if (log->summaries[i].question_id)
+            *summary_slot(slots, capacity, log->summaries[i].question_id) = log->summaries[i];
+    free(log->summaries);
+    log->summaries = slots;
+    log->summary_capacity = capacity;
+    return 1;
+}
+
+static int64_t attempt_total_us(const Attempt *attempt) {
+    int64_t total = 0;
+    for (int p = 0; p < TIMER_PHASE_COUNT; p++) total += attempt->phase_us[p];
+    return total;
+}
+
+static int apply(AttemptLog *log, const Attempt *attempt) {
+    if (!summaries_reserve(log, log->summary_count + 1)) return 0;
+    int64_t total = attempt_total_us(attempt);
+    int correct = attempt->grade == GRADE_CORRECT;
+    session_stats_record(&log->stats, (QuestionTopic)attempt->topic, total / 1e6, correct);
+    log->attempts++;
+
+    AttemptSummary *s = summary_slot(log->summaries, log->summary_capacity, attempt->question_id);
+    if (!s->question_id) {
+        s->question_id = attempt->question_id;
+        log->summary_count++;
+    }
+    s->attempts++;
+    s->correct += correct;
+    if (attempt->when >= s->last_when) {
+        s->last_when = attempt->when;
+        s->last_us = total;
+    }
+    return 1;
+}
+
+// --- Files ---
+
+static int write_all(int fd, const void *data, size_t len) {
+    const unsigned char *p = data;
+    while (len) {
+        ssize_t n = write(fd, p, len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return 0;
+        p += n;
+        len -= (size_t)n;
+    }
+    return 1;
+}
+
+static unsigned char* read_file(const char *path, size_t *size) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return NULL;
+    struct stat st;
+    unsigned char *data = NULL;
+    if (fstat(fd, &st) == 0 && (data = malloc(st.st_size ? (size_t)st.st_size : 1))) {
+        size_t got = 0;
+        while (got < (size_t)st.st_size) {
+            ssize_t n = read(fd, data + got, (size_t)st.st_size - got);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) break;
+            got += (size_t)n;
+        }
+        *size = got;
+    }
+    close(fd);
+    return data;
+}
+
+// Make a rename in path's directory durable
+static void sync_parent(const char *path) {
+    char *copy = strdup(path);
+    if (!copy) return;
+    int fd = open(dirname(copy), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd >= 0) {
+        fsync(fd);
+        close(fd);
+    }
+    free(copy);
+}
+
+static uint32_t log_header_checksum(const AttemptLogHeader *header) {
+    AttemptLogHeader h = *header;
+    h.checksum = 0;
+    return crc32_update(0, &h, sizeof(h));
+}
+
+static uint32_t snapshot_header_checksum(const AttemptSnapshotHeader *header) {
+    return crc32_update(0, header, offsetof(AttemptSnapshotHeader, header_checksum));
+}
+
+// Returns 1 if loaded, 0 if there is no snapshot, -1 if it is unusable
+static int load_snapshot(AttemptLog *log) {
+    size_t size = 0;
+    unsigned char *data = read_file(log->snapshot_path, &size);
+    if (!data) return errno == ENOENT ? 0 : -1;
+
+    int result = -1;
+    AttemptSnapshotHeader h;
+    if (size < sizeof(h)) goto out;
+    memcpy(&h, data, sizeof(h));
+    if (memcmp(h.magic, ATTEMPT_SNAPSHOT_MAGIC, 8) != 0 || h.version != ATTEMPT_LOG_VERSION ||
+        h.stats_size != sizeof(SessionStats) || h.header_checksum != snapshot_header_checksum(&h))
+        goto out;
+    size_t body = size - sizeof(h);
+    if (body < sizeof(SessionStats) || h.summary_count > (body - sizeof(SessionStats)) / sizeof(AttemptSummary) ||
+        body != sizeof(SessionStats) + h.summary_count * sizeof(AttemptSummary) ||
+        crc32_update(0, data + sizeof(h), body) != h.body_checksum)
+        goto out;
+
+    memcpy(&log->stats, data + sizeof(h), sizeof(SessionStats));
+    if (!summaries_reserve(log, (size_t)h.summary_count)) goto out;
+    const AttemptSummary *summaries = (const AttemptSummary *)(data + sizeof(h) + sizeof(SessionStats));
+    for (uint64_t i = 0; i < h.summary_count; i++) {
+        if (!summaries[i].question_id) continue;
+        AttemptSummary *s = summary_slot(log->summaries, log->summary_capacity, summaries[i].question_id);
+        if (!s->question_id) log->summary_count++;
+        *s = summaries[i];
+    }
+    log->attempts = h.attempts;
+    log->generation = h.generation;
+    result = 1;
+out:
+    free(data);
+    return result;
+}
+
+// Write path atomically: to a temporary file, synced, then renamed over it
+static int write_snapshot(const char *path, uint64_t generation, uint64_t attempts,
+                          const SessionStats *stats, const AttemptSummary *summaries, size_t count) {
+    AttemptSnapshotHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, ATTEMPT_SNAPSHOT_MAGIC, 8);
+    h.version = ATTEMPT_LOG_VERSION;
+    h.stats_size = sizeof(SessionStats);
+    h.generation = generation;
+    h.attempts = attempts;
+    h.summary_count = count;
+    h.body_checksum = crc32_update(crc32_update(0, stats, sizeof(*stats)), summaries, count * sizeof(AttemptSummary));
+    h.header_checksum = snapshot_header_checksum(&h);
+
+    size_t len = strlen(path);
+    char *tmp = malloc(len + 5);
+    if (!tmp) return 0;
+    memcpy(tmp, path, len);
+    memcpy(tmp + len, ".tmp", 5);
+    int fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    int ok = fd >= 0 && write_all(fd, &h, sizeof(h)) && write_all(fd, stats, sizeof(*stats)) &&
+             write_all(fd, summaries, count * sizeof(AttemptSummary)) && fsync(fd) == 0;
+    if (fd >= 0) close(fd);
+    ok = ok && rename(tmp, path) == 0;
+    if (!ok) unlink(tmp);
+    free(tmp);
+    return ok;
+}
+
+// A fresh, empty log for generation, swapped in atomically; returns its fd
+static int create_log(const char *path, uint64_t generation) {
+    AttemptLogHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, ATTEMPT_LOG_MAGIC, 8);
+    h.version = ATTEMPT_LOG_VERSION;
+    h.generation = generation;
+    h.checksum = log_header_checksum(&h);
+
+    size_t len = strlen(path);
+    char *tmp = malloc(len + 5);
+    if (!tmp) return -1;
+    memcpy(tmp, path, len);
+    memcpy(tmp + len, ".tmp", 5);
+    int fd = open(tmp, O_RDWR | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0600);
+    int ok = fd >= 0 && write_all(fd, &h, sizeof(h)) && fsync(fd) == 0 && rename(tmp, path) == 0;
+    if (!ok) {
+        if (fd >= 0) close(fd);
+        unlink(tmp);
+        fd = -1;
+    }
+    free(tmp);
+    if (fd >= 0) sync_parent(path);
+    return fd;
+}
+
+// Replay the log on top of the snapshot. Frames after the first bad one are
+// a torn write: the file is cut back to the last good frame.
+static int replay_log(AttemptLog *log) {
+    size_t size = 0;
+    unsigned char *data = read_file(log->path, &size);
+    if (!data && errno != ENOENT) return 0;
+
+    AttemptLogHeader h;
+    int usable = data && size >= sizeof(h);
+    if (usable) {
+        memcpy(&h, data, sizeof(h));
+        usable = memcmp(h.magic, ATTEMPT_LOG_MAGIC, 8) == 0 && h.version == ATTEMPT_LOG_VERSION &&
+                 h.checksum == log_header_checksum(&h);
+    }
+    if (data && size && !usable && memcmp(data, ATTEMPT_LOG_MAGIC, size < 8 ? size : 8) != 0) {
+        free(data);   // something else lives at path; leave it alone
+        return 0;
+    }
+    // Missing, torn during creation, or already folded into the snapshot
+    if (!usable || h.generation < log->generation) {
+        free(data);
+        log->fd = create_log(log->path, log->generation);
+        log->log_bytes = sizeof(AttemptLogHeader);
+        return log->fd >= 0;
+    }
+    log->generation = h.generation;   // newer than the snapshot only if the snapshot was lost
+
+    size_t offset = sizeof(h);
+    while (size - offset >= FRAME_HEADER) {
+        uint32_t length, crc;
+        memcpy(&length, data + offset, 4);
+        memcpy(&crc, data + offset + 4, 4);
+        if (length < ATTEMPT_FIXED || length > sizeof(Attempt) || length > size - offset - FRAME_HEADER) break;
+        const unsigned char *payload = data + offset + FRAME_HEADER;
+        if (crc32_update(0, payload, length) != crc) break;
+        Attempt attempt;
+        memset(&attempt, 0, sizeof(attempt));
+        memcpy(&attempt, payload, length);
+        if (attempt.answer_length != length - ATTEMPT_FIXED) break;
+        if (!apply(log, &attempt)) {
+            free(data);
+            return 0;
+        }
+        offset += FRAME_HEADER + length;
+    }
+    free(data);
+
+    log->fd = open(log->path, O_RDWR | O_APPEND | O_CLOEXEC);
+    if (log->fd < 0) return 0;
+    if (offset < size && (ftruncate(log->fd, (off_t)offset) != 0 || fdatasync(log->fd) != 0)) return 0;
+    log->log_bytes = offset;
+    return 1;
+}
+
+// --- Writer thread ---
+
+static int frames_append(FrameBuffer *buf, const Attempt *attempt) {
+    uint32_t length = (uint32_t)(ATTEMPT_FIXED + attempt->answer_length);
+    size_t need = buf->size + FRAME_HEADER + length;
+    if (need > buf->capacity) {
+        size_t capacity = buf->capacity ? buf->capacity * 2 : 4096;
+        while (capacity < need) capacity *= 2;
+        unsigned char *data = realloc(buf->data, capacity);
+        if (!data) return 0;
+        buf->data = data;
+        buf->capacity = capacity;
+    }
+    uint32_t crc = crc32_update(0, attempt, length);
+    unsigned char *p = buf->data + buf->size;
+    memcpy(p, &length, 4);
+    memcpy(p + 4, &crc, 4);
+    memcpy(p + FRAME_HEADER, attempt, length);
+    buf->size = need;
+    return 1;
+}
+
+static void deadline_after_ms(struct timespec *ts, long ms) {
+    clock_gettime(CLOCK_MONOTONIC, ts);
+    ts->tv_sec += ms / 1000;
+    ts->tv_nsec += (ms % 1000) * 1000000;
+    if (ts->tv_nsec >= 1000000000) {
+        ts->tv_sec++;
+        ts->tv_nsec -= 1000000000;
+    }
+}
+
+// Write the pending frames with one write and one fdatasync. Called and
+// returns with the lock held; drops it for the I/O.
+static void write_batch(AttemptLog *log, FrameBuffer *spare) {
+    FrameBuffer batch = log->pending;
+    log->pending = *spare;
+    log->pending.size = 0;
+    uint64_t target = log->appended;
+    log->pending_count = 0;
+    size_t start = log->log_bytes;
+    pthread_mutex_unlock(&log->lock);
+
+    int ok = write_all(log->fd, batch.data, batch.size) && fdatasync(log->fd) == 0;
+    // Cut off a partial frame, or reloading would stop there and drop later batches
+    int clean = ok || ftruncate(log->fd, (off_t)start) == 0;
+
+    pthread_mutex_lock(&log->lock);
+    if (ok) log->log_bytes = start + batch.size;
+    else log->failed = 1;
+    if (!clean) log->compact_requested = 1;   // rewrite everything from memory instead
+    log->durable = target;   // written or given up on, so flushers do not hang
+    *spare = batch;
+    pthread_cond_broadcast(&log->done);
+}
+
+// Fold the history into a new snapshot and start an empty log. Called with
+// the lock held and nothing pending, so the history matches the files.
+static void compact(AttemptLog *log) {
+    log->compact_requested = 0;
+    size_t count = 0;
+    AttemptSummary *summaries = malloc((log->summary_count ? log->summary_count : 1) * sizeof(AttemptSummary));
+    SessionStats *stats = malloc(sizeof(SessionStats));
+    if (!summaries || !stats) {
+        free(summaries);
+        free(stats);
+        return;
+    }
+    for (size_t i = 0; i < log->summary_capacity; i++)
+        if (log->summaries[i].question_id) summaries[count++] = log->summaries[i];
+    *stats = log->stats;
+    uint64_t attempts = log->attempts, generation = log->generation + 1;
+    pthread_mutex_unlock(&log->lock);
+
+    // The snapshot goes first: if the new log never appears, the old one
+    // has a lower generation and is skipped as already folded in
+    int ok = write_snapshot(log->snapshot_path, generation, attempts, stats, summaries, count);
+    int fd = ok ? create_log(log->path, generation) : -1;
+    free(summaries);
+    free(stats);
+
+    pthread_mutex_lock(&log->lock);
+    if (fd >= 0) {
+        close(log->fd);
+        log->fd = fd;
+        log->generation = generation;
+        log->log_bytes = sizeof(AttemptLogHeader);
+    } else if (ok) {
+        log->failed = 1;   // snapshot written but the log is stale; later writes would be skipped on reload
+    }
+}
+
+static void* writer_main(void *data) {
+    AttemptLog *log = data;
+    FrameBuffer spare = { 0 };
+    pthread_mutex_lock(&log->lock);
+    for (;;) {
+        while (!log->pending_count && !log->stopping && !log->compact_requested)
+            pthread_cond_wait(&log->wake, &log->lock);
+
+        // Let a few more attempts arrive so one fsync covers them all,
+        // unless someone is waiting for the disk
+        if (log->pending_count && !log->stopping && !log->flush_waiters) {
+            struct timespec deadline;
+            deadline_after_ms(&deadline, ATTEMPT_LOG_SYNC_MS);
+            while (log->pending_count < ATTEMPT_LOG_BATCH && !log->stopping && !log->flush_waiters &&
+                   pthread_cond_timedwait(&log->wake, &log->lock, &deadline) != ETIMEDOUT) {}
+        }
+
+        if (log->pending_count) write_batch(log, &spare);
+        if (!log->pending_count && (log->compact_requested || log->log_bytes >= ATTEMPT_LOG_COMPACT_BYTES))
+            compact(log);
+        if (log->stopping && !log->pending_count) break;
+    }
+    pthread_mutex_unlock(&log->lock);
+    free(spare.data);
+    return NULL;
+}
+
+// --- Public API ---
+
+AttemptLog* attempt_log_open(const char *path) {
+    AttemptLog *log = calloc(1, sizeof(AttemptLog));
+    if (!log) return NULL;
+    log->fd = -1;
+    size_t len = strlen(path);
+    log->path = strdup(path);
+    log->snapshot_path = malloc(len + sizeof(".snapshot"));
+    if (!log->path || !log->snapshot_path) goto fail;
+    memcpy(log->snapshot_path, path, len);
+    memcpy(log->snapshot_path + len, ".snapshot", sizeof(".snapshot"));
+
+    session_stats_init(&log->stats);
+    if (load_snapshot(log) < 0 || !replay_log(log)) goto fail;
+
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_mutex_init(&log->lock, NULL);
+    pthread_cond_init(&log->wake, &attr);
+    pthread_cond_init(&log->done, NULL);
+    pthread_condattr_destroy(&attr);
+    if (pthread_create(&log->writer, NULL, writer_main, log) != 0) {
+        pthread_cond_destroy(&log->wake);
+        pthread_cond_destroy(&log->done);
+        pthread_mutex_destroy(&log->lock);
+        goto fail;
+    }
+    return log;
+
+fail:
+    if (log->fd >= 0) close(log->fd);
+    free(log->summaries);
+    free(log->snapshot_path);
+    free(log->path);
+    free(log);
+    return NULL;
+}
+
+void attempt_log_close(AttemptLog *log) {
+    if (!log) return;
+    pthread_mutex_lock(&log->lock);
+    log->stopping = 1;
+    pthread_cond_signal(&log->wake);
+    pthread_mutex_unlock(&log->lock);
+    pthread_join(log->writer, NULL);
+
+    close(log->fd);
+    pthread_cond_destroy(&log->wake);
+    pthread_cond_destroy(&log->done);
+    pthread_mutex_destroy(&log->lock);
+    free(log->pending.data);
+    free(log->summaries);
+    free(log->snapshot_path);
+    free(log->path);
+    free(log);
+}
+
+int attempt_log_append(AttemptLog *log, const Attempt *attempt) {
+    if (attempt->answer_length > ATTEMPT_ANSWER_LENGTH || !attempt->question_id) return 0;
+    pthread_mutex_lock(&log->lock);
+    int ok = frames_append(&log->pending, attempt);
+    if (ok && !apply(log, attempt)) {
+        log->pending.size -= FRAME_HEADER + ATTEMPT_FIXED + attempt->answer_length;
+        ok = 0;
+    }
+    if (ok) {
+        log->pending_count++;
+        log->appended++;
+        if (log->pending_count == 1 || log->pending_count == ATTEMPT_LOG_BATCH)
+            pthread_cond_signal(&log->wake);
+    }
+    pthread_mutex_unlock(&log->lock);
+    return ok;
+}
+
+int attempt_log_flush(AttemptLog *log) {
+    pthread_mutex_lock(&log->lock);
+    uint64_t target = log->appended;
+    log->flush_waiters++;
+    pthread_cond_signal(&log->wake);
+    while (log->durable < target) pthread_cond_wait(&log->done, &log->lock);
+    log->flush_waiters--;
+    int ok = !log->failed;
+    log->failed = 0;
+    pthread_mutex_unlock(&log->lock);
+    return ok;
+}
+
+void attempt_log_compact(AttemptLog *log) {
+    pthread_mutex_lock(&log->lock);
+    log->compact_requested = 1;
+    pthread_cond_signal(&log->wake);
+    pthread_mutex_unlock(&log->lock);
+}
+
+uint64_t attempt_log_count(AttemptLog *log) {
+    pthread_mutex_lock(&log->lock);
+    uint64_t count = log->attempts;
+    pthread_mutex_unlock(&log->lock);
+    return count;
+}
+
+void attempt_log_stats(AttemptLog *log, SessionStats *out) {
+    pthread_mutex_lock(&log->lock);
+    *out = log->stats;
+    pthread_mutex_unlock(&log->lock);
+}
+
+int attempt_log_summary(AttemptLog *log, uint64_t question_id, AttemptSummary *out) {
+    if (!question_id) return 0;
+    pthread_mutex_lock(&log->lock);
+    const AttemptSummary *s = log->summary_capacity
+        ? summary_slot(log->summaries, log->summary_capacity, question_id) : NULL;
+    int found = s && s->question_id;
+    if (found) *out = *s;
+    pthread_mutex_unlock(&log->lock);
+    return found;
+}
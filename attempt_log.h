@@ -0,0 +1,96 @@
+// attempt_log.h
+#ifndef ATTEMPT_LOG_H
+#define ATTEMPT_LOG_H
+
+#include <stdint.h>
+#include "answer_check.h"
+#include "question.h"
+#include "question_timer.h"
+#include "stats.h"
+
+// Every answered question, kept across runs in two files (native byte order):
+//   <path>           append-only log: AttemptLogHeader, then frames of
+//                    uint32_t length, uint32_t crc32(payload), payload
+//                    (an Attempt cut after answer_length bytes of answer)
+//   <path>.snapshot  everything older folded into totals: AttemptSnapshotHeader,
+//                    SessionStats, AttemptSummary[summary_count]
+// Appends are encoded on the caller's thread and written by a background
+// thread that fsyncs once per batch. Once the log passes
+// ATTEMPT_LOG_COMPACT_BYTES it is folded into a new snapshot and restarted.
+// A torn tail (crash mid-write) is cut off on open.
+
+#define ATTEMPT_LOG_MAGIC "SMATLOG1"
+#define ATTEMPT_SNAPSHOT_MAGIC "SMATSNP1"
+#define ATTEMPT_LOG_VERSION 1
+#define ATTEMPT_ANSWER_LENGTH 48
+#define ATTEMPT_LOG_SYNC_MS 500                   // longest an attempt waits for its fsync
+#define ATTEMPT_LOG_BATCH 64                      // or until this many are waiting
+#define ATTEMPT_LOG_COMPACT_BYTES (1024 * 1024)   // ~10k attempts
+
+typedef struct {
+    uint64_t question_id;                 // attempt_question_id()
+    int64_t when;                         // wall clock, µs since the epoch
+    int64_t phase_us[TIMER_PHASE_COUNT];  // read/think/type
+    uint8_t topic;                        // QuestionTopic
+    uint8_t grade;                        // AnswerGrade
+    uint8_t answer_length;
+    uint8_t reserved[5];
+    char answer[ATTEMPT_ANSWER_LENGTH];   // as typed, not NUL-terminated
+} Attempt;
+
+// Per question, over the whole history
+typedef struct {
+    uint64_t question_id;
+    uint32_t attempts;
+    uint32_t correct;
+    int64_t last_when;
+    int64_t last_us;        // time spent on the latest attempt
+} AttemptSummary;
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t checksum;      // over magic, version and generation
+    uint64_t generation;
+} AttemptLogHeader;
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t stats_size;    // sizeof(SessionStats), so layout changes are rejected
+    uint64_t generation;    // the log generation that follows this snapshot
+    uint64_t attempts;
+    uint64_t summary_count;
+    uint32_t body_checksum;
+    uint32_t header_checksum;   // over every field above
+} AttemptSnapshotHeader;
+
+typedef struct AttemptLog AttemptLog;
+
+// Stable id for a question, whether it came from the bank or the generator (never 0)
+uint64_t attempt_question_id(const Question *q);
+
+// Fill an attempt from the question, the answer as typed and the stopped timer
+void attempt_init(Attempt *attempt, const Question *q, const char *answer, AnswerGrade grade,
+                  const QuestionTimer *timer);
+
+// Load the snapshot, replay the log and start the writer. The directory must
+// exist. NULL if the files cannot be read, created or are not attempt logs.
+AttemptLog* attempt_log_open(const char *path);
+// Writes and syncs whatever is still pending, then stops the writer
+void attempt_log_close(AttemptLog *log);
+
+// Queue an attempt; returns at once (the disk is only touched by the writer)
+int attempt_log_append(AttemptLog *log, const Attempt *attempt);
+// Wait until every attempt appended so far is on disk; 0 if a write failed
+// since the last flush
+int attempt_log_flush(AttemptLog *log);
+// Fold the log into the snapshot now instead of waiting for it to grow
+void attempt_log_compact(AttemptLog *log);
+
+// Totals over the whole history, including attempts still being written
+uint64_t attempt_log_count(AttemptLog *log);
+void attempt_log_stats(AttemptLog *log, SessionStats *out);
+int attempt_log_summary(AttemptLog *log, uint64_t question_id, AttemptSummary *out);
+
+#endif
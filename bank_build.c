@@ -0,0 +1,347 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <time.h>
+#include "question_bank.h"
+#include "question_gen.h"
+#include "answer_check.h"
+
+// bank_build: build a memory-mapped question bank from PYQ dumps.
+//
+// Text dumps, one question per line ('#' starts a comment):
+//   topic|year|difficulty|question|A|B|C|D|correct letter|answer[|approx]
+// JSON dumps (.json: an array of objects, .jsonl: one object per line):
+//   {"topic": "Percentage", "year": 2022, "difficulty": 2, "question": "...",
+//    "options": ["..", "..", "..", ".."], "correct": "B", "answer": "162",
+//    "approximate": false}
+
+static int parse_topic(const char *name, QuestionTopic *topic) {
+    if (isdigit((unsigned char)*name)) {
+        int t = atoi(name);
+        if (t < 0 || t >= TOPIC_COUNT) return 0;
+        *topic = (QuestionTopic)t;
+        return 1;
+    }
+    for (int t = 0; t < TOPIC_COUNT; t++) {
+        if (strncasecmp(name, question_topic_name((QuestionTopic)t), 5) == 0) {
+            *topic = (QuestionTopic)t;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Fill in the exact answer (from answer_text, else the correct option) and check the rest
+static int finish_question(Question *q, const char *answer_text, const char *topic_name, const char *where) {
+    if (!parse_topic(topic_name, &q->topic)) {
+        fprintf(stderr, "%s: unknown topic '%s'\n", where, topic_name);
+        return 0;
+    }
+    if (q->difficulty < 1 || q->difficulty > 3) q->difficulty = 2;
+    if (q->correct_option < 0 || q->correct_option >= QUESTION_OPTION_COUNT) {
+        fprintf(stderr, "%s: correct option must be A-D\n", where);
+        return 0;
+    }
+    Rational answer;
+    if (!answer_parse_number(answer_text && *answer_text ? answer_text : q->options[q->correct_option], &answer, NULL)) {
+        fprintf(stderr, "%s: answer is not a number\n", where);
+        return 0;
+    }
+    q->answer_num = answer.num;
+    q->answer_den = answer.den;
+    return 1;
+}
+
+static char* next_field(char **cursor) {
+    char *field = *cursor;
+    if (!field) return "";
+    char *bar = strchr(field, '|');
+    if (bar) { *bar = '\0'; *cursor = bar + 1; } else { *cursor = NULL; }
+    field[strcspn(field, "\r\n")] = '\0';
+    return field;
+}
+
+static int load_text(QuestionBankWriter *writer, FILE *file, const char *path) {
+    char line[4096];
+    int line_no = 0, added = 0;
+    while (fgets(line, sizeof(line), file)) {
+        line_no++;
+        if (line[0] == '#' || line[strspn(line, " \t\r\n")] == '\0') continue;
+
+        char where[512];
+        snprintf(where, sizeof(where), "%s:%d", path, line_no);
+        char *cursor = line;
+        Question q;
+        memset(&q, 0, sizeof(q));
+        const char *topic = next_field(&cursor);
+        snprintf(q.year, sizeof(q.year), "%s", next_field(&cursor));
+        q.difficulty = atoi(next_field(&cursor));
+        const char *text = next_field(&cursor);
+        for (int k = 0; k < QUESTION_OPTION_COUNT; k++)
+            snprintf(q.options[k], sizeof(q.options[k]), "%s", next_field(&cursor));
+        q.correct_option = answer_parse_option(next_field(&cursor));
+        const char *answer = next_field(&cursor);
+        q.approximate = strcasecmp(next_field(&cursor), "approx") == 0;
+
+        if (!finish_question(&q, answer, topic, where)) continue;
+        if (!question_bank_writer_add_text(writer, &q, text)) return -1;
+        added++;
+    }
+    return added;
+}
+
+// Minimal JSON reading for flat question objects
+
+typedef struct {
+    const char *p;
+    const char *end;
+} Json;
+
+static void json_skip(Json *j) {
+    while (j->p < j->end && isspace((unsigned char)*j->p)) j->p++;
+}
+
+// Four hex digits after \u (cursor on the u), or -1
+static long json_hex4(const Json *j) {
+    if (j->end - j->p <= 4) return -1;
+    long cp = 0;
+    for (int i = 1; i <= 4; i++) {
+        if (!isxdigit((unsigned char)j->p[i])) return -1;
+        cp = cp * 16 + (isdigit((unsigned char)j->p[i]) ? j->p[i] - '0' : (tolower((unsigned char)j->p[i]) - 'a' + 10));
+    }
+    return cp;
+}
+
+// Append cp as UTF-8, whole or not at all
+static void put_codepoint(char *out, size_t size, size_t *n, unsigned long cp) {
+    char utf8[4];
+    size_t len = 0;
+    if (cp < 0x80) {
+        utf8[len++] = (char)cp;
+    } else if (cp < 0x800) {
+        utf8[len++] = (char)(0xC0 | (cp >> 6));
+        utf8[len++] = (char)(0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+        utf8[len++] = (char)(0xE0 | (cp >> 12));
+        utf8[len++] = (char)(0x80 | ((cp >> 6) & 0x3F));
+        utf8[len++] = (char)(0x80 | (cp & 0x3F));
+    } else {
+        utf8[len++] = (char)(0xF0 | (cp >> 18));
+        utf8[len++] = (char)(0x80 | ((cp >> 12) & 0x3F));
+        utf8[len++] = (char)(0x80 | ((cp >> 6) & 0x3F));
+        utf8[len++] = (char)(0x80 | (cp & 0x3F));
+    }
+    if (*n + len >= size) return;
+    memcpy(out + *n, utf8, len);
+    *n += len;
+}
+
+// Decode a string (cursor on the opening quote) into out. A surrogate
+// pair becomes one code point; half of one becomes U+FFFD.
+static int json_string(Json *j, char *out, size_t size) {
+    size_t n = 0;
+    if (j->p >= j->end || *j->p != '"') return 0;
+    for (j->p++; j->p < j->end && *j->p != '"'; j->p++) {
+        char c = *j->p;
+        if (c == '\\' && j->p + 1 < j->end) {
+            c = *++j->p;
+            switch (c) {
+            case 'b': c = '\b'; break;
+            case 'f': c = '\f'; break;
+            case 'n': c = '\n'; break;
+            case 'r': c = '\r'; break;
+            case 't': c = '\t'; break;
+            case 'u': {
+                long cp = json_hex4(j);
+                if (cp < 0) {
+                    if (size) out[n] = '\0';
+                    return 0;
+                }
+                j->p += 4;
+                if (cp >= 0xD800 && cp <= 0xDBFF) {
+                    // The low half follows as another \uXXXX; anything else is decoded on its own
+                    Json next = { j->p + 2, j->end };
+                    long low = j->end - j->p > 2 && j->p[1] == '\\' && j->p[2] == 'u' ? json_hex4(&next) : -1;
+                    if (low >= 0xDC00 && low <= 0xDFFF) {
+                        cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                        j->p += 6;
+                    } else {
+                        cp = 0xFFFD;
+                    }
+                } else if (cp >= 0xDC00 && cp <= 0xDFFF) {
+                    cp = 0xFFFD;
+                }
+                put_codepoint(out, size, &n, (unsigned long)cp);
+                continue;
+            }
+            default: break;   // \" \\ \/ stand for themselves
+            }
+        }
+        if (n + 1 < size) out[n++] = c;
+    }
+    if (size) out[n] = '\0';
+    if (j->p >= j->end) return 0;
+    j->p++;
+    return 1;
+}
+
+// A scalar as text: strings are decoded, numbers and literals copied
+static int json_scalar(Json *j, char *out, size_t size) {
+    json_skip(j);
+    if (j->p < j->end && *j->p == '"') return json_string(j, out, size);
+    size_t n = 0;
+    while (j->p < j->end && !strchr(",}] \t\r\n", *j->p)) {
+        if (n + 1 < size) out[n++] = *j->p;
+        j->p++;
+    }
+    if (size) out[n] = '\0';
+    return n > 0;
+}
+
+static int json_expect(Json *j, char c) {
+    json_skip(j);
+    if (j->p < j->end && *j->p == c) { j->p++; return 1; }
+    return 0;
+}
+
+static int json_object(Json *j, Question *q, char *text, size_t text_size, char *topic, char *answer) {
+    char key[32], value[64];
+    if (!json_expect(j, '{')) return 0;
+    if (json_expect(j, '}')) return 1;
+    do {
+        json_skip(j);
+        if (!json_string(j, key, sizeof(key)) || !json_expect(j, ':')) return 0;
+        json_skip(j);
+        if (strcmp(key, "question") == 0) {
+            if (!json_string(j, text, text_size)) return 0;
+        } else if (strcmp(key, "options") == 0) {
+            if (!json_expect(j, '[')) return 0;
+            for (int k = 0; !json_expect(j, ']'); k++) {
+                char option[QUESTION_OPTION_LENGTH];
+                if (!json_scalar(j, option, sizeof(option))) return 0;
+                if (k < QUESTION_OPTION_COUNT) memcpy(q->options[k], option, sizeof(option));
+                json_expect(j, ',');
+            }
+        } else {
+            if (!json_scalar(j, value, sizeof(value))) return 0;
+            if (strcmp(key, "topic") == 0) snprintf(topic, 64, "%s", value);
+            else if (strcmp(key, "year") == 0) snprintf(q->year, sizeof(q->year), "%.9s", value);
+            else if (strcmp(key, "difficulty") == 0) q->difficulty = atoi(value);
+            else if (strcmp(key, "correct") == 0)
+                q->correct_option = isdigit((unsigned char)*value) ? atoi(value) : answer_parse_option(value);
+            else if (strcmp(key, "answer") == 0) snprintf(answer, 64, "%s", value);
+            else if (strcmp(key, "approximate") == 0) q->approximate = strcmp(value, "true") == 0;
+        }
+    } while (json_expect(j, ','));
+    return json_expect(j, '}');
+}
+
+static int load_json(QuestionBankWriter *writer, FILE *file, const char *path) {
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    char *data = malloc(size > 0 ? size : 1);
+    if (!data || fread(data, 1, size, file) != (size_t)size) {
+        free(data);
+        return -1;
+    }
+
+    Json j = { data, data + size };
+    int added = 0, in_array = json_expect(&j, '[');
+    static char text[65536];
+    for (int item = 1;; item++) {
+        json_skip(&j);
+        if (j.p >= j.end || (in_array && *j.p == ']')) break;
+
+        Question q;
+        memset(&q, 0, sizeof(q));
+        q.correct_option = -1;
+        char topic[64] = "", answer[64] = "", where[512];
+        text[0] = '\0';
+        snprintf(where, sizeof(where), "%s: question %d", path, item);
+        if (!json_object(&j, &q, text, sizeof(text), topic, answer)) {
+            fprintf(stderr, "%s: malformed JSON\n", where);
+            break;
+        }
+        json_expect(&j, ',');
+        if (!finish_question(&q, answer, topic, where)) continue;
+        if (!question_bank_writer_add_text(writer, &q, text)) { added = -1; break; }
+        added++;
+    }
+    free(data);
+    return added;
+}
+
+int main(int argc, char *argv[]) {
+    const char *output = "questions.bank";
+    long generate = 0;
+    int verify = 0, inputs = 0;
+
+    QuestionBankWriter *writer = question_bank_writer_new();
+    if (!writer) return 1;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            output = argv[++i];
+        } else if (strcmp(argv[i], "--generate") == 0 && i + 1 < argc) {
+            generate = atol(argv[++i]);
+        } else if (strcmp(argv[i], "--verify") == 0) {
+            verify = 1;
+        } else if (argv[i][0] == '-') {
+            fprintf(stderr, "Usage: %s [-o out.bank] [--generate N] [--verify] [dump.txt|dump.json|dump.jsonl]...\n", argv[0]);
+            return 1;
+        } else {
+            FILE *file = fopen(argv[i], "rb");
+            if (!file) {
+                fprintf(stderr, "Error: Could not open %s\n", argv[i]);
+                return 1;
+            }
+            const char *ext = strrchr(argv[i], '.');
+            int added = ext && (strcmp(ext, ".json") == 0 || strcmp(ext, ".jsonl") == 0)
+                ? load_json(writer, file, argv[i]) : load_text(writer, file, argv[i]);
+            fclose(file);
+            if (added < 0) {
+                fprintf(stderr, "Error: Out of memory reading %s\n", argv[i]);
+                return 1;
+            }
+            printf("%s: %d questions\n", argv[i], added);
+            inputs++;
+        }
+    }
+
+    // Synthetic questions, e.g. for benchmarking large banks
+    if (generate > 0) {
+        QuestionGen gen;
+        question_gen_init(&gen, (unsigned long long)time(NULL));
+        Question q;
+        for (long i = 0; i < generate; i++) {
+            question_gen_next(&gen, QUESTION_GEN_ANY_TOPIC, 0, &q);
+            snprintf(q.year, sizeof(q.year), "%ld", 2010 + i % 15);
+            if (!question_bank_writer_add(writer, &q)) return 1;
+        }
+        printf("generated: %ld questions\n", generate);
+    } else if (!inputs) {
+        fprintf(stderr, "Nothing to build: give PYQ dumps or --generate N\n");
+        return 1;
+    }
+
+    if (!question_bank_writer_finish(writer, output)) return 1;
+    question_bank_writer_free(writer);
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    QuestionBank *bank = question_bank_open(output);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    if (!bank) return 1;
+    printf("Wrote %s: %u questions (opened in %.3f ms)\n", output, question_bank_count(bank),
+           (end.tv_sec - start.tv_sec) * 1e3 + (end.tv_nsec - start.tv_nsec) / 1e6);
+    if (verify) {
+        int ok = question_bank_verify(bank);
+        printf("Checksums: %s\n", ok ? "OK" : "MISMATCH");
+        if (!ok) return 1;
+    }
+    question_bank_close(bank);
+    return 0;
+}
@@ -0,0 +1,609 @@
+// Microbenchmarks of the hot paths, one line per benchmark:
+//   name <TAB> ns/op <TAB> bytes allocated/op <TAB> allocations/op <TAB> noise %
+// ns/op is the fastest of several timed runs of ~50 ms each (the least
+// disturbed by other work), on one pinned CPU; noise is how far the second
+// fastest was from it. The runs go round all the benchmarks in turn, so a
+// slow stretch of a shared or virtual CPU, which can last seconds and cost
+// some workloads 2x, hits one run of many benchmarks rather than every run
+// of one. Whole processes run slower too, by 5-80% for the length of a
+// run, so results are best kept as several runs in one file: a benchmark's
+// fastest counts, and its noise is how far the median run's was from it.
+//   for i in 1 2 3 4 5; do ./bench; done > baseline.tsv
+//   ./bench -b baseline.tsv             measure once and compare
+//   ./bench -b baseline.tsv -a after.tsv   compare saved runs (make compare)
+// Either exits 1 if anything got slower by more than NOISE_FACTOR times the
+// noise of either side (at least MIN_THRESHOLD %), or allocates more; -t
+// sets a fixed percentage instead. With -a given again for a second
+// measurement, it has to be slower in both. A machine that is slower for
+// minutes slows most benchmarks alike, so the median change is taken out
+// first; -t compares plain times, for a change that slows everything alike.
+// Extra arguments pick benchmarks whose name contains one of them.
+#define _GNU_SOURCE
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "../answer_check.h"
+#include "../config.h"
+#include "../env_loader.h"
+#include "../gemini_json.h"
+#include "../gemini_stream.h"
+#include "../markdown.h"
+#include "../question_gen.h"
+#include "../question_select.h"
+#include "../request_body.h"
+#include "../response_buffer.h"
+#include "../stats.h"
+
+#define RUN_NS 50000000L       // length of one timed run
+#define DEFAULT_RUNS 7
+#define NOISE_FACTOR 1.5       // a regression is this many times the noise
+#define MIN_THRESHOLD 3.0      // percent; below this no machine here is steady
+#define MAX_RUNS 32
+#define MAX_BENCHES 64
+#define MAX_AFTER 8            // -a files
+#define MIN_SHIFT_BENCHES 5    // compared, to tell the machine's shift from a regression
+
+// Allocation counting: malloc and friends are wrapped around glibc's own,
+// and counted while a run is being measured
+extern void *__libc_malloc(size_t), *__libc_calloc(size_t, size_t), *__libc_realloc(void*, size_t);
+extern void __libc_free(void*);
+static int counting;
+static unsigned long alloc_count, alloc_bytes;
+
+void* malloc(size_t size) {
+    if (counting) { alloc_count++; alloc_bytes += size; }
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t n, size_t size) {
+    if (counting) { alloc_count++; alloc_bytes += n * size; }
+    return __libc_calloc(n, size);
+}
+
+void* realloc(void *ptr, size_t size) {
+    if (counting) { alloc_count++; alloc_bytes += size; }
+    return __libc_realloc(ptr, size);
+}
+
+void free(void *ptr) {
+    __libc_free(ptr);
+}
+
+static volatile size_t sink;   // results go here so the work is not optimized away
+
+// ---- Inputs, built once
+
+static char reply_json[8192];
+static size_t reply_json_len;
+static char reply_sse[8192];
+static size_t reply_sse_len;
+static char solution_md[4096];   // a step-by-step reply as Gemini formats it
+static size_t solution_md_len;
+static char body_chunk[1024];
+static char env_path[64];
+static Config *config;
+static RequestTemplate request_template;
+static const char *prompt =
+    "give me simplification, approximation and speed math question for preparation practice for Indian banking exam. "
+    "You will give pyq question one question at a time and we will give the answer (give option also and do mention "
+    "that the option could be given wrong). After user sends an answer to you, you will give stepwise complete answer.";
+static Question question;
+static QuestionGen question_gen;
+static SessionStats session_stats;
+static StreamStats solve_times;   // fixed, so quantile cost does not drift with other benchmarks
+
+// A bank-sized selector after a long history of answers, and what a plain
+// scan for the most overdue question would have to go through instead
+#define SELECT_QUESTIONS 1000000
+#define SELECT_ATTEMPTS 100000
+static QuestionSelect *selector;
+static uint8_t *scan_group;
+static uint32_t *scan_due;
+
+// A student slow at one topic and often wrong at another
+static void select_answer(uint32_t id, long i) {
+    QuestionTopic topic = (QuestionTopic)(id % TOPIC_COUNT);
+    double seconds = (topic == TOPIC_SIMPLIFICATION ? 40.0 : 15.0) + (i % 13);
+    question_select_record(selector, id, seconds, topic == TOPIC_PERCENTAGE ? i % 3 != 0 : i % 10 != 0);
+}
+
+static void setup(void) {
+    // A 2 KB reply, whole and as 8 SSE events
+    char text[2049];
+    for (int i = 0; i < 2048; i++) text[i] = "Step 1: 25% of 480 = 120. "[i % 26];
+    text[2048] = '\0';
+    reply_json_len = snprintf(reply_json, sizeof(reply_json),
+                              "{\"candidates\":[{\"content\":{\"parts\":[{\"text\":\"%s\"}],\"role\":\"model\"},"
+                              "\"finishReason\":\"STOP\",\"index\":0}],\"usageMetadata\":{\"promptTokenCount\":130,"
+                              "\"candidatesTokenCount\":512,\"totalTokenCount\":642}}", text);
+    for (int i = 0; i < 8; i++)
+        reply_sse_len += snprintf(reply_sse + reply_sse_len, sizeof(reply_sse) - reply_sse_len,
+                                  "data: {\"candidates\":[{\"content\":{\"parts\":[{\"text\":\"%.256s\"}],"
+                                  "\"role\":\"model\"},\"index\":0}]}\r\n\r\n", text + i * 256);
+    static const char *solution_lines[] = {
+        "**Question:** What is $\\frac{3}{4}$ of 480?\n", "**Options**\n", "- A) 300\n- B) 360\n",
+        "### Solution\n", "1. Step 1: $\\frac{3}{4} \\times 480 = 3 \\times 120 = 360$\n",
+        "2. Step 2: check with *approximation*: 480 \\div 4 = 120, and 2^10 = 1024.\n", "Use `x * 0.75` as a shortcut.\n",
+    };
+    while (solution_md_len < 2048)
+        for (int i = 0; i < 7; i++)
+            solution_md_len += snprintf(solution_md + solution_md_len, sizeof(solution_md) - solution_md_len, "%s",
+                                        solution_lines[i]);
+    memset(body_chunk, 'x', sizeof(body_chunk));
+
+    // A typical .env: a few dozen settings
+    snprintf(env_path, sizeof(env_path), "/tmp/speedmath_bench_%d.env", (int)getpid());
+    FILE *env = fopen(env_path, "w");
+    for (int i = 0; i < 40; i++) fprintf(env, "SPEEDMATH_SETTING_%d=value %d # note\n", i, i);
+    fprintf(env, "GEMINI_API_KEY=\"AIzaSyExampleExampleExampleExample\"\n");
+    fclose(env);
+    const char *paths[] = { env_path };
+    config = config_load(paths, 1);
+    get_env_variable(env_path, "GEMINI_API_KEY");   // parsed on first use
+
+    RequestOptions options = { "You are a speed maths coach for Indian banking exams.", 0.7, 1024 };
+    request_template_init(&request_template, &options);
+    question_gen_init(&question_gen, 42);
+    question_gen_next(&question_gen, TOPIC_PERCENTAGE, 0, &question);
+    session_stats_init(&session_stats);
+    stream_stats_init(&solve_times);
+    for (int i = 0; i < 10000; i++) stream_stats_add(&solve_times, 3.0 + (i * 7919 % 1000) * 0.05);
+
+    selector = question_select_new(SELECT_QUESTIONS, 42);
+    scan_group = malloc(SELECT_QUESTIONS);
+    scan_due = malloc(SELECT_QUESTIONS * sizeof(uint32_t));
+    for (uint32_t id = 0; id < SELECT_QUESTIONS; id++) {
+        int difficulty = 1 + (int)(id / TOPIC_COUNT % 3);
+        question_select_add(selector, id, (QuestionTopic)(id % TOPIC_COUNT), difficulty);
+        scan_group[id] = (uint8_t)(id % TOPIC_COUNT * 3 + difficulty - 1);
+        scan_due[id] = id * 2654435761u >> 8;
+    }
+    for (long i = 0; i < SELECT_ATTEMPTS; i++) {
+        uint32_t id;
+        if (question_select_next(selector, QUESTION_GEN_ANY_TOPIC, 0, &id)) select_answer(id, i);
+    }
+}
+
+static void teardown(void) {
+    config_free(config);
+    request_template_free(&request_template);
+    question_select_free(selector);
+    free(scan_group);
+    free(scan_due);
+    unlink(env_path);
+}
+
+// ---- Benchmarks: each runs its operation n times
+
+static void bench_write_callback(long n) {
+    // A 16 KB body arriving in 1 KB pieces into a recycled buffer, as the engine does
+    static ResponseBuffer buffer;
+    if (!buffer.limit) response_buffer_init(&buffer, RESPONSE_BUFFER_DEFAULT_LIMIT);
+    for (long i = 0; i < n; i++) {
+        response_buffer_reset(&buffer);
+        for (int j = 0; j < 16; j++) sink += response_buffer_write_callback(body_chunk, 1, sizeof(body_chunk), &buffer);
+    }
+}
+
+static void bench_write_callback_fresh(long n) {
+    // The same body into a new buffer each time (first request on a handle)
+    for (long i = 0; i < n; i++) {
+        ResponseBuffer buffer;
+        response_buffer_init(&buffer, RESPONSE_BUFFER_DEFAULT_LIMIT);
+        for (int j = 0; j < 16; j++) sink += response_buffer_write_callback(body_chunk, 1, sizeof(body_chunk), &buffer);
+        response_buffer_free(&buffer);
+    }
+}
+
+static void bench_config_get(long n) {
+    for (long i = 0; i < n; i++) sink += (size_t)config_get(config, "SPEEDMATH_SETTING_17");
+}
+
+static void bench_config_get_missing(long n) {
+    for (long i = 0; i < n; i++) sink += (size_t)config_get(config, "SPEEDMATH_NOT_SET");
+}
+
+static void bench_config_load(long n) {
+    const char *paths[] = { env_path };
+    for (long i = 0; i < n; i++) config_free(config_load(paths, 1));
+}
+
+static void bench_get_env_variable(long n) {
+    for (long i = 0; i < n; i++) sink += (size_t)get_env_variable(env_path, "GEMINI_API_KEY");
+}
+
+static void on_text(const char *text, size_t len, void *data) {
+    sink += len;
+}
+
+static void bench_gemini_json(long n) {
+    GeminiJson json;
+    for (long i = 0; i < n; i++) {
+        gemini_json_init(&json, on_text, NULL);
+        gemini_json_feed(&json, reply_json, reply_json_len);
+        sink += gemini_json_finish(&json);
+    }
+}
+
+static void bench_gemini_stream(long n) {
+    GeminiStream stream;
+    for (long i = 0; i < n; i++) {
+        gemini_stream_init(&stream, on_text, NULL);
+        // As the network delivers it: pieces that split lines and events
+        for (size_t at = 0; at < reply_sse_len; at += 1000)
+            gemini_stream_feed(&stream, reply_sse + at, reply_sse_len - at < 1000 ? reply_sse_len - at : 1000);
+        gemini_stream_finish(&stream);
+        gemini_stream_free(&stream);
+    }
+}
+
+static void on_span(const char *text, size_t len, unsigned style, void *data) {
+    sink += len + style;
+}
+
+static void bench_markdown(long n) {
+    MarkdownParser parser;
+    markdown_init(&parser, on_span, NULL);
+    for (long i = 0; i < n; i++) {
+        // In pieces of a streamed reply's size
+        for (size_t at = 0; at < solution_md_len; at += 64)
+            markdown_feed(&parser, solution_md + at, solution_md_len - at < 64 ? solution_md_len - at : 64);
+        markdown_finish(&parser);
+    }
+}
+
+static void bench_request_body(long n) {
+    RequestBody body;
+    request_body_init(&body);
+    for (long i = 0; i < n; i++) {
+        request_body_build(&body, &request_template, prompt);
+        size_t len;
+        free(request_body_steal(&body, &len));
+        sink += len;
+    }
+    request_body_free(&body);
+}
+
+static void bench_answer_check(long n) {
+    static const char *answers[] = { "120", "3/4", "B", "12.5%", "1 1/2" };
+    for (long i = 0; i < n; i++) sink += answer_check(&question, answers[i % 5], ANSWER_CHECK_DEFAULT_TOLERANCE);
+}
+
+static void bench_question_gen(long n) {
+    Question q;
+    for (long i = 0; i < n; i++) {
+        question_gen_next(&question_gen, QUESTION_GEN_ANY_TOPIC, 0, &q);
+        sink += q.correct_option;
+    }
+}
+
+static void bench_question_format(long n) {
+    char text[512];
+    for (long i = 0; i < n; i++) sink += question_format(&question, text, sizeof(text));
+}
+
+static void bench_stats_record(long n) {
+    for (long i = 0; i < n; i++)
+        session_stats_record(&session_stats, (QuestionTopic)(i % TOPIC_COUNT), 5.0 + (i % 97) * 0.37, i % 3 != 0);
+}
+
+static void bench_stats_quantile(long n) {
+    for (long i = 0; i < n; i++)
+        sink += (size_t)stream_stats_quantile(&solve_times, 0.5 + (i % 5) * 0.1);
+}
+
+static void bench_question_select_next(long n) {
+    uint32_t id;
+    for (long i = 0; i < n; i++) {
+        question_select_next(selector, QUESTION_GEN_ANY_TOPIC, 0, &id);
+        sink += id;
+    }
+}
+
+static void bench_question_select_answer(long n) {
+    uint32_t id;
+    for (long i = 0; i < n; i++)
+        if (question_select_next(selector, QUESTION_GEN_ANY_TOPIC, 0, &id)) select_answer(id, i);
+}
+
+static void bench_question_select_scan(long n) {
+    for (long i = 0; i < n; i++) {
+        uint8_t group = (uint8_t)(i % QUESTION_SELECT_GROUPS);
+        uint32_t best = UINT32_MAX, best_due = UINT32_MAX;
+        for (uint32_t id = 0; id < SELECT_QUESTIONS; id++)
+            if (scan_group[id] == group && scan_due[id] < best_due) best_due = scan_due[best = id];
+        sink += best;
+    }
+}
+
+typedef struct {
+    const char *name;
+    void (*run)(long n);
+} Bench;
+
+static const Bench benches[] = {
+    { "write_callback_16k", bench_write_callback },
+    { "write_callback_16k_fresh", bench_write_callback_fresh },
+    { "config_get", bench_config_get },
+    { "config_get_missing", bench_config_get_missing },
+    { "config_load_41_keys", bench_config_load },
+    { "get_env_variable", bench_get_env_variable },
+    { "gemini_json_2k_reply", bench_gemini_json },
+    { "gemini_stream_8_events", bench_gemini_stream },
+    { "markdown_2k_solution", bench_markdown },
+    { "request_body_build", bench_request_body },
+    { "answer_check", bench_answer_check },
+    { "question_gen_next", bench_question_gen },
+    { "question_format", bench_question_format },
+    { "stats_record", bench_stats_record },
+    { "stats_quantile", bench_stats_quantile },
+    { "question_select_next_1m", bench_question_select_next },
+    { "question_select_answer_1m", bench_question_select_answer },
+    { "question_select_scan_1m", bench_question_select_scan },
+};
+
+// ---- Harness
+
+typedef struct {
+    char name[64];
+    double ns;
+    double bytes;
+    double allocs;
+    double noise;    // percent slower than the fastest: the second fastest run, or the median of several
+} Result;
+
+// A benchmark being measured: its runs so far
+typedef struct {
+    const Bench *bench;
+    long n;          // operations per run, sized to RUN_NS
+    double ns[MAX_RUNS];
+    int runs;
+    Result result;
+} Measurement;
+
+static long now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000L + ts.tv_nsec;
+}
+
+static int compare_double(const void *a, const void *b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return x < y ? -1 : x > y;
+}
+
+// Grow n until one run takes a measurable time, then size it for RUN_NS
+static void calibrate(Measurement *m) {
+    long n = 1, elapsed = 0;
+    for (;;) {
+        long start = now_ns();
+        m->bench->run(n);
+        elapsed = now_ns() - start;
+        if (elapsed > RUN_NS / 10 || n > (1L << 40)) break;
+        n *= elapsed < RUN_NS / 1000 ? 16 : 2;
+    }
+    m->n = (long)((double)n * RUN_NS / (elapsed > 0 ? elapsed : 1));
+    if (m->n < 1) m->n = 1;
+    snprintf(m->result.name, sizeof(m->result.name), "%s", m->bench->name);
+}
+
+static void run_once(Measurement *m) {
+    if (m->runs == MAX_RUNS) return;
+    alloc_count = alloc_bytes = 0;
+    counting = 1;
+    long start = now_ns();
+    m->bench->run(m->n);
+    long took = now_ns() - start;
+    counting = 0;
+    m->ns[m->runs++] = (double)took / m->n;
+    m->result.bytes = (double)alloc_bytes / m->n;
+    m->result.allocs = (double)alloc_count / m->n;
+
+    double sorted[MAX_RUNS];
+    memcpy(sorted, m->ns, sizeof(double) * m->runs);
+    qsort(sorted, m->runs, sizeof(double), compare_double);
+    m->result.ns = sorted[0];
+    m->result.noise = m->runs > 1 ? (sorted[1] / sorted[0] - 1) * 100 : 0;
+}
+
+// Several runs one after another merge as described above
+static int load_results(const char *path, Result *out, int max) {
+    FILE *file = fopen(path, "r");
+    if (!file) return -1;
+    char line[256];
+    static double ns[MAX_BENCHES][MAX_RUNS];
+    int count = 0, runs[MAX_BENCHES];
+    Result r;
+    while (fgets(line, sizeof(line), file)) {
+        if (line[0] == '#') continue;
+        r.noise = 0;   // older baselines have no noise column
+        if (sscanf(line, "%63s %lf %lf %lf %lf", r.name, &r.ns, &r.bytes, &r.allocs, &r.noise) < 4) continue;
+        int i = 0;
+        while (i < count && strcmp(out[i].name, r.name) != 0) i++;
+        if (i == count) {
+            if (count == max) continue;
+            out[count] = r;
+            ns[count][0] = r.ns;
+            runs[count++] = 1;
+            continue;
+        }
+        if (runs[i] == MAX_RUNS) continue;
+        ns[i][runs[i]++] = r.ns;
+        if (r.bytes > out[i].bytes) out[i].bytes = r.bytes;
+        if (r.allocs > out[i].allocs) out[i].allocs = r.allocs;
+    }
+    fclose(file);
+    for (int i = 0; i < count; i++) {
+        if (runs[i] < 2) continue;
+        qsort(ns[i], runs[i], sizeof(double), compare_double);
+        out[i].ns = ns[i][0];
+        out[i].noise = (ns[i][runs[i] / 2] / ns[i][0] - 1) * 100;
+    }
+    return count;
+}
+
+static const Result* find(const Result *results, int count, const char *name) {
+    for (int i = 0; i < count; i++)
+        if (strcmp(results[i].name, name) == 0) return &results[i];
+    return NULL;
+}
+
+static int selected(const char *name, char **filters, int count) {
+    if (count == 0) return 1;
+    for (int i = 0; i < count; i++)
+        if (strstr(name, filters[i])) return 1;
+    return 0;
+}
+
+// How much slower the machine was for a whole measurement: the median of
+// every benchmark's ratio to the baseline, or 1 with too few to tell
+static double shift_of(const Result *results, int count, const Result *baseline, int baseline_count) {
+    double ratios[MAX_BENCHES];
+    int n = 0;
+    for (int i = 0; i < count; i++) {
+        const Result *then = find(baseline, baseline_count, results[i].name);
+        if (then && then->ns > 0) ratios[n++] = results[i].ns / then->ns;
+    }
+    if (n < MIN_SHIFT_BENCHES) return 1;
+    qsort(ratios, n, sizeof(double), compare_double);
+    return n % 2 ? ratios[n / 2] : (ratios[n / 2 - 1] + ratios[n / 2]) / 2;
+}
+
+// Percent slower than the baseline once the machine's shift is taken out,
+// and the most that counts as noise
+static double change_of(const Result *after, const Result *before, double shift) {
+    return before->ns > 0 ? (after->ns / before->ns / shift - 1) * 100 : 0;
+}
+
+static double allowed_of(const Result *after, const Result *before, double threshold) {
+    if (threshold >= 0) return threshold;
+    double noise = before->noise > after->noise ? before->noise : after->noise;
+    return NOISE_FACTOR * noise > MIN_THRESHOLD ? NOISE_FACTOR * noise : MIN_THRESHOLD;
+}
+
+static double excess_of(const Result *after, const Result *before, double shift, double threshold) {
+    return change_of(after, before, shift) - allowed_of(after, before, threshold);
+}
+
+static int worse_than(const Result *after, const Result *before, double shift, double threshold) {
+    return excess_of(after, before, shift, threshold) > 0 || after->bytes > before->bytes + 0.5 ||
+           after->allocs > before->allocs + 0.01;
+}
+
+static void usage(const char *name) {
+    fprintf(stderr, "Usage: %s [-r runs] [-b baseline.tsv [-a after.tsv]...] [-t threshold_percent] [-l] [name_filter]...\n",
+            name);
+}
+
+int main(int argc, char *argv[]) {
+    int runs = DEFAULT_RUNS, opt, list = 0, sets = 0;
+    const char *baseline_path = NULL, *after_paths[MAX_AFTER];
+    double threshold = -1;   // from the noise unless -t is given
+    while ((opt = getopt(argc, argv, "r:b:a:t:lh")) != -1) {
+        switch (opt) {
+        case 'r': runs = atoi(optarg) > 0 ? atoi(optarg) : 1; break;
+        case 'b': baseline_path = optarg; break;
+        case 'a':
+            if (sets < MAX_AFTER) after_paths[sets++] = optarg;
+            break;
+        case 't': threshold = atof(optarg); break;
+        case 'l': list = 1; break;
+        default: usage(argv[0]); return opt == 'h' ? 0 : 2;
+        }
+    }
+    if (runs > MAX_RUNS) runs = MAX_RUNS;
+    size_t bench_count = sizeof(benches) / sizeof(benches[0]);
+    if (list) {
+        for (size_t i = 0; i < bench_count; i++) puts(benches[i].name);
+        return 0;
+    }
+    if (sets && !baseline_path) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    static Result baseline[MAX_BENCHES], results[MAX_AFTER][MAX_BENCHES];
+    int baseline_count = 0, counts[MAX_AFTER] = {0};
+    if (baseline_path && (baseline_count = load_results(baseline_path, baseline, MAX_BENCHES)) < 0) {
+        fprintf(stderr, "Could not read %s\n", baseline_path);
+        return 2;
+    }
+    for (int set = 0; set < sets; set++) {
+        Result loaded[MAX_BENCHES];
+        int loaded_count = load_results(after_paths[set], loaded, MAX_BENCHES);
+        if (loaded_count < 0) {
+            fprintf(stderr, "Could not read %s\n", after_paths[set]);
+            return 2;
+        }
+        for (int i = 0; i < loaded_count; i++)
+            if (selected(loaded[i].name, argv + optind, argc - optind)) results[set][counts[set]++] = loaded[i];
+    }
+    if (!sets) {
+        // Stay on one CPU: no migrations, and caches stay warm between runs
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(sched_getcpu(), &cpus);
+        sched_setaffinity(0, sizeof(cpus), &cpus);
+
+        setup();
+        static Measurement measurements[MAX_BENCHES];
+        int count = 0;
+        for (size_t i = 0; i < bench_count && count < MAX_BENCHES; i++) {
+            if (!selected(benches[i].name, argv + optind, argc - optind)) continue;
+            measurements[count].bench = &benches[i];
+            calibrate(&measurements[count++]);
+        }
+        for (int r = 0; r < runs; r++)
+            for (int i = 0; i < count; i++) run_once(&measurements[i]);
+        teardown();
+        for (int i = 0; i < count; i++) results[0][i] = measurements[i].result;
+        counts[0] = count;
+        sets = 1;
+    }
+
+    double shifts[MAX_AFTER];
+    for (int set = 0; set < sets; set++) {
+        shifts[set] = threshold < 0 ? shift_of(results[set], counts[set], baseline, baseline_count) : 1;
+        if (baseline_path && shifts[set] != 1)
+            printf("# the machine ran %+.1f%% overall; taken out of each change\n", (shifts[set] - 1) * 100);
+    }
+    if (baseline_path)
+        printf("# %-26s %12s %12s %8s %8s %10s %10s\n", "name", "baseline ns", "ns/op", "change", "allowed", "bytes/op",
+               "allocs/op");
+    else printf("# name\tns_per_op\tbytes_per_op\tallocs_per_op\tnoise_percent\n");
+    int regressions = 0;
+    for (int i = 0; i < counts[0]; i++) {
+        const Result *result = &results[0][i];
+        if (!baseline_path) {
+            printf("%s\t%.2f\t%.1f\t%.2f\t%.1f\n", result->name, result->ns, result->bytes, result->allocs, result->noise);
+            continue;
+        }
+        const Result *then = find(baseline, baseline_count, result->name);
+        if (!then) {
+            printf("  %-26s %12s %12.2f %8s %8s %10.1f %10.2f\n", result->name, "new", result->ns, "", "",
+                   result->bytes, result->allocs);
+            continue;
+        }
+        // With several measurements a regression has to show in every one;
+        // the one closest to passing is shown
+        int worse = 1, shown = 0;
+        for (int set = 0; set < sets; set++) {
+            const Result *other = find(results[set], counts[set], result->name);
+            if (!other) continue;
+            worse &= worse_than(other, then, shifts[set], threshold);
+            if (excess_of(other, then, shifts[set], threshold) < excess_of(result, then, shifts[shown], threshold)) {
+                result = other;
+                shown = set;
+            }
+        }
+        regressions += worse;
+        printf("  %-26s %12.2f %12.2f %+7.1f%% %7.1f%% %10.1f %10.2f%s\n", result->name, then->ns, result->ns,
+               change_of(result, then, shifts[shown]), allowed_of(result, then, threshold), result->bytes,
+               result->allocs, worse ? "  REGRESSION" : "");
+    }
+    if (baseline_path) printf("# %d regression(s)\n", regressions);
+    return regressions ? 1 : 0;
+}
@@ -0,0 +1,237 @@
+// Replays a recorded drill session through the core library, the way the
+// front ends drive it, and times it. This is the training run of the
+// profile-guided build and the yardstick when comparing builds (../Makefile).
+//
+// Session file: "# seed N" (the generator's, so the questions come back the
+// same), then one line per key the student sent:
+//   an answer as typed   graded; a valid one moves on to the next question
+//   ?                    the solution of the last question: its request body
+//                        is built and the recorded reply streamed through
+//                        the SSE parser and the markdown reader
+//   -                    skip the question
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "../question_gen.h"
+#include "../answer_check.h"
+#include "../question_timer.h"
+#include "../stats.h"
+#include "../attempt_log.h"
+#include "../request_body.h"
+#include "../gemini_stream.h"
+#include "../markdown.h"
+
+#define MAX_LINES 4096
+#define PACKET 1400       // reply bytes per read, as from the network
+
+static char *session;
+static char *lines[MAX_LINES];
+static int line_count;
+static unsigned long long seed = 1;
+static char *reply;
+static size_t reply_len;
+
+// What a round produced, to check that every build computes the same
+typedef struct {
+    unsigned answers;
+    unsigned correct;
+    unsigned invalid;
+    unsigned solutions;
+    size_t body_bytes;
+    size_t text_bytes;
+    size_t spans;
+    unsigned long long styled;   // bytes by style, summed as a checksum
+} Round;
+
+static void on_span(const char *text, size_t len, unsigned style, void *data) {
+    Round *round = data;
+    round->spans++;
+    round->styled += len * (style + 1);
+}
+
+// Candidate text on its way to the markdown reader
+typedef struct {
+    MarkdownParser markdown;
+    Round *round;
+} Reader;
+
+static void on_text(const char *text, size_t len, void *data) {
+    Reader *reader = data;
+    reader->round->text_bytes += len;
+    markdown_feed(&reader->markdown, text, len);
+}
+
+static char* read_file(const char *path, size_t *len) {
+    FILE *file = fopen(path, "rb");
+    if (!file) return NULL;
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    char *data = size >= 0 ? malloc((size_t)size + 1) : NULL;
+    if (data && fread(data, 1, (size_t)size, file) != (size_t)size) {
+        free(data);
+        data = NULL;
+    }
+    fclose(file);
+    if (!data) return NULL;
+    data[size] = '\0';
+    *len = (size_t)size;
+    return data;
+}
+
+static int load_session(const char *path) {
+    size_t len;
+    char *text = session = read_file(path, &len);
+    if (!text) return 0;
+    for (char *line = strtok(text, "\n"); line; line = strtok(NULL, "\n")) {
+        line[strcspn(line, "\r")] = '\0';
+        if (sscanf(line, "# seed %llu", &seed) == 1 || line[0] == '#' || !line[0]) continue;
+        if (line_count < MAX_LINES) lines[line_count++] = line;
+    }
+    return line_count > 0;
+}
+
+static void solve(const Question *q, const RequestTemplate *tmpl, Round *round) {
+    char query[512];
+    snprintf(query, sizeof(query), "Give a stepwise complete solution, using the fastest exam shortcut, for: %s Options: A) %s, B) %s, C) %s, D) %s. The correct answer is %c.",
+             q->question, q->options[0], q->options[1], q->options[2], q->options[3], 'A' + q->correct_option);
+    RequestBody body;
+    request_body_init(&body);
+    if (request_body_build(&body, tmpl, query)) round->body_bytes += body.len;
+    request_body_free(&body);
+
+    Reader reader = { .round = round };
+    GeminiStream stream;
+    markdown_init(&reader.markdown, on_span, round);
+    gemini_stream_init(&stream, on_text, &reader);
+    for (size_t at = 0; at < reply_len; at += PACKET)
+        gemini_stream_feed(&stream, reply + at, reply_len - at < PACKET ? reply_len - at : PACKET);
+    gemini_stream_finish(&stream);
+    markdown_finish(&reader.markdown);
+    gemini_stream_free(&stream);
+    round->solutions++;
+}
+
+static void play(const RequestTemplate *tmpl, AttemptLog *log, Round *round) {
+    QuestionGen gen;
+    Question q;
+    QuestionTimer timer;
+    SessionStats stats;
+    char text[512], feedback[160];
+    int need = 1;
+    question_gen_init(&gen, seed);
+    session_stats_init(&stats);
+    memset(round, 0, sizeof(*round));
+    for (int i = 0; i < line_count; i++) {
+        if (need) {
+            question_gen_next(&gen, QUESTION_GEN_ANY_TOPIC, 0, &q);
+            question_format(&q, text, sizeof(text));
+            question_timer_start(&timer);
+            need = 0;
+        }
+        const char *line = lines[i];
+        if (strcmp(line, "?") == 0) {
+            solve(&q, tmpl, round);
+            continue;
+        }
+        if (strcmp(line, "-") == 0) {
+            need = 1;
+            continue;
+        }
+        question_timer_advance(&timer, TIMER_PHASE_TYPE);
+        AnswerGrade grade = answer_check(&q, line, ANSWER_CHECK_DEFAULT_TOLERANCE);
+        if (grade == GRADE_INVALID) {
+            round->invalid++;
+            continue;
+        }
+        session_stats_record(&stats, q.topic, question_timer_stop(&timer) / 1e6, grade == GRADE_CORRECT);
+        stream_stats_format(&stats.topic[q.topic], feedback, sizeof(feedback));
+        if (log) {
+            Attempt attempt;
+            attempt_init(&attempt, &q, line, grade, &timer);
+            attempt_log_append(log, &attempt);
+        }
+        round->answers++;
+        round->correct += grade == GRADE_CORRECT;
+        need = 1;
+    }
+}
+
+static int compare_us(const void *a, const void *b) {
+    int64_t x = *(const int64_t *)a, y = *(const int64_t *)b;
+    return (x > y) - (x < y);
+}
+
+static void usage(const char *name) {
+    fprintf(stderr, "Usage: %s [-r rounds] [-l attempts_log] session.txt reply.sse\n", name);
+}
+
+int main(int argc, char *argv[]) {
+    int rounds = 20, opt;
+    const char *log_path = NULL;
+    while ((opt = getopt(argc, argv, "r:l:h")) != -1) {
+        switch (opt) {
+        case 'r': rounds = atoi(optarg); break;
+        case 'l': log_path = optarg; break;
+        default: usage(argv[0]); return opt == 'h' ? 0 : 2;
+        }
+    }
+    if (argc - optind != 2 || rounds < 1) {
+        usage(argv[0]);
+        return 2;
+    }
+    if (!load_session(argv[optind])) {
+        fprintf(stderr, "Cannot read the session %s\n", argv[optind]);
+        return 1;
+    }
+    if (!(reply = read_file(argv[optind + 1], &reply_len))) {
+        fprintf(stderr, "Cannot read the reply %s\n", argv[optind + 1]);
+        return 1;
+    }
+
+    // The answers go to a scratch log unless one is given, as the app's would
+    char scratch[64] = "";
+    if (!log_path) {
+        snprintf(scratch, sizeof(scratch), "/tmp/speedmath_drill_%d.log", (int)getpid());
+        log_path = scratch;
+    }
+    AttemptLog *log = attempt_log_open(log_path);
+    RequestOptions options = { "You are a speed maths coach for Indian banking exams.", 0.7, 1024 };
+    RequestTemplate tmpl;
+    request_template_init(&tmpl, &options);
+
+    int64_t *times = malloc(sizeof(int64_t) * rounds);
+    Round first, round;
+    for (int r = 0; r < rounds; r++) {
+        int64_t start = timer_now_us();
+        play(&tmpl, log, &round);
+        times[r] = timer_now_us() - start;
+        if (r == 0) first = round;
+        else if (memcmp(&first, &round, sizeof(round)) != 0) {
+            fprintf(stderr, "Round %d differs from the first\n", r + 1);
+            return 1;
+        }
+    }
+    qsort(times, rounds, sizeof(int64_t), compare_us);
+    int64_t median = times[rounds / 2];
+    printf("%.1f µs per answer, %" PRId64 " µs per round (median of %d, best %" PRId64 ")"
+           " | %u answers, %u correct, %u invalid, %u solutions, %zu spans, checksum %llx\n",
+           (double)median / (first.answers ? first.answers : 1), median, rounds, times[0],
+           first.answers, first.correct, first.invalid, first.solutions, first.spans,
+           first.styled ^ first.body_bytes ^ ((unsigned long long)first.text_bytes << 32));
+
+    free(times);
+    request_template_free(&tmpl);
+    attempt_log_close(log);
+    if (scratch[0]) {
+        unlink(scratch);
+        char snapshot[80];
+        snprintf(snapshot, sizeof(snapshot), "%s.snapshot", scratch);
+        unlink(snapshot);
+    }
+    free(reply);
+    free(session);
+    return 0;
+}
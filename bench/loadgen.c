@@ -0,0 +1,222 @@
+// End-to-end load on the request engine: a fixed number of Gemini requests
+// kept N at a time in flight, with throughput and latency percentiles.
+// Meant for bench/mock_server.c, so networking changes can be measured
+// offline, but any base URL works (-k for a real API key).
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "../request_engine.h"
+#include "../request_body.h"
+#include "../gemini_stream.h"
+#include "../net_trace.h"
+
+#define DEFAULT_URL "http://127.0.0.1:8089/"
+#define DEFAULT_MODEL "gemini-1.5-flash"
+
+typedef struct {
+    const char *url;
+    const char *model;
+    const char *key;
+    int requests;
+    int concurrency;
+    int stream;          // streamGenerateContent?alt=sse rather than generateContent
+    size_t prompt_bytes;
+    const char *trace;   // request trace file, as the app writes it
+} LoadOptions;
+
+// One request, from queueing to its done callback
+typedef struct {
+    gint64 started;
+    gint64 first_byte;   // 0 until the first body byte
+    gint64 finished;
+    size_t received;     // body bytes
+    size_t text;         // decoded candidate text bytes
+    int ok;
+    GeminiStream stream;
+    GeminiJson json;
+} Sample;
+
+static LoadOptions options = { DEFAULT_URL, DEFAULT_MODEL, "mock", 200, 8, 0, 500, NULL };
+static RequestEngine *engine;
+static GMainLoop *loop;
+static NetTrace *net_trace;   // phases of every request
+static GBytes *body;         // one body, shared by every request
+static char url[1024];
+static Sample *samples;
+static int started, finished, reported;
+
+static void start_next(void);
+
+static void on_text(const char *text, size_t len, void *data) {
+    ((Sample*)data)->text += len;
+}
+
+static void on_data(guint id, const char *data, size_t len, gpointer user_data) {
+    Sample *sample = user_data;
+    if (!sample->first_byte) sample->first_byte = g_get_monotonic_time();
+    sample->received += len;
+    if (options.stream) gemini_stream_feed(&sample->stream, data, len);
+    else gemini_json_feed(&sample->json, data, len);
+}
+
+static void on_done(guint id, CURLcode result, long http_status, const char *data, size_t len, gpointer user_data) {
+    Sample *sample = user_data;
+    sample->finished = g_get_monotonic_time();
+    const GeminiJson *json = &sample->json;
+    if (options.stream) {
+        gemini_stream_finish(&sample->stream);
+        json = &sample->stream.json;
+    } else {
+        gemini_json_finish(&sample->json);
+    }
+    sample->ok = result == CURLE_OK && http_status < 400 && !json->failed && !json->error_code && sample->text > 0;
+    if (options.stream) gemini_stream_free(&sample->stream);
+    RequestTimings timings;
+    if (id && request_engine_timings(engine, id, &timings)) {
+        NetTraceEntry entry = { g_get_real_time(), "load", result, (int)http_status, timings.http_version,
+                                timings.reused, timings.dns, timings.connect, timings.tls, timings.pretransfer,
+                                timings.first_byte, timings.total, timings.bytes_up, timings.bytes_down,
+                                timings.body_decoded, "" };
+        g_strlcpy(entry.encoding, timings.encoding, sizeof(entry.encoding));
+        net_trace_add(net_trace, &entry);
+    }
+    if (!sample->ok && reported++ < 5)   // the first few; the report has the count
+        fprintf(stderr, "Request failed: %s (HTTP %ld) %s\n", curl_easy_strerror(result), http_status, json->error_message);
+
+    finished++;
+    if (started < options.requests) start_next();
+    else if (finished == options.requests) g_main_loop_quit(loop);
+}
+
+static void start_next(void) {
+    static const char *headers[] = { "Content-Type: application/json", NULL };
+    Sample *sample = &samples[started++];
+    if (options.stream) gemini_stream_init(&sample->stream, on_text, sample);
+    else gemini_json_init(&sample->json, on_text, sample);
+    sample->started = g_get_monotonic_time();
+    if (!request_engine_post_bytes(engine, url, body, headers, on_data, on_done, sample))
+        on_done(0, CURLE_FAILED_INIT, 0, "", 0, sample);
+}
+
+static int compare_us(const void *a, const void *b) {
+    gint64 x = *(const gint64*)a, y = *(const gint64*)b;
+    return x < y ? -1 : x > y;
+}
+
+// Nearest-rank percentile of sorted values, in milliseconds
+static double percentile(const gint64 *sorted, int count, double p) {
+    if (count == 0) return 0;
+    int rank = (int)(p / 100 * count + 0.999999);
+    return sorted[rank < 1 ? 0 : rank > count ? count - 1 : rank - 1] / 1000.0;
+}
+
+static void report(gint64 elapsed) {
+    gint64 *latency = calloc(options.requests, sizeof(gint64));
+    gint64 *first_byte = calloc(options.requests, sizeof(gint64));
+    int ok = 0, with_first_byte = 0;
+    guint64 received = 0, text = 0;
+    for (int i = 0; i < options.requests; i++) {
+        const Sample *sample = &samples[i];
+        received += sample->received;
+        text += sample->text;
+        if (!sample->ok) continue;
+        latency[ok++] = sample->finished - sample->started;
+        if (sample->first_byte) first_byte[with_first_byte++] = sample->first_byte - sample->started;
+    }
+    qsort(latency, ok, sizeof(gint64), compare_us);
+    qsort(first_byte, with_first_byte, sizeof(gint64), compare_us);
+
+    double seconds = elapsed / 1e6;
+    ConnectionStats conn = request_engine_connection_stats(engine);
+    printf("%d requests, %d at a time, %s: %d ok, %d failed in %.2f s\n", options.requests, options.concurrency,
+           options.stream ? "streamed" : "whole replies", ok, options.requests - ok, seconds);
+    printf("throughput:  %.1f req/s, %.2f MB/s received\n", ok / seconds, received / seconds / 1e6);
+    printf("latency:     p50 %.1f ms, p90 %.1f ms, p99 %.1f ms, max %.1f ms\n", percentile(latency, ok, 50),
+           percentile(latency, ok, 90), percentile(latency, ok, 99), percentile(latency, ok, 100));
+    printf("first byte:  p50 %.1f ms, p99 %.1f ms\n", percentile(first_byte, with_first_byte, 50),
+           percentile(first_byte, with_first_byte, 99));
+    printf("per request: %zu B sent, %.0f B received (%.0f B of text)\n", g_bytes_get_size(body),
+           (double)received / options.requests, (double)text / options.requests);
+    printf("connections: %lu reused, %lu new\n", conn.reused, conn.fresh);
+    NetTraceSummary summary;
+    char phases[320];
+    net_trace_summary(net_trace, &summary);
+    net_trace_format(&summary, phases, sizeof(phases));
+    printf("%s\n", phases);
+    NetTraceTotals totals = net_trace_totals(net_trace);
+    net_trace_format_totals(&totals, phases, sizeof(phases));
+    printf("bandwidth:   %s\n", phases);
+    free(latency);
+    free(first_byte);
+}
+
+static void usage(const char *name) {
+    fprintf(stderr, "Usage: %s [-u base_url] [-m model] [-k api_key] [-n requests] [-c concurrency] [-b prompt_bytes] [-s] [-t trace_file]\n",
+            name);
+}
+
+int main(int argc, char *argv[]) {
+    int opt;
+    while ((opt = getopt(argc, argv, "u:m:k:n:c:b:st:h")) != -1) {
+        switch (opt) {
+        case 'u': options.url = optarg; break;
+        case 'm': options.model = optarg; break;
+        case 'k': options.key = optarg; break;
+        case 'n': options.requests = atoi(optarg); break;
+        case 'c': options.concurrency = atoi(optarg); break;
+        case 'b': options.prompt_bytes = (size_t)atol(optarg); break;
+        case 's': options.stream = 1; break;
+        case 't': options.trace = optarg; break;
+        default: usage(argv[0]); return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (options.requests < 1 || options.concurrency < 1) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    snprintf(url, sizeof(url), "%sv1beta/models/%s:%s?%skey=%s", options.url, options.model,
+             options.stream ? "streamGenerateContent" : "generateContent", options.stream ? "alt=sse&" : "", options.key);
+
+    // A prompt of the requested size, built like the app builds its own
+    char *prompt = malloc(options.prompt_bytes + 1);
+    for (size_t i = 0; i < options.prompt_bytes; i++) prompt[i] = "give me a speed math question "[i % 30];
+    prompt[options.prompt_bytes] = '\0';
+    RequestTemplate tmpl;
+    RequestOptions request_options = { NULL, -1, 0 };
+    request_template_init(&tmpl, &request_options);
+    RequestBody request;
+    request_body_init(&request);
+    size_t len = 0;
+    char *data = request_body_build(&request, &tmpl, prompt) ? request_body_steal(&request, &len) : NULL;
+    request_body_free(&request);
+    request_template_free(&tmpl);
+    free(prompt);
+    if (!data) return 1;
+    body = g_bytes_new_with_free_func(data, len, free, data);
+
+    net_trace = net_trace_open(options.trace, NET_TRACE_DEFAULT_BYTES, NET_TRACE_DEFAULT_KEEP);
+    if (!net_trace) {
+        fprintf(stderr, "Could not open %s\n", options.trace);
+        return 1;
+    }
+    curl_global_init(CURL_GLOBAL_DEFAULT);
+    engine = request_engine_new();
+    loop = g_main_loop_new(NULL, FALSE);
+    samples = calloc(options.requests, sizeof(Sample));
+
+    gint64 begin = g_get_monotonic_time();
+    int first = options.concurrency < options.requests ? options.concurrency : options.requests;
+    for (int i = 0; i < first; i++) start_next();
+    if (finished < options.requests) g_main_loop_run(loop);
+    report(g_get_monotonic_time() - begin);
+
+    request_engine_free(engine);
+    g_main_loop_unref(loop);
+    g_bytes_unref(body);
+    net_trace_close(net_trace);
+    free(samples);
+    curl_global_cleanup();
+    return 0;
+}
@@ -0,0 +1,416 @@
+// Local stand-in for the Gemini API, so the request engine can be measured
+// and tested without the network. Answers
+//   POST /v1beta/models/<model>:generateContent          one JSON reply
+//   POST /v1beta/models/<model>:streamGenerateContent    SSE with ?alt=sse, else a JSON array
+// over HTTP/1.1 with keep-alive, one thread per connection, gzipped (-z) for
+// clients that accept it, as Google's servers do. Point the app at it with
+// SPEEDMATH_API_URL=http://127.0.0.1:8089/.
+#define _GNU_SOURCE
+#include <errno.h>
+#include <getopt.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#define DEFAULT_PORT 8089
+#define MAX_REPLAY 64
+#define MAX_HEADER 16384
+
+typedef struct {
+    int port;
+    int latency_ms;        // before the first byte
+    int jitter_ms;         // plus up to this much, uniformly
+    int chunks;            // pieces the reply is sent in
+    int interval_ms;       // pause between pieces
+    size_t size;           // bytes of generated candidate text
+    double error_rate;     // share of requests answered with error_status
+    int error_status;
+    double cut_rate;       // share of replies cut off halfway (connection closed)
+    int gzip;              // compress replies for clients that accept gzip
+    int verbose;
+} MockOptions;
+
+static MockOptions options = { DEFAULT_PORT, 200, 0, 8, 30, 2048, 0.0, 503, 0.0, 0, 0 };
+
+// Recorded replies (raw bodies, or response cache entries), served in turn
+typedef struct {
+    char *data;
+    size_t len;
+    int sse;
+} Replay;
+
+static Replay replays[MAX_REPLAY];
+static int replay_count;
+static char *text;     // generated candidate text, options.size bytes
+
+static unsigned long served, errors, cut, bytes_out, next_replay;
+static volatile sig_atomic_t stopping;
+
+static void sleep_ms(int ms) {
+    if (ms <= 0) return;
+    struct timespec ts = { ms / 1000, (long)(ms % 1000) * 1000000 };
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR) {}
+}
+
+static int send_all(int fd, const char *data, size_t len) {
+    while (len > 0) {
+        ssize_t n = send(fd, data, len, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return 0;
+        __atomic_add_fetch(&bytes_out, (unsigned long)n, __ATOMIC_RELAXED);
+        data += n;
+        len -= n;
+    }
+    return 1;
+}
+
+static int send_text(int fd, const char *text) {
+    return send_all(fd, text, strlen(text));
+}
+
+static double chance(unsigned *seed) {
+    return rand_r(seed) / ((double)RAND_MAX + 1);
+}
+
+// One SSE event / array element of a streamed reply: a piece of the text,
+// and the finish reason and usage counts with the last piece
+static char* reply_event(const char *piece, size_t len, int last, long prompt_tokens, size_t *out_len) {
+    long candidate_tokens = (long)(options.size / 4) + 1;
+    size_t cap = len + 512;
+    char *event = malloc(cap);
+    int n = snprintf(event, cap, "{\"candidates\":[{\"content\":{\"parts\":[{\"text\":\"%.*s\"}],\"role\":\"model\"}",
+                     (int)len, piece);
+    if (last)
+        n += snprintf(event + n, cap - n, ",\"finishReason\":\"STOP\",\"index\":0}],\"usageMetadata\":"
+                      "{\"promptTokenCount\":%ld,\"candidatesTokenCount\":%ld,\"totalTokenCount\":%ld}}",
+                      prompt_tokens, candidate_tokens, prompt_tokens + candidate_tokens);
+    else
+        n += snprintf(event + n, cap - n, ",\"index\":0}]}");
+    *out_len = n;
+    return event;
+}
+
+static const char* status_text(int status) {
+    switch (status) {
+    case 200: return "OK";
+    case 400: return "Bad Request";
+    case 404: return "Not Found";
+    case 429: return "Too Many Requests";
+    case 500: return "Internal Server Error";
+    default: return "Service Unavailable";
+    }
+}
+
+static const char* error_status(int status) {
+    switch (status) {
+    case 400: return "INVALID_ARGUMENT";
+    case 404: return "NOT_FOUND";
+    case 429: return "RESOURCE_EXHAUSTED";
+    case 500: return "INTERNAL";
+    default: return "UNAVAILABLE";
+    }
+}
+
+static int send_error(int fd, int status, const char *message) {
+    char body[256], response[512];
+    int len = snprintf(body, sizeof(body), "{\"error\":{\"code\":%d,\"message\":\"%s\",\"status\":\"%s\"}}",
+                       status, message, error_status(status));
+    int n = snprintf(response, sizeof(response), "HTTP/1.1 %d %s\r\nContent-Type: application/json\r\n"
+                     "Content-Length: %d\r\n\r\n%s", status, status_text(status), len, body);
+    __atomic_add_fetch(&errors, 1, __ATOMIC_RELAXED);
+    return send_all(fd, response, n);
+}
+
+// Send pieces[0..count) as the body, pausing between them. chunked uses
+// chunked transfer encoding (the length is not known up front in a real
+// stream); cut stops halfway and reports failure so the connection closes.
+static int send_body(int fd, const char *content_type, int gzipped, int chunked, char **pieces, size_t *lens,
+                     int count, int cut_off) {
+    size_t total = 0;
+    for (int i = 0; i < count; i++) total += lens[i];
+    char head[256];
+    const char *encoding = gzipped ? "Content-Encoding: gzip\r\n" : "";
+    int n = chunked ?
+        snprintf(head, sizeof(head), "HTTP/1.1 200 OK\r\nContent-Type: %s\r\n%sTransfer-Encoding: chunked\r\n\r\n",
+                 content_type, encoding) :
+        snprintf(head, sizeof(head), "HTTP/1.1 200 OK\r\nContent-Type: %s\r\n%sContent-Length: %zu\r\n\r\n",
+                 content_type, encoding, total);
+    if (!send_all(fd, head, n)) return 0;
+    for (int i = 0; i < count; i++) {
+        if (i > 0) sleep_ms(options.interval_ms);
+        if (cut_off && i >= count / 2) {
+            __atomic_add_fetch(&cut, 1, __ATOMIC_RELAXED);
+            return 0;
+        }
+        if (chunked) {
+            char size[32];
+            int m = snprintf(size, sizeof(size), "%zx\r\n", lens[i]);
+            if (lens[i] == 0) continue;   // a zero-size chunk would end the body
+            if (!send_all(fd, size, m) || !send_all(fd, pieces[i], lens[i]) || !send_all(fd, "\r\n", 2)) return 0;
+        } else if (!send_all(fd, pieces[i], lens[i])) {
+            return 0;
+        }
+    }
+    return !chunked || send_all(fd, "0\r\n\r\n", 5);
+}
+
+// data cut into count pieces of (nearly) equal size
+static int split(const char *data, size_t len, int count, char **pieces, size_t *lens) {
+    size_t step = len / count + 1;
+    int n = 0;
+    for (size_t at = 0; at < len; at += step, n++) {
+        lens[n] = at + step < len ? step : len - at;
+        pieces[n] = strndup(data + at, lens[n]);
+    }
+    return n;
+}
+
+// The reply to one generate request, as pieces ready to send
+static int build_reply(int stream, int sse, long prompt_tokens, char ***out_pieces, size_t **out_lens,
+                       const char **content_type) {
+    int count = options.chunks > 0 ? options.chunks : 1;
+    char **pieces = calloc(count, sizeof(char*));
+    size_t *lens = calloc(count, sizeof(size_t));
+    int n = 0;
+
+    if (replay_count > 0) {
+        const Replay *replay = &replays[__atomic_fetch_add(&next_replay, 1, __ATOMIC_RELAXED) % replay_count];
+        *content_type = replay->sse ? "text/event-stream" : "application/json";
+        n = split(replay->data, replay->len, count, pieces, lens);
+    } else if (!stream) {
+        // The whole document, sent in pieces
+        *content_type = "application/json";
+        size_t len;
+        char *whole = reply_event(text, options.size, 1, prompt_tokens, &len);
+        n = split(whole, len, count, pieces, lens);
+        free(whole);
+    } else {
+        // One event per piece of text
+        *content_type = sse ? "text/event-stream" : "application/json";
+        size_t step = options.size / count + 1;
+        for (; n < count; n++) {
+            size_t from = n * step < options.size ? n * step : options.size;
+            size_t len = from + step < options.size ? step : options.size - from, event_len;
+            int last = n == count - 1;
+            char *event = reply_event(text + from, len, last, prompt_tokens, &event_len);
+            pieces[n] = malloc(event_len + 16);
+            if (sse) lens[n] = sprintf(pieces[n], "data: %s\r\n\r\n", event);
+            else lens[n] = sprintf(pieces[n], "%s%s%s", n == 0 ? "[" : ",\r\n", event, last ? "]" : "");
+            free(event);
+        }
+    }
+    *out_pieces = pieces;
+    *out_lens = lens;
+    return n;
+}
+
+// Replace the pieces by one gzip stream, flushed at the end of each piece
+// so every piece can be decoded as soon as it arrives
+static int gzip_pieces(char **pieces, size_t *lens, int count) {
+    z_stream z = { 0 };
+    if (deflateInit2(&z, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) return 0;
+    int ok = 1;
+    for (int i = 0; i < count && ok; i++) {
+        size_t cap = deflateBound(&z, lens[i]) + 32;
+        char *out = malloc(cap);
+        z.next_in = (Bytef*)pieces[i];
+        z.avail_in = lens[i];
+        z.next_out = (Bytef*)out;
+        z.avail_out = cap;
+        int rc = deflate(&z, i == count - 1 ? Z_FINISH : Z_SYNC_FLUSH);
+        ok = rc == (i == count - 1 ? Z_STREAM_END : Z_OK) && z.avail_in == 0;
+        free(pieces[i]);
+        pieces[i] = out;
+        lens[i] = cap - z.avail_out;
+    }
+    deflateEnd(&z);
+    return ok;
+}
+
+static void free_pieces(char **pieces, size_t *lens, int count) {
+    for (int i = 0; i < count; i++) free(pieces[i]);
+    free(pieces);
+    free(lens);
+}
+
+// Requests on one connection until the client closes it or something fails
+static void* serve_connection(void *data) {
+    int fd = (int)(long)data;
+    unsigned seed = (unsigned)time(NULL) ^ (unsigned)fd ^ (unsigned)(unsigned long)pthread_self();
+    char *buffer = malloc(MAX_HEADER);
+    size_t have = 0;
+    int keep_alive = 1;
+
+    while (keep_alive && !stopping) {
+        // Headers
+        char *end = NULL;
+        while (!(end = memmem(buffer, have, "\r\n\r\n", 4))) {
+            if (have == MAX_HEADER) goto done;
+            ssize_t n = recv(fd, buffer + have, MAX_HEADER - have, 0);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) goto done;
+            have += n;
+        }
+        *end = '\0';
+        size_t header_len = end + 4 - buffer;
+        char method[16] = "", path[1024] = "";
+        sscanf(buffer, "%15s %1023s", method, path);
+        long content_length = 0;
+        int expect_continue = 0, accepts_gzip = 0;
+        for (char *line = strstr(buffer, "\r\n"); line; line = strstr(line + 2, "\r\n")) {
+            char *name = line + 2;
+            if (strncasecmp(name, "Content-Length:", 15) == 0) content_length = atol(name + 15);
+            else if (strncasecmp(name, "Connection:", 11) == 0 && strcasestr(name, "close")) keep_alive = 0;
+            else if (strncasecmp(name, "Expect:", 7) == 0 && strcasestr(name, "100-continue")) expect_continue = 1;
+            else if (strncasecmp(name, "Accept-Encoding:", 16) == 0 && strcasestr(name, "gzip")) accepts_gzip = 1;
+        }
+        if (options.verbose) fprintf(stderr, "%s %s (%ld bytes)\n", method, path, content_length);
+
+        // Body: only its size matters. What follows it is the next request.
+        if (expect_continue && !send_text(fd, "HTTP/1.1 100 Continue\r\n\r\n")) goto done;
+        char *tail = buffer + header_len;
+        size_t tail_len = have - header_len;
+        size_t remaining = content_length > 0 ? (size_t)content_length : 0;
+        while (remaining > tail_len) {
+            remaining -= tail_len;
+            ssize_t n = recv(fd, buffer, MAX_HEADER, 0);
+            if (n < 0 && errno == EINTR) n = 0;
+            else if (n <= 0) goto done;
+            tail = buffer;
+            tail_len = n;
+        }
+        have = tail_len - remaining;
+        memmove(buffer, tail + remaining, have);
+
+        int ok;
+        char *colon = strrchr(path, ':');
+        if (strcmp(method, "HEAD") == 0 || strcmp(method, "GET") == 0) {
+            // The engine's connection warm-up
+            ok = send_text(fd, "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\n\r\n");
+        } else if (strcmp(method, "POST") != 0 || !colon ||
+                   (strncmp(colon, ":generateContent", 16) != 0 && strncmp(colon, ":streamGenerateContent", 22) != 0)) {
+            ok = send_error(fd, 404, "mock: unknown method");
+        } else {
+            sleep_ms(options.latency_ms + (options.jitter_ms > 0 ? rand_r(&seed) % (options.jitter_ms + 1) : 0));
+            if (chance(&seed) < options.error_rate) {
+                ok = send_error(fd, options.error_status, "mock: injected error");
+            } else {
+                int stream = strncmp(colon, ":streamGenerateContent", 22) == 0;
+                char **pieces;
+                size_t *lens;
+                const char *content_type;
+                int count = build_reply(stream, stream && strstr(colon, "alt=sse") != NULL, content_length / 4 + 1,
+                                        &pieces, &lens, &content_type);
+                int gzipped = options.gzip && accepts_gzip && count > 0 && gzip_pieces(pieces, lens, count);
+                ok = send_body(fd, content_type, gzipped, stream, pieces, lens, count, chance(&seed) < options.cut_rate);
+                free_pieces(pieces, lens, count);
+                __atomic_add_fetch(&served, 1, __ATOMIC_RELAXED);
+            }
+        }
+        if (!ok) break;
+    }
+done:
+    free(buffer);
+    close(fd);
+    return NULL;
+}
+
+// A recorded reply; response cache entries (SMCACHE1 header) are unwrapped
+static int load_replay(const char *path) {
+    if (replay_count == MAX_REPLAY) return 0;
+    FILE *file = fopen(path, "rb");
+    if (!file) return 0;
+    fseek(file, 0, SEEK_END);
+    long len = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    char *data = malloc(len > 0 ? len : 1);
+    size_t got = fread(data, 1, len, file);
+    fclose(file);
+    size_t skip = got >= 24 && memcmp(data, "SMCACHE1", 8) == 0 ? 24 : 0;
+    Replay *replay = &replays[replay_count++];
+    replay->len = got - skip;
+    replay->data = data;
+    memmove(data, data + skip, replay->len);
+    replay->sse = replay->len >= 5 && memcmp(data, "data:", 5) == 0;
+    return 1;
+}
+
+static void on_signal(int sig) {
+    stopping = 1;
+}
+
+static void usage(const char *name) {
+    fprintf(stderr, "Usage: %s [-p port] [-l latency_ms] [-j jitter_ms] [-c chunks] [-i interval_ms]\n"
+                    "          [-s reply_bytes] [-e error_rate] [-E status] [-x cut_rate] [-r reply_file]... [-z] [-v]\n", name);
+}
+
+int main(int argc, char *argv[]) {
+    int opt;
+    while ((opt = getopt(argc, argv, "p:l:j:c:i:s:e:E:x:r:zvh")) != -1) {
+        switch (opt) {
+        case 'p': options.port = atoi(optarg); break;
+        case 'l': options.latency_ms = atoi(optarg); break;
+        case 'j': options.jitter_ms = atoi(optarg); break;
+        case 'c': options.chunks = atoi(optarg); break;
+        case 'i': options.interval_ms = atoi(optarg); break;
+        case 's': options.size = (size_t)atol(optarg); break;
+        case 'e': options.error_rate = atof(optarg); break;
+        case 'E': options.error_status = atoi(optarg); break;
+        case 'x': options.cut_rate = atof(optarg); break;
+        case 'r':
+            if (!load_replay(optarg)) fprintf(stderr, "Could not load %s\n", optarg);
+            break;
+        case 'z': options.gzip = 1; break;
+        case 'v': options.verbose = 1; break;
+        default: usage(argv[0]); return opt == 'h' ? 0 : 1;
+        }
+    }
+
+    // Plain text, so it needs no JSON escaping
+    static const char filler[] = "Step 1: 25% of 480 = 480 / 4 = 120. Step 2: approximate 119.8 to 120. ";
+    text = malloc(options.size + 1);
+    for (size_t i = 0; i < options.size; i++) text[i] = filler[i % (sizeof(filler) - 1)];
+    text[options.size] = '\0';
+
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    int on = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    struct sockaddr_in addr = { 0 };
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(options.port);
+    if (bind(listener, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(listener, 128) != 0) {
+        perror("mock_server");
+        return 1;
+    }
+
+    struct sigaction action = { 0 };
+    action.sa_handler = on_signal;   // no SA_RESTART: accept returns on ^C
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+    fprintf(stderr, "Mock Gemini on http://127.0.0.1:%d/ (latency %d+%d ms, %d chunks every %d ms, %zu bytes, "
+                    "errors %.0f%%, cut %.0f%%, %d replay files%s)\n",
+            options.port, options.latency_ms, options.jitter_ms, options.chunks, options.interval_ms, options.size,
+            options.error_rate * 100, options.cut_rate * 100, replay_count, options.gzip ? ", gzip" : "");
+
+    while (!stopping) {
+        int fd = accept(listener, NULL, NULL);
+        if (fd < 0) continue;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+        pthread_t thread;
+        if (pthread_create(&thread, NULL, serve_connection, (void*)(long)fd) != 0) close(fd);
+        else pthread_detach(thread);
+    }
+    fprintf(stderr, "\nServed %lu replies (%lu cut off), %lu errors, %.1f MB sent\n",
+            served, cut, errors, bytes_out / 1e6);
+    return 0;
+}
@@ -0,0 +1,111 @@
+// Request body building: bytes copied and time per request.
+// gcc -O2 request_body_bench.c ../request_body.c ../gemini_json.c -o request_body_bench
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../gemini_json.h"
+#include "../request_body.h"
+
+#define ROUNDS 200000
+
+static const char *system_prompt =
+    "You are a speed maths coach for Indian banking exams (IBPS, SBI PO/Clerk, RRB). "
+    "Ask one multiple-choice question at a time on simplification, approximation, percentages, "
+    "squares and cubes or fractions, in the style of previous years' papers. Give four options "
+    "labelled A) to D) and wait for the answer. When answered, show the fastest exam shortcut "
+    "step by step, then the correct option.";
+
+static const char *default_query =
+    "give me simplification, approximation and speed math question for preparation practice for Indian banking exam. "
+    "You will give pyq question one question at a time and we will give the answer (give option also and do mention "
+    "that the option could be given wrong). After user sends an answer to you, you will give stepwise complete answer. "
+    "And then mention a note: for next question press 1 or any numeric or special character. If user did, then show "
+    "them the next question. One question at a time";
+
+static const char *tricky_query = "Solve \"12.5% of 640\"\nthen C:\\answers\\ \t(tab) \x01 done";
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Does body parse as one complete JSON document?
+static int valid_json(const char *body, size_t len) {
+    GeminiJson json;
+    gemini_json_init(&json, NULL, NULL);
+    return gemini_json_feed(&json, body, len) && gemini_json_finish(&json);
+}
+
+// The old way: one snprintf into a fixed buffer, no escaping
+static size_t build_snprintf(char *out, size_t size, const char *query) {
+    int n = snprintf(out, size, "{\"contents\": [{\"parts\": [{\"text\": \"%s\"}]}]}", query);
+    return (size_t)n < size ? (size_t)n : size - 1;
+}
+
+// Everything serialized again on every request
+static void build_full(RequestBody *body, const RequestOptions *options, const char *query) {
+    RequestTemplate tmpl;
+    request_template_init(&tmpl, options);
+    body->copied += tmpl.head_len;   // the template's bytes are work done for this request too
+    request_body_build(body, &tmpl, query);
+    request_template_free(&tmpl);
+}
+
+static void report(const char *name, double seconds, size_t copied, size_t len, int valid) {
+    printf("%-34s %8.1f ns/request  %6zu bytes copied/request  body %5zu bytes  %s\n",
+           name, seconds * 1e9 / ROUNDS, copied / ROUNDS, len, valid ? "valid JSON" : "INVALID JSON");
+}
+
+static void run(const char *label, const char *query) {
+    RequestOptions options = { system_prompt, 0.7, 1024 };
+    RequestTemplate tmpl;
+    request_template_init(&tmpl, &options);
+    printf("%s (%zu bytes of text, template head %zu bytes)\n", label, strlen(query), tmpl.head_len);
+
+    char fixed[1024];
+    size_t len = 0;
+    double start = now();
+    for (int i = 0; i < ROUNDS; i++) len = build_snprintf(fixed, sizeof(fixed), query);
+    double t = now() - start;
+    int full = strlen(query) + 43 < sizeof(fixed);
+    report(full ? "snprintf, 1024-byte buffer" : "snprintf, 1024-byte buffer (cut)", t, len * (size_t)ROUNDS, len,
+           valid_json(fixed, len));
+
+    RequestBody body;
+    request_body_init(&body);
+    start = now();
+    for (int i = 0; i < ROUNDS; i++) build_full(&body, &options, query);
+    t = now() - start;
+    report("full re-serialization", t, body.copied, body.len, valid_json(body.data, body.len));
+    request_body_free(&body);
+
+    // What main.c does: head + escaped text into one allocation, then stolen for curl
+    request_body_init(&body);
+    size_t copied = 0;
+    start = now();
+    for (int i = 0; i < ROUNDS; i++) {
+        request_body_build(&body, &tmpl, query);
+        copied += body.copied;
+        body.copied = 0;
+        size_t n;
+        free(request_body_steal(&body, &n));
+        len = n;
+    }
+    t = now() - start;
+    request_body_build(&body, &tmpl, query);
+    report("template + steal (per request)", t, copied, len, valid_json(body.data, body.len));
+    request_body_free(&body);
+
+    // Prefetches: one body built once and shared by reference
+    report("shared prefetch body", 0, 0, len, 1);
+    request_template_free(&tmpl);
+    printf("\n");
+}
+
+int main(void) {
+    run("Default question prompt", default_query);
+    run("Prompt with quotes, newlines, backslashes", tricky_query);
+    return 0;
+}
@@ -0,0 +1,245 @@
+#define _GNU_SOURCE   // getline
+#include <ctype.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "config.h"
+
+typedef struct {
+    char *key;        // NULL for an empty slot
+    char *value;
+    uint32_t hash;
+} ConfigEntry;
+
+struct Config {
+    ConfigEntry *entries;   // open addressing, capacity is a power of two
+    size_t capacity;
+    size_t count;
+    char *sources[CONFIG_MAX_PATHS];
+    size_t source_count;
+};
+
+static uint32_t hash_key(const char *key) {
+    uint32_t h = 2166136261u;   // FNV-1a
+    for (; *key; key++) h = (h ^ (unsigned char)*key) * 16777619u;
+    return h;
+}
+
+static ConfigEntry* find_slot(const ConfigEntry *entries, size_t capacity, const char *key, uint32_t hash) {
+    size_t mask = capacity - 1;
+    for (size_t i = hash & mask;; i = (i + 1) & mask) {
+        const ConfigEntry *e = &entries[i];
+        if (!e->key || (e->hash == hash && strcmp(e->key, key) == 0))
+            return (ConfigEntry *)e;
+    }
+}
+
+static int grow(Config *config) {
+    size_t capacity = config->capacity ? config->capacity * 2 : 16;
+    ConfigEntry *entries = calloc(capacity, sizeof(ConfigEntry));
+    if (!entries) return 0;
+    for (size_t i = 0; i < config->capacity; i++) {
+        if (config->entries[i].key)
+            *find_slot(entries, capacity, config->entries[i].key, config->entries[i].hash) = config->entries[i];
+    }
+    free(config->entries);
+    config->entries = entries;
+    config->capacity = capacity;
+    return 1;
+}
+
+// Insert or replace; takes ownership of value
+static int set(Config *config, const char *key, char *value) {
+    if ((config->count + 1) * 2 > config->capacity && !grow(config)) {
+        free(value);
+        return 0;
+    }
+    uint32_t hash = hash_key(key);
+    ConfigEntry *e = find_slot(config->entries, config->capacity, key, hash);
+    if (e->key) {
+        free(e->value);
+        e->value = value;
+        return 1;
+    }
+    e->key = strdup(key);
+    if (!e->key) {
+        free(value);
+        return 0;
+    }
+    e->value = value;
+    e->hash = hash;
+    config->count++;
+    return 1;
+}
+
+// Value after '=': quoted or bare; returns a new string
+static char* parse_value(const char *p) {
+    size_t len = strlen(p);
+    char *out = malloc(len + 1);
+    if (!out) return NULL;
+    size_t n = 0;
+
+    if (*p == '"') {
+        for (p++; *p && *p != '"'; p++) {
+            char c = *p;
+            if (c == '\\' && p[1]) {
+                c = *++p;
+                if (c == 'n') c = '\n';
+                else if (c == 't') c = '\t';
+                else if (c == 'r') c = '\r';
+            }
+            out[n++] = c;
+        }
+    } else if (*p == '\'') {
+        for (p++; *p && *p != '\''; p++) out[n++] = *p;
+    } else {
+        for (; *p && *p != '\r' && *p != '\n'; p++) {
+            if (*p == '#' && n > 0 && isspace((unsigned char)out[n - 1])) break;
+            out[n++] = *p;
+        }
+        while (n > 0 && isspace((unsigned char)out[n - 1])) n--;
+    }
+    out[n] = '\0';
+    return out;
+}
+
+static int parse_line(Config *config, char *line) {
+    char *p = line;
+    while (isspace((unsigned char)*p)) p++;
+    if (*p == '#' || *p == '\0') return 1;
+    if (strncmp(p, "export", 6) == 0 && (p[6] == ' ' || p[6] == '\t'))
+        for (p += 6; isspace((unsigned char)*p); p++) {}
+
+    char *key = p;
+    while (*p && *p != '=' && !isspace((unsigned char)*p)) p++;
+    char *key_end = p;
+    while (*p == ' ' || *p == '\t') p++;
+    if (*p != '=' || key_end == key) return 1;   // not a setting: ignore the line
+    *key_end = '\0';
+    for (p++; *p == ' ' || *p == '\t'; p++) {}
+
+    char *value = parse_value(p);
+    return value && set(config, key, value);
+}
+
+static int parse_file(Config *config, const char *path) {
+    FILE *file = fopen(path, "r");
+    if (!file) return 1;
+
+    char *line = NULL;
+    size_t size = 0;
+    int ok = 1, first = 1;
+    while (ok && getline(&line, &size, file) != -1) {
+        char *start = line;
+        if (first && (unsigned char)start[0] == 0xEF && (unsigned char)start[1] == 0xBB && (unsigned char)start[2] == 0xBF)
+            start += 3;   // UTF-8 byte order mark
+        first = 0;
+        ok = parse_line(config, start);
+    }
+    free(line);
+    fclose(file);
+    return ok ? 2 : 0;
+}
+
+Config* config_load(const char *const *paths, size_t count) {
+    Config *config = calloc(1, sizeof(Config));
+    if (!config || !grow(config)) {
+        free(config);
+        return NULL;
+    }
+    if (count > CONFIG_MAX_PATHS) count = CONFIG_MAX_PATHS;
+
+    // Lowest priority first, so higher priority files override
+    int parsed[CONFIG_MAX_PATHS] = { 0 };
+    for (size_t i = count; i-- > 0;) {
+        parsed[i] = parse_file(config, paths[i]);
+        if (!parsed[i]) {
+            config_free(config);
+            return NULL;
+        }
+    }
+    for (size_t i = 0; i < count; i++)
+        if (parsed[i] == 2) config->sources[config->source_count++] = strdup(paths[i]);
+    return config;
+}
+
+void config_free(Config *config) {
+    if (!config) return;
+    for (size_t i = 0; i < config->capacity; i++) {
+        free(config->entries[i].key);
+        free(config->entries[i].value);
+    }
+    for (size_t i = 0; i < config->source_count; i++) free(config->sources[i]);
+    free(config->entries);
+    free(config);
+}
+
+const char* config_get(const Config *config, const char *key) {
+    if (!config) return NULL;
+    const ConfigEntry *e = find_slot(config->entries, config->capacity, key, hash_key(key));
+    return e->key ? e->value : NULL;
+}
+
+long config_get_long(const Config *config, const char *key, long fallback) {
+    const char *value = config_get(config, key);
+    if (!value || !*value) return fallback;
+    char *end;
+    long result = strtol(value, &end, 10);
+    return *end ? fallback : result;
+}
+
+double config_get_double(const Config *config, const char *key, double fallback) {
+    const char *value = config_get(config, key);
+    if (!value || !*value) return fallback;
+    char *end;
+    double result = strtod(value, &end);
+    return *end ? fallback : result;
+}
+
+size_t config_count(const Config *config) {
+    return config ? config->count : 0;
+}
+
+size_t config_sources(const Config *config, const char **paths, size_t max) {
+    size_t n = 0;
+    for (; config && n < config->source_count && n < max; n++) paths[n] = config->sources[n];
+    return n;
+}
+
+size_t config_default_paths(char paths[CONFIG_MAX_PATHS][512]) {
+    size_t n = 0;
+    const char *custom = getenv("SPEEDMATH_ENV");
+    if (custom && *custom) snprintf(paths[n++], 512, "%s", custom);
+
+    const char *home = getenv("HOME");
+    if (home) {
+        snprintf(paths[n++], 512, "%s/Desktop/speedmath/.env", home);
+        snprintf(paths[n++], 512, "%s/Desktop/.env", home);
+        snprintf(paths[n++], 512, "%s/.env", home);
+    }
+    return n;
+}
+
+static Config *default_config;
+static pthread_once_t default_once = PTHREAD_ONCE_INIT;
+
+static void load_default(void) {
+    char paths[CONFIG_MAX_PATHS][512];
+    const char *list[CONFIG_MAX_PATHS];
+    size_t count = config_default_paths(paths);
+    for (size_t i = 0; i < count; i++) list[i] = paths[i];
+    default_config = config_load(list, count);
+}
+
+const Config* config_default(void) {
+    pthread_once(&default_once, load_default);
+    return default_config;
+}
+
+const char* config_api_key(const Config *config) {
+    const char *key = config_get(config, "GEMINI_API_KEY");
+    if (!key || !*key) key = config_get(config, "key");
+    return key && *key ? key : NULL;
+}
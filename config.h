@@ -0,0 +1,47 @@
+// config.h
+#ifndef CONFIG_H
+#define CONFIG_H
+
+#include <stddef.h>
+
+// Settings parsed once from .env files into an immutable hash table.
+// Lookups never touch the files again and are safe from any thread; values
+// are owned by the table and live as long as it does.
+//
+// File syntax, one setting per line:
+//   KEY=value                 surrounding spaces are trimmed
+//   export KEY=value          shell-style prefix is ignored
+//   KEY="a \"quoted\" value"  double quotes: \n \t \" \\ escapes
+//   KEY='literal $value'      single quotes: taken as is
+//   # comment                 also after an unquoted value ("KEY=1 # note")
+// Later lines override earlier ones within a file.
+typedef struct Config Config;
+
+#define CONFIG_MAX_PATHS 4
+
+// Parse files in priority order: a key from an earlier path wins. Missing
+// files are skipped; returns NULL only when out of memory.
+Config* config_load(const char *const *paths, size_t count);
+void config_free(Config *config);
+
+// Value for key, or NULL
+const char* config_get(const Config *config, const char *key);
+long config_get_long(const Config *config, const char *key, long fallback);
+double config_get_double(const Config *config, const char *key, double fallback);
+
+size_t config_count(const Config *config);
+// Files that existed and were parsed, in priority order
+size_t config_sources(const Config *config, const char **paths, size_t max);
+
+// Standard locations, highest priority first: $SPEEDMATH_ENV,
+// ~/Desktop/speedmath/.env, ~/Desktop/.env, ~/.env. Returns the count.
+size_t config_default_paths(char paths[CONFIG_MAX_PATHS][512]);
+
+// Process-wide config from the standard locations, loaded on first use
+// (thread-safe) and kept until exit
+const Config* config_default(void);
+
+// Gemini API key: GEMINI_API_KEY, or the older "key" name
+const char* config_api_key(const Config *config);
+
+#endif
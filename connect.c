@@ -1,16 +1,12 @@
 #include <stdio.h>
-#include <stdlib.h> // Include for getenv
-#include "env_loader.h"
+#include <string.h>
+#include "config.h"
 
 int main() {
-    // Dynamically construct the path to the .env file
-    char env_file[256];
-    snprintf(env_file, sizeof(env_file), "%s.env", getenv("HOME")); // Adjust path for non-Linux systems
-
-    // Fetch the API key
-    const char* api_key = get_env_variable(env_file, "GEMINI_API_KEY");
+    // Fetch the API key from the first .env that has one
+    const char* api_key = config_api_key(config_default());
     if (api_key) {
-        printf("Loaded API Key: %s\n", api_key);
+        printf("Loaded API Key (%zu characters)\n", strlen(api_key));  // never the key itself
     } else {
         fprintf(stderr, "Failed to load API Key.\n");
         return 1;  // Exit with error
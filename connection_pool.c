@@ -0,0 +1,82 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "connection_pool.h"
+
+#define MAX_HOST_CONNECTIONS 4
+#define MAX_STREAMS_PER_CONNECTION 100   // HTTP/2
+#define MAX_IDLE_CONNECTIONS 8
+#define DNS_CACHE_SECONDS 600L
+#define MAX_CONNECTION_AGE_SECONDS 300L
+#define KEEPALIVE_IDLE_SECONDS 60L
+#define KEEPALIVE_INTERVAL_SECONDS 30L
+
+struct ConnectionPool {
+    CURLSH *share;
+    ConnectionStats stats;
+    int multiplexed;        // the host answered over HTTP/2 (or later)
+};
+
+ConnectionPool* connection_pool_new(void) {
+    ConnectionPool *pool = calloc(1, sizeof(ConnectionPool));
+    if (!pool) return NULL;
+
+    // Every handle runs on the main loop, so the share needs no lock callbacks
+    pool->share = curl_share_init();
+    if (!pool->share) {
+        fprintf(stderr, "Error: Failed to initialize CURL share handle\n");
+        free(pool);
+        return NULL;
+    }
+    curl_share_setopt(pool->share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    curl_share_setopt(pool->share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+    curl_share_setopt(pool->share, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+    return pool;
+}
+
+void connection_pool_free(ConnectionPool *pool) {
+    if (!pool) return;
+    curl_share_cleanup(pool->share);
+    free(pool);
+}
+
+void connection_pool_setup_multi(ConnectionPool *pool, CURLM *multi) {
+    curl_multi_setopt(multi, CURLMOPT_PIPELINING, (long)CURLPIPE_MULTIPLEX);
+    curl_multi_setopt(multi, CURLMOPT_MAX_HOST_CONNECTIONS, (long)MAX_HOST_CONNECTIONS);
+    curl_multi_setopt(multi, CURLMOPT_MAXCONNECTS, (long)MAX_IDLE_CONNECTIONS);
+    curl_multi_setopt(multi, CURLMOPT_MAX_CONCURRENT_STREAMS, (long)MAX_STREAMS_PER_CONNECTION);
+}
+
+void connection_pool_setup_easy(ConnectionPool *pool, CURL *easy) {
+    curl_easy_setopt(easy, CURLOPT_SHARE, pool->share);
+    curl_easy_setopt(easy, CURLOPT_HTTP_VERSION, (long)CURL_HTTP_VERSION_2TLS);
+    // Wait for an existing connection to multiplex on rather than opening
+    // another, once the host is known to multiplex; on HTTP/1.1 there is
+    // nothing to wait for
+    curl_easy_setopt(easy, CURLOPT_PIPEWAIT, pool->multiplexed ? 1L : 0L);
+    curl_easy_setopt(easy, CURLOPT_DNS_CACHE_TIMEOUT, DNS_CACHE_SECONDS);
+    curl_easy_setopt(easy, CURLOPT_MAXAGE_CONN, MAX_CONNECTION_AGE_SECONDS);
+    curl_easy_setopt(easy, CURLOPT_TCP_KEEPALIVE, 1L);
+    curl_easy_setopt(easy, CURLOPT_TCP_KEEPIDLE, KEEPALIVE_IDLE_SECONDS);
+    curl_easy_setopt(easy, CURLOPT_TCP_KEEPINTVL, KEEPALIVE_INTERVAL_SECONDS);
+}
+
+void connection_pool_record(ConnectionPool *pool, CURL *easy) {
+    long version = 0;
+    if (curl_easy_getinfo(easy, CURLINFO_HTTP_VERSION, &version) == CURLE_OK && version >= CURL_HTTP_VERSION_2_0)
+        pool->multiplexed = 1;
+    long new_connections = 0;
+    if (curl_easy_getinfo(easy, CURLINFO_NUM_CONNECTS, &new_connections) != CURLE_OK)
+        return;
+    if (new_connections > 0)
+        pool->stats.fresh++;
+    else
+        pool->stats.reused++;
+}
+
+unsigned connection_pool_transfer_limit(const ConnectionPool *pool) {
+    return pool->multiplexed ? MAX_HOST_CONNECTIONS * MAX_STREAMS_PER_CONNECTION : MAX_HOST_CONNECTIONS;
+}
+
+ConnectionStats connection_pool_stats(const ConnectionPool *pool) {
+    return pool->stats;
+}
@@ -0,0 +1,38 @@
+// connection_pool.h
+#ifndef CONNECTION_POOL_H
+#define CONNECTION_POOL_H
+
+#include <curl/curl.h>
+
+// Long-lived connection state shared by every request: DNS cache, TLS
+// sessions and open (HTTP/2 multiplexed, keep-alive) connections.
+typedef struct ConnectionPool ConnectionPool;
+
+typedef struct {
+    unsigned long reused;   // transfers that ran on an already open connection
+    unsigned long fresh;    // transfers that had to open a new connection
+} ConnectionStats;
+
+ConnectionPool* connection_pool_new(void);
+void connection_pool_free(ConnectionPool *pool);
+
+// Apply pool settings to the multi handle (multiplexing, connection limits)
+void connection_pool_setup_multi(ConnectionPool *pool, CURLM *multi);
+
+// Apply pool settings to an easy handle before it is added to the multi handle
+void connection_pool_setup_easy(ConnectionPool *pool, CURL *easy);
+
+// Account a finished transfer as reused or fresh, and learn whether the
+// host multiplexes
+void connection_pool_record(ConnectionPool *pool, CURL *easy);
+
+// Transfers that can run at once without curl holding some back for a
+// connection: one per connection on HTTP/1.1, many once the host has
+// answered over HTTP/2. curl does not start held-back transfers in order,
+// so one can wait until the others are all done; the engine queues the
+// rest itself.
+unsigned connection_pool_transfer_limit(const ConnectionPool *pool);
+
+ConnectionStats connection_pool_stats(const ConnectionPool *pool);
+
+#endif
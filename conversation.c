@@ -0,0 +1,163 @@
+#include <stdlib.h>
+#include <string.h>
+#include "conversation.h"
+
+#define DEFAULT_INSTRUCTION "Practice question:"   // Gemini wants the first turn from the user
+
+void conversation_init(Conversation *conv, const char *instruction, size_t budget_tokens) {
+    memset(conv, 0, sizeof(*conv));
+    conv->instruction = instruction && *instruction ? instruction : DEFAULT_INSTRUCTION;
+    conv->budget = budget_tokens ? budget_tokens : CONVERSATION_DEFAULT_BUDGET;
+    conv->bytes_per_token = CONVERSATION_BYTES_PER_TOKEN;
+}
+
+void conversation_free(Conversation *conv) {
+    free(conv->text);
+    conv->text = NULL;
+    conv->text_len = conv->text_cap = 0;
+    conv->count = 0;
+}
+
+void conversation_clear(Conversation *conv) {
+    conv->count = 0;
+    conv->text_len = 0;
+    conv->question++;
+}
+
+// Keep text as a turn, with whitespace runs folded to one character (a
+// newline if the run had one): replies are full of blank lines and indents
+// that cost tokens and say nothing
+static int keep_turn(Conversation *conv, char role, const char *text, size_t len) {
+    if (!conv->text || conv->text_len + len > conv->text_cap) {
+        size_t cap = conv->text_cap ? conv->text_cap : 1024;
+        while (cap < conv->text_len + len) cap *= 2;
+        char *grown = realloc(conv->text, cap);
+        if (!grown) return 0;
+        conv->text = grown;
+        conv->text_cap = cap;
+    }
+    char *out = conv->text + conv->text_len, *start = out;
+    const char *end = text + len;
+    while (text < end) {
+        if (*text != ' ' && *text != '\n' && *text != '\t' && *text != '\r') {
+            *out++ = *text++;
+            continue;
+        }
+        char fold = ' ';
+        for (; text < end && (*text == ' ' || *text == '\n' || *text == '\t' || *text == '\r'); text++)
+            if (*text == '\n') fold = '\n';
+        if (out > start && text < end) *out++ = fold;   // none at either end
+    }
+    ConversationTurn *turn = &conv->turns[conv->count++];
+    turn->role = role;
+    turn->offset = start - conv->text;
+    turn->len = out - start;
+    conv->text_len += turn->len;
+    return 1;
+}
+
+// Forget turns [first, first + n) and the text they held
+static void drop_turns(Conversation *conv, int first, int n) {
+    if (n <= 0) return;
+    size_t from = conv->turns[first].offset;
+    size_t to = first + n < conv->count ? conv->turns[first + n].offset : conv->text_len;
+    memmove(conv->text + from, conv->text + to, conv->text_len - to);
+    conv->text_len -= to - from;
+    for (int i = first + n; i < conv->count; i++) {
+        conv->turns[i - n] = conv->turns[i];
+        conv->turns[i - n].offset -= to - from;
+    }
+    conv->count -= n;
+}
+
+void conversation_begin(Conversation *conv, const char *question, size_t len) {
+    conversation_clear(conv);
+    keep_turn(conv, 'm', question, len);
+}
+
+size_t conversation_estimate_tokens(const Conversation *conv, size_t bytes) {
+    return (size_t)(bytes / conv->bytes_per_token) + 1;
+}
+
+static int add_turn(RequestBody *body, const Conversation *conv, int i) {
+    const ConversationTurn *turn = &conv->turns[i];
+    return request_body_add_turn(body, turn->role == 'u' ? "user" : "model", conv->text + turn->offset, turn->len);
+}
+
+int conversation_ask(Conversation *conv, RequestBody *body, const RequestTemplate *tmpl,
+                     const char *text, size_t len) {
+    // No question: nothing to keep, the text goes alone
+    if (conv->count == 0) {
+        if (!request_body_begin(body, tmpl, len) || !request_body_add_turn(body, "user", text, len) ||
+            !request_body_end(body))
+            return 0;
+        conv->stats.requests++;
+        conv->stats.turns_sent++;
+        conv->stats.bytes_sent += body->len;
+        conv->stats.last_bytes = body->len;
+        conv->stats.last_turns = 1;
+        return 1;
+    }
+
+    // An ask that never got its reply is replaced, so user and model keep alternating
+    if (conv->turns[conv->count - 1].role == 'u') drop_turns(conv, conv->count - 1, 1);
+    // Full: the oldest exchange after the question goes (room for the ask and its reply)
+    if (conv->count + 2 > CONVERSATION_MAX_TURNS) drop_turns(conv, 1, 2);
+    if (!keep_turn(conv, 'u', text, len)) return 0;
+
+    // The instruction, the question and the new turn always go; earlier
+    // exchanges are added newest first while they fit
+    size_t instruction_len = strlen(conv->instruction);
+    const ConversationTurn *question = &conv->turns[0], *asked = &conv->turns[conv->count - 1];
+    size_t tokens = conversation_estimate_tokens(conv, instruction_len) +
+                    conversation_estimate_tokens(conv, question->len) +
+                    conversation_estimate_tokens(conv, asked->len);
+    int first = conv->count - 1;    // oldest turn after the question that is sent
+    while (first - 2 >= 1) {
+        size_t pair = conversation_estimate_tokens(conv, conv->turns[first - 2].len) +
+                      conversation_estimate_tokens(conv, conv->turns[first - 1].len);
+        if (tokens + pair > conv->budget) break;
+        tokens += pair;
+        first -= 2;
+    }
+
+    size_t text_bytes = instruction_len + (conv->text_len - conv->turns[first].offset) + question->len;
+    if (!request_body_begin(body, tmpl, text_bytes) ||
+        !request_body_add_turn(body, "user", conv->instruction, instruction_len) ||
+        !add_turn(body, conv, 0))
+        return 0;
+    for (int i = first; i < conv->count; i++)
+        if (!add_turn(body, conv, i)) return 0;
+    if (!request_body_end(body)) return 0;
+
+    int sent = 2 + conv->count - first;
+    conv->stats.requests++;
+    conv->stats.turns_sent += sent;
+    conv->stats.turns_trimmed += first - 1;
+    conv->stats.bytes_sent += body->len;
+    conv->stats.last_bytes = body->len;
+    conv->stats.last_turns = sent;
+    conv->last_text_bytes = text_bytes;
+    return 1;
+}
+
+void conversation_reply(Conversation *conv, unsigned long question, const char *text, size_t len) {
+    if (question != conv->question || conv->count == 0 || conv->count == CONVERSATION_MAX_TURNS ||
+        conv->turns[conv->count - 1].role != 'u')
+        return;
+    keep_turn(conv, 'm', text, len);
+}
+
+void conversation_observe(Conversation *conv, long prompt_tokens) {
+    if (prompt_tokens <= 0 || !conv->last_text_bytes) return;
+    // The count includes the system prompt, so the ratio errs towards more tokens
+    double ratio = (double)conv->last_text_bytes / prompt_tokens;
+    if (ratio < 1.0) ratio = 1.0;
+    if (ratio > 8.0) ratio = 8.0;
+    conv->bytes_per_token = 0.8 * conv->bytes_per_token + 0.2 * ratio;
+    conv->last_text_bytes = 0;
+}
+
+ConversationStats conversation_stats(const Conversation *conv) {
+    return conv->stats;
+}
@@ -0,0 +1,68 @@
+// conversation.h
+#ifndef CONVERSATION_H
+#define CONVERSATION_H
+
+#include <stddef.h>
+#include "request_body.h"
+
+#define CONVERSATION_MAX_TURNS 32               // older turns are dropped in pairs
+#define CONVERSATION_DEFAULT_BUDGET 2048        // tokens of contents per request
+#define CONVERSATION_BYTES_PER_TOKEN 4.0        // starting estimate, refined from usage counts
+
+// The turns about the question on screen, so a reply or a follow-up can be
+// sent with just enough context to be graded. Each request carries:
+//   user:  the instruction (short, not the prompt that asked for the question)
+//   model: the question as it was shown
+//   ...    the newest earlier turns that fit the token budget
+//   user:  the new text
+// Everything about the previous question is dropped when the next one starts.
+typedef struct {
+    char role;          // 'u' user, 'm' model
+    size_t offset;      // into text
+    size_t len;
+} ConversationTurn;
+
+typedef struct {
+    unsigned long requests;
+    unsigned long turns_sent;      // turns in request bodies, new and resent
+    unsigned long turns_trimmed;   // turns left out to stay within the budget
+    unsigned long bytes_sent;      // request body bytes
+    size_t last_bytes;             // the latest request body
+    int last_turns;
+} ConversationStats;
+
+typedef struct {
+    const char *instruction;       // first user turn of every request; not copied
+    size_t budget;                 // tokens
+    double bytes_per_token;
+    unsigned long question;        // bumped for every new question, to spot stale replies
+    ConversationTurn turns[CONVERSATION_MAX_TURNS];
+    int count;                     // turns[0] is the question once there is one
+    char *text;                    // every turn's text back to back
+    size_t text_len, text_cap;
+    size_t last_text_bytes;        // turn text in the latest request, for conversation_observe
+    ConversationStats stats;
+} Conversation;
+
+void conversation_init(Conversation *conv, const char *instruction, size_t budget_tokens);
+void conversation_free(Conversation *conv);
+
+// A new question is on screen: the turns about the old one are dropped
+void conversation_begin(Conversation *conv, const char *question, size_t len);
+// Nothing to talk about until the next conversation_begin
+void conversation_clear(Conversation *conv);
+
+// Request body for a new user turn after the kept turns. The turn is kept
+// too; a second ask without a reply in between replaces it.
+int conversation_ask(Conversation *conv, RequestBody *body, const RequestTemplate *tmpl,
+                     const char *text, size_t len);
+// The model's answer to the latest ask; ignored if that ask was for another
+// question (pass the question number read before asking)
+void conversation_reply(Conversation *conv, unsigned long question, const char *text, size_t len);
+// Prompt token count Gemini reported for the latest request, to refine the estimate
+void conversation_observe(Conversation *conv, long prompt_tokens);
+
+size_t conversation_estimate_tokens(const Conversation *conv, size_t bytes);
+ConversationStats conversation_stats(const Conversation *conv);
+
+#endif
@@ -1,32 +1,51 @@
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include "config.h"
+#include "env_loader.h"
 
-#define MAX_ENV_VAR_LENGTH 256
+#define MAX_ENV_FILES 8
+
+// Each file is parsed once; the tables live until exit so returned values stay valid
+static struct {
+    char *path;
+    Config *config;
+} loaded[MAX_ENV_FILES];
+static size_t loaded_count;
+static pthread_mutex_t loaded_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static const Config* config_for(const char *env_file) {
+    const Config *config = NULL;
+    pthread_mutex_lock(&loaded_lock);
+    for (size_t i = 0; i < loaded_count && !config; i++)
+        if (strcmp(loaded[i].path, env_file) == 0) config = loaded[i].config;
+    if (!config && loaded_count < MAX_ENV_FILES) {
+        Config *parsed = config_load(&env_file, 1);
+        char *path = strdup(env_file);
+        if (parsed && path) {
+            loaded[loaded_count].path = path;
+            loaded[loaded_count].config = parsed;
+            loaded_count++;
+            config = parsed;
+        } else {
+            config_free(parsed);
+            free(path);
+        }
+    }
+    pthread_mutex_unlock(&loaded_lock);
+    return config;
+}
 
 // Function to fetch an environment variable from a .env file
-char* get_env_variable(const char* env_file, const char* key) {
-    static char value[MAX_ENV_VAR_LENGTH];
-    FILE *file = fopen(env_file, "r");
-    if (!file) {
+const char* get_env_variable(const char* env_file, const char* key) {
+    const Config *config = config_for(env_file);
+    const char *source;
+    if (!config || config_sources(config, &source, 1) == 0) {
         fprintf(stderr, "Error: Could not open %s\n", env_file);
         return NULL;
     }
-
-    char line[MAX_ENV_VAR_LENGTH];
-    while (fgets(line, sizeof(line), file)) {
-        char *equals = strchr(line, '=');
-        if (equals) {
-            *equals = '\0';  // Split key and value
-            if (strcmp(line, key) == 0) {
-                strncpy(value, equals + 1, MAX_ENV_VAR_LENGTH);
-                value[strcspn(value, "\r\n")] = '\0'; // Remove newline
-                fclose(file);
-                return value;
-            }
-        }
-    }
-    fclose(file);
-    fprintf(stderr, "Error: Key '%s' not found in %s\n", key, env_file);
-    return NULL;
+    const char *value = config_get(config, key);
+    if (!value) fprintf(stderr, "Error: Key '%s' not found in %s\n", key, env_file);
+    return value;
 }
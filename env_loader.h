@@ -2,6 +2,8 @@
 #ifndef ENV_LOADER_H
 #define ENV_LOADER_H
 
-char* get_env_variable(const char* env_file, const char* key);
+// Value of key in env_file, or NULL. Each file is parsed once (see config.h);
+// the returned string stays valid until exit. Thread-safe.
+const char* get_env_variable(const char* env_file, const char* key);
 
 #endif
@@ -0,0 +1,364 @@
+#include <stdlib.h>
+#include <string.h>
+#include "gemini_json.h"
+
+enum { STATE_VALUE, STATE_STRING, STATE_ESCAPE, STATE_UNICODE, STATE_SCALAR, STATE_FAILED };
+
+// Keys worth telling apart; everything else is KEY_OTHER
+enum {
+    KEY_NONE, KEY_OTHER, KEY_CANDIDATES, KEY_CONTENT, KEY_PARTS, KEY_TEXT, KEY_FINISH_REASON,
+    KEY_USAGE, KEY_PROMPT_TOKENS, KEY_CANDIDATES_TOKENS, KEY_TOTAL_TOKENS,
+    KEY_ERROR, KEY_CODE, KEY_MESSAGE, KEY_STATUS, KEY_PROMPT_FEEDBACK, KEY_BLOCK_REASON,
+    KEY_ARRAY = 0xFF   // in a path: any array element
+};
+
+static const struct { const char *name; unsigned char key; } key_names[] = {
+    { "candidates", KEY_CANDIDATES }, { "content", KEY_CONTENT }, { "parts", KEY_PARTS },
+    { "text", KEY_TEXT }, { "finishReason", KEY_FINISH_REASON }, { "usageMetadata", KEY_USAGE },
+    { "promptTokenCount", KEY_PROMPT_TOKENS }, { "candidatesTokenCount", KEY_CANDIDATES_TOKENS },
+    { "totalTokenCount", KEY_TOTAL_TOKENS }, { "error", KEY_ERROR }, { "code", KEY_CODE },
+    { "message", KEY_MESSAGE }, { "status", KEY_STATUS }, { "promptFeedback", KEY_PROMPT_FEEDBACK },
+    { "blockReason", KEY_BLOCK_REASON },
+};
+
+// What the value being read is
+enum {
+    ROLE_NONE, ROLE_KEY, ROLE_TEXT, ROLE_FINISH_REASON, ROLE_BLOCK_REASON, ROLE_ERROR_MESSAGE,
+    ROLE_ERROR_STATUS, ROLE_ERROR_CODE, ROLE_PROMPT_TOKENS, ROLE_CANDIDATES_TOKENS, ROLE_TOTAL_TOKENS
+};
+
+// Key path (from the reply object down) leading to each value of interest
+static const struct { unsigned char role; unsigned char length; unsigned char path[6]; } paths[] = {
+    { ROLE_TEXT, 6, { KEY_CANDIDATES, KEY_ARRAY, KEY_CONTENT, KEY_PARTS, KEY_ARRAY, KEY_TEXT } },
+    { ROLE_FINISH_REASON, 3, { KEY_CANDIDATES, KEY_ARRAY, KEY_FINISH_REASON } },
+    { ROLE_PROMPT_TOKENS, 2, { KEY_USAGE, KEY_PROMPT_TOKENS } },
+    { ROLE_CANDIDATES_TOKENS, 2, { KEY_USAGE, KEY_CANDIDATES_TOKENS } },
+    { ROLE_TOTAL_TOKENS, 2, { KEY_USAGE, KEY_TOTAL_TOKENS } },
+    { ROLE_ERROR_CODE, 2, { KEY_ERROR, KEY_CODE } },
+    { ROLE_ERROR_MESSAGE, 2, { KEY_ERROR, KEY_MESSAGE } },
+    { ROLE_ERROR_STATUS, 2, { KEY_ERROR, KEY_STATUS } },
+    { ROLE_BLOCK_REASON, 2, { KEY_PROMPT_FEEDBACK, KEY_BLOCK_REASON } },
+};
+
+static unsigned char lookup_key(const char *name, size_t len) {
+    if (len > GEMINI_JSON_KEY_LENGTH) return KEY_OTHER;
+    for (size_t i = 0; i < sizeof(key_names) / sizeof(key_names[0]); i++)
+        if (strlen(key_names[i].name) == len && memcmp(key_names[i].name, name, len) == 0)
+            return key_names[i].key;
+    return KEY_OTHER;
+}
+
+// Role of a value starting at the current position
+static int value_role(const GeminiJson *json) {
+    if (json->depth > GEMINI_JSON_MAX_DEPTH) return ROLE_NONE;
+    int base = json->depth > 0 && json->kind[0] == '[';   // an array of replies
+    int length = json->depth - base;
+    if (length < 1 || json->kind[json->depth - 1] != '{') return ROLE_NONE;
+    for (size_t i = 0; i < sizeof(paths) / sizeof(paths[0]); i++) {
+        if (paths[i].length != length) continue;
+        int match = 1;
+        for (int level = 0; match && level < length; level++) {
+            unsigned char want = paths[i].path[level];
+            match = want == KEY_ARRAY ? json->kind[base + level] == '['
+                                      : json->kind[base + level] == '{' && json->key[base + level] == want;
+        }
+        if (match) return paths[i].role;
+    }
+    return ROLE_NONE;
+}
+
+// Hand over the decoded text; unless final, an unfinished UTF-8 sequence at
+// the end stays behind for the next call
+static void flush_text(GeminiJson *json, int final) {
+    size_t n = json->text_len;
+    if (!final) {
+        size_t i = n;
+        while (i > 0 && n - i < 3 && ((unsigned char)json->text[i - 1] & 0xC0) == 0x80) i--;
+        if (i > 0) {
+            unsigned char lead = (unsigned char)json->text[i - 1];
+            size_t need = lead >= 0xF0 ? 4 : lead >= 0xE0 ? 3 : lead >= 0xC0 ? 2 : 1;
+            if (need > n - (i - 1)) n = i - 1;
+        }
+    }
+    if (n && json->on_text) json->on_text(json->text, n, json->user_data);
+    memmove(json->text, json->text + n, json->text_len - n);
+    json->text_len -= n;
+}
+
+static void put_byte(GeminiJson *json, char c) {
+    switch (json->role) {
+    case ROLE_KEY:
+        if (json->scratch_len <= GEMINI_JSON_KEY_LENGTH) json->scratch[json->scratch_len++] = c;
+        break;
+    case ROLE_TEXT:
+        if (json->text_len == sizeof(json->text)) flush_text(json, 0);
+        json->text[json->text_len++] = c;
+        break;
+    case ROLE_NONE:
+        break;
+    default:
+        if (json->field && json->field_len + 1 < json->field_cap) json->field[json->field_len++] = c;
+        break;
+    }
+}
+
+static void put_codepoint(GeminiJson *json, unsigned long cp) {
+    if (cp < 0x80) {
+        put_byte(json, (char)cp);
+    } else if (cp < 0x800) {
+        put_byte(json, (char)(0xC0 | (cp >> 6)));
+        put_byte(json, (char)(0x80 | (cp & 0x3F)));
+    } else if (cp < 0x10000) {
+        put_byte(json, (char)(0xE0 | (cp >> 12)));
+        put_byte(json, (char)(0x80 | ((cp >> 6) & 0x3F)));
+        put_byte(json, (char)(0x80 | (cp & 0x3F)));
+    } else {
+        put_byte(json, (char)(0xF0 | (cp >> 18)));
+        put_byte(json, (char)(0x80 | ((cp >> 12) & 0x3F)));
+        put_byte(json, (char)(0x80 | ((cp >> 6) & 0x3F)));
+        put_byte(json, (char)(0x80 | (cp & 0x3F)));
+    }
+}
+
+// A high surrogate not followed by its low half
+static void drop_surrogate(GeminiJson *json) {
+    if (!json->high_surrogate) return;
+    json->high_surrogate = 0;
+    put_codepoint(json, 0xFFFD);
+}
+
+static void put_unicode(GeminiJson *json, unsigned long cp) {
+    if (cp >= 0xDC00 && cp <= 0xDFFF && json->high_surrogate) {
+        cp = 0x10000 + ((json->high_surrogate - 0xD800) << 10) + (cp - 0xDC00);
+        json->high_surrogate = 0;
+    } else {
+        drop_surrogate(json);
+        if (cp >= 0xD800 && cp <= 0xDBFF) {
+            json->high_surrogate = cp;
+            return;
+        }
+        if (cp >= 0xDC00 && cp <= 0xDFFF) cp = 0xFFFD;
+    }
+    put_codepoint(json, cp);
+}
+
+static int fail(GeminiJson *json) {
+    json->state = STATE_FAILED;
+    json->failed = 1;
+    return 0;
+}
+
+// A value has been read at the current level
+static void value_done(GeminiJson *json) {
+    json->role = ROLE_NONE;
+    json->field = NULL;
+    if (json->depth == 0) json->complete = 1;
+}
+
+static void begin_string(GeminiJson *json) {
+    json->state = STATE_STRING;
+    if (json->expect_key) {
+        json->role = ROLE_KEY;
+        json->scratch_len = 0;
+        return;
+    }
+    json->role = value_role(json);
+    json->field = NULL;
+    json->field_len = 0;
+    switch (json->role) {
+    case ROLE_FINISH_REASON: json->field = json->finish_reason; json->field_cap = sizeof(json->finish_reason); break;
+    case ROLE_BLOCK_REASON: json->field = json->block_reason; json->field_cap = sizeof(json->block_reason); break;
+    case ROLE_ERROR_MESSAGE: json->field = json->error_message; json->field_cap = sizeof(json->error_message); break;
+    case ROLE_ERROR_STATUS: json->field = json->error_status; json->field_cap = sizeof(json->error_status); break;
+    case ROLE_TEXT: break;
+    default: json->role = ROLE_NONE; break;   // numbers expected there; not ours to keep
+    }
+}
+
+static void end_string(GeminiJson *json) {
+    drop_surrogate(json);
+    json->state = STATE_VALUE;
+    if (json->role == ROLE_KEY) {
+        unsigned char key = lookup_key(json->scratch, json->scratch_len);
+        if (json->depth <= GEMINI_JSON_MAX_DEPTH) json->key[json->depth - 1] = key;
+        json->expect_key = 0;
+        json->role = ROLE_NONE;
+        return;
+    }
+    if (json->role == ROLE_TEXT) flush_text(json, 1);
+    if (json->field) json->field[json->field_len] = '\0';
+    value_done(json);
+}
+
+static int is_scalar_char(char c) {
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || c == '-' || c == '+' || c == '.' || c == 'E';
+}
+
+static int end_scalar(GeminiJson *json) {
+    json->state = STATE_VALUE;
+    json->scratch[json->scratch_len] = '\0';
+    const char *s = json->scratch;
+    if (strcmp(s, "true") != 0 && strcmp(s, "false") != 0 && strcmp(s, "null") != 0) {
+        char *end;
+        double value = strtod(s, &end);
+        if (*end || !(*s == '-' || (*s >= '0' && *s <= '9'))) return fail(json);
+        switch (json->role) {
+        case ROLE_PROMPT_TOKENS: json->usage.prompt_tokens = (long)value; break;
+        case ROLE_CANDIDATES_TOKENS: json->usage.candidates_tokens = (long)value; break;
+        case ROLE_TOTAL_TOKENS: json->usage.total_tokens = (long)value; break;
+        case ROLE_ERROR_CODE: json->error_code = (int)value; break;
+        }
+    }
+    value_done(json);
+    return 1;
+}
+
+// Structure and whitespace between strings and scalars
+static int structural(GeminiJson *json, char c) {
+    switch (c) {
+    case ' ': case '\t': case '\n': case '\r':
+        return 1;
+    case '{': case '[':
+        if (json->depth < GEMINI_JSON_MAX_DEPTH) {
+            json->kind[json->depth] = c;
+            json->key[json->depth] = KEY_NONE;
+        }
+        json->depth++;
+        json->expect_key = c == '{';
+        return 1;
+    case '}': case ']':
+        if (json->depth == 0) return fail(json);
+        if (json->depth <= GEMINI_JSON_MAX_DEPTH && json->kind[json->depth - 1] != (c == '}' ? '{' : '['))
+            return fail(json);
+        json->depth--;
+        json->expect_key = 0;
+        value_done(json);
+        return 1;
+    case ':':
+        return json->depth > 0 ? 1 : fail(json);
+    case ',':
+        if (json->depth == 0) return fail(json);
+        json->expect_key = json->depth <= GEMINI_JSON_MAX_DEPTH && json->kind[json->depth - 1] == '{';
+        return 1;
+    case '"':
+        begin_string(json);
+        return 1;
+    default:
+        if (!is_scalar_char(c) || json->expect_key) return fail(json);
+        json->state = STATE_SCALAR;
+        json->role = value_role(json);
+        json->scratch_len = 0;
+        json->scratch[json->scratch_len++] = c;
+        return 1;
+    }
+}
+
+static int hex_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+void gemini_json_init(GeminiJson *json, GeminiTextFunc on_text, void *user_data) {
+    memset(json, 0, sizeof(*json));
+    json->usage.prompt_tokens = json->usage.candidates_tokens = json->usage.total_tokens = -1;
+    json->on_text = on_text;
+    json->user_data = user_data;
+}
+
+int gemini_json_feed(GeminiJson *json, const char *data, size_t len) {
+    const char *p = data, *end = data + len;
+    while (p < end) {
+        switch (json->state) {
+        case STATE_FAILED:
+            return 0;
+        case STATE_VALUE:
+            if (!structural(json, *p++)) return 0;
+            break;
+        case STATE_STRING: {
+            // Plain runs are copied without looking at each byte twice
+            const char *run = p;
+            while (p < end && *p != '"' && *p != '\\') p++;
+            if (json->high_surrogate && p > run) drop_surrogate(json);
+            if (json->role == ROLE_TEXT) {
+                while (run < p) {
+                    if (json->text_len == sizeof(json->text)) flush_text(json, 0);
+                    size_t n = sizeof(json->text) - json->text_len;
+                    if (n > (size_t)(p - run)) n = (size_t)(p - run);
+                    memcpy(json->text + json->text_len, run, n);
+                    json->text_len += n;
+                    run += n;
+                }
+            } else if (json->role == ROLE_KEY || json->field) {
+                for (; run < p; run++) put_byte(json, *run);
+            }
+            if (p == end) break;
+            if (*p++ == '"') end_string(json);
+            else json->state = STATE_ESCAPE;
+            break;
+        }
+        case STATE_ESCAPE: {
+            char c = *p++;
+            json->state = STATE_STRING;
+            if (c == 'u') {
+                json->state = STATE_UNICODE;
+                json->unicode = 0;
+                json->unicode_digits = 0;
+                break;
+            }
+            drop_surrogate(json);
+            switch (c) {
+            case 'n': put_byte(json, '\n'); break;
+            case 't': put_byte(json, '\t'); break;
+            case 'r': put_byte(json, '\r'); break;
+            case 'b': put_byte(json, '\b'); break;
+            case 'f': put_byte(json, '\f'); break;
+            case '"': case '\\': case '/': put_byte(json, c); break;
+            default: return fail(json);
+            }
+            break;
+        }
+        case STATE_UNICODE: {
+            int digit = hex_value(*p++);
+            if (digit < 0) return fail(json);
+            json->unicode = json->unicode * 16 + (unsigned long)digit;
+            if (++json->unicode_digits == 4) {
+                json->state = STATE_STRING;
+                put_unicode(json, json->unicode);
+            }
+            break;
+        }
+        case STATE_SCALAR:
+            if (is_scalar_char(*p)) {
+                if (json->scratch_len >= GEMINI_JSON_KEY_LENGTH) return fail(json);
+                json->scratch[json->scratch_len++] = *p++;
+                break;
+            }
+            if (!end_scalar(json)) return 0;
+            break;   // the delimiter is read in STATE_VALUE
+        }
+    }
+    // Let the reader see text as it arrives, not only when a string ends
+    if (json->role == ROLE_TEXT && json->text_len) flush_text(json, 0);
+    return json->state != STATE_FAILED;
+}
+
+int gemini_json_finish(GeminiJson *json) {
+    if (json->state == STATE_SCALAR) end_scalar(json);
+    if (json->role == ROLE_TEXT) flush_text(json, 1);
+    int complete = json->state == STATE_VALUE && json->depth == 0 && json->complete;
+
+    // Parser state only; what was extracted stays
+    json->state = STATE_VALUE;
+    json->depth = 0;
+    json->expect_key = 0;
+    json->role = ROLE_NONE;
+    json->complete = 0;
+    json->field = NULL;
+    json->scratch_len = 0;
+    json->unicode_digits = 0;
+    json->high_surrogate = 0;
+    json->text_len = 0;
+    return complete;
+}
@@ -0,0 +1,66 @@
+// gemini_json.h
+#ifndef GEMINI_JSON_H
+#define GEMINI_JSON_H
+
+#include <stddef.h>
+
+// Called with each piece of candidate text as soon as it is decoded. Pieces
+// never split a UTF-8 sequence.
+typedef void (*GeminiTextFunc)(const char *text, size_t len, void *user_data);
+
+#define GEMINI_JSON_MAX_DEPTH 32      // deeper values are skipped
+#define GEMINI_JSON_KEY_LENGTH 32     // longer keys never match
+#define GEMINI_JSON_TEXT_CHUNK 256    // text is handed over at least this often
+
+typedef struct {
+    long prompt_tokens;       // usageMetadata; -1 until seen
+    long candidates_tokens;
+    long total_tokens;
+} GeminiUsage;
+
+// Incremental parser for generateContent replies: the document is fed in
+// chunks of any size and only candidates[].content.parts[].text, the usage
+// counts and error fields are kept, so memory stays fixed whatever the reply
+// size. A top-level array of replies (streamGenerateContent without SSE)
+// works as well.
+typedef struct {
+    // What was extracted; kept across documents, the latest value wins
+    GeminiUsage usage;
+    int error_code;                  // error.code, 0 when there was none
+    char error_message[256];         // error.message (truncated)
+    char error_status[64];           // error.status, e.g. "INVALID_ARGUMENT"
+    char finish_reason[32];          // candidates[].finishReason
+    char block_reason[32];           // promptFeedback.blockReason
+    int failed;                      // input was not JSON; the rest is ignored
+
+    // Parser state
+    GeminiTextFunc on_text;
+    void *user_data;
+    int state;
+    int depth;
+    char kind[GEMINI_JSON_MAX_DEPTH];            // '{' or '[' per level
+    unsigned char key[GEMINI_JSON_MAX_DEPTH];    // current key per object level
+    int expect_key;
+    int role;                        // what the string or number being read is
+    int complete;                    // a whole top-level value has been read
+    char *field;                     // destination of a string field
+    size_t field_len, field_cap;
+    char scratch[GEMINI_JSON_KEY_LENGTH + 1];    // key or number being read
+    size_t scratch_len;
+    unsigned long unicode;           // \uXXXX being read
+    int unicode_digits;
+    unsigned long high_surrogate;    // waiting for its low half
+    char text[GEMINI_JSON_TEXT_CHUNK];
+    size_t text_len;
+} GeminiJson;
+
+void gemini_json_init(GeminiJson *json, GeminiTextFunc on_text, void *user_data);
+
+// Feed the next bytes of the document; returns 0 once it is not valid JSON
+int gemini_json_feed(GeminiJson *json, const char *data, size_t len);
+
+// End of the document: hand over any held-back text and get ready for the
+// next one. Returns 1 if a complete JSON value was read.
+int gemini_json_finish(GeminiJson *json);
+
+#endif
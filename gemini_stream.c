@@ -0,0 +1,65 @@
+#include <string.h>
+#include "gemini_stream.h"
+
+enum { LINE_START, LINE_DATA, LINE_SKIP };
+
+static void end_event(GeminiStream *stream) {
+    if (stream->event_data) gemini_json_finish(&stream->json);
+    stream->event_data = 0;
+}
+
+static void end_line(GeminiStream *stream) {
+    // Blank line (an optional \r aside): the event is complete
+    if (stream->line == LINE_START && (stream->prefix_len == 0 || (stream->prefix_len == 1 && stream->prefix[0] == '\r')))
+        end_event(stream);
+    else if (stream->line == LINE_DATA)
+        gemini_json_feed(&stream->json, "\n", 1);   // data: lines of one event join with newlines
+    stream->line = LINE_START;
+    stream->prefix_len = 0;
+}
+
+void gemini_stream_init(GeminiStream *stream, GeminiTextFunc on_text, void *user_data) {
+    memset(stream, 0, sizeof(*stream));
+    gemini_json_init(&stream->json, on_text, user_data);
+}
+
+void gemini_stream_feed(GeminiStream *stream, const char *data, size_t len) {
+    static const char field[] = "data:";
+    const char *end = data + len;
+    while (data < end) {
+        if (stream->line != LINE_START) {
+            const char *newline = memchr(data, '\n', end - data);
+            size_t chunk = newline ? (size_t)(newline - data) : (size_t)(end - data);
+            // The JSON parser skips the optional space after "data:" and a trailing \r
+            if (stream->line == LINE_DATA && chunk) gemini_json_feed(&stream->json, data, chunk);
+            data += chunk;
+            if (newline) {
+                end_line(stream);
+                data++;
+            }
+            continue;
+        }
+
+        char c = *data++;
+        if (c == '\n') {
+            end_line(stream);
+            continue;
+        }
+        stream->prefix[stream->prefix_len++] = c;
+        if (c != field[stream->prefix_len - 1] && !(c == '\r' && stream->prefix_len == 1)) {
+            stream->line = LINE_SKIP;   // comments, event:, id:, retry:
+        } else if (stream->prefix_len == sizeof(field) - 1) {
+            stream->line = LINE_DATA;
+            stream->event_data = 1;
+        }
+    }
+}
+
+void gemini_stream_finish(GeminiStream *stream) {
+    if (stream->line != LINE_START || stream->prefix_len) end_line(stream);
+    end_event(stream);
+}
+
+void gemini_stream_free(GeminiStream *stream) {
+    memset(stream, 0, sizeof(*stream));
+}
@@ -0,0 +1,29 @@
+// gemini_stream.h
+#ifndef GEMINI_STREAM_H
+#define GEMINI_STREAM_H
+
+#include <stddef.h>
+#include "gemini_json.h"
+
+// Incremental parser for streamGenerateContent?alt=sse responses. data:
+// lines go straight into a GeminiJson, so nothing is buffered but the first
+// few bytes of each line; text comes out as it is decoded.
+typedef struct {
+    char prefix[5];      // start of the current line, until it is known to be data:
+    size_t prefix_len;
+    int line;            // what the rest of the current line is
+    int event_data;      // the current event has data
+    GeminiJson json;     // candidate text, usage and errors of every event so far
+} GeminiStream;
+
+void gemini_stream_init(GeminiStream *stream, GeminiTextFunc on_text, void *user_data);
+
+// Feed raw bytes exactly as they arrive from the network
+void gemini_stream_feed(GeminiStream *stream, const char *data, size_t len);
+
+// Flush an event left open by a connection that ended without a blank line
+void gemini_stream_finish(GeminiStream *stream);
+
+void gemini_stream_free(GeminiStream *stream);
+
+#endif
@@ -0,0 +1,336 @@
+#include <ctype.h>
+#include <string.h>
+#include "markdown.h"
+
+#define MAX_COMMAND 12      // longest \name (or ^digits) read in full
+#define MAX_INDENT 4        // spaces before a line marker
+
+// Bytes that may start a construct; everything else is copied through
+static const unsigned char special[256] = {
+    ['\n'] = 1, ['\r'] = 1, ['`'] = 1, ['\\'] = 1, ['$'] = 1, ['*'] = 1, ['^'] = 1, ['{'] = 1, ['}'] = 1,
+};
+
+enum { GROUP_PLAIN, GROUP_NUMERATOR, GROUP_DENOMINATOR, GROUP_SUPERSCRIPT };
+
+// TeX commands Gemini uses in arithmetic; "" drops the command and keeps
+// its argument ({...} that follows is shown as is)
+#define COMMAND(name, text, frac) { name, sizeof(name) - 1, text, frac }
+static const struct {
+    const char *name;
+    size_t len;
+    const char *text;
+    int frac;           // takes {numerator}{denominator}
+} commands[] = {
+    COMMAND("times", "×", 0), COMMAND("div", "÷", 0), COMMAND("cdot", "·", 0), COMMAND("pm", "±", 0), COMMAND("mp", "∓", 0),
+    COMMAND("le", "≤", 0), COMMAND("leq", "≤", 0), COMMAND("ge", "≥", 0), COMMAND("geq", "≥", 0), COMMAND("ne", "≠", 0), COMMAND("neq", "≠", 0),
+    COMMAND("lt", "<", 0), COMMAND("gt", ">", 0), COMMAND("approx", "≈", 0), COMMAND("equiv", "≡", 0), COMMAND("infty", "∞", 0),
+    COMMAND("pi", "π", 0), COMMAND("theta", "θ", 0), COMMAND("alpha", "α", 0), COMMAND("beta", "β", 0), COMMAND("Delta", "Δ", 0), COMMAND("sum", "Σ", 0),
+    COMMAND("sqrt", "√", 0), COMMAND("circ", "°", 0), COMMAND("degree", "°", 0), COMMAND("therefore", "∴", 0), COMMAND("because", "∵", 0),
+    COMMAND("to", "→", 0), COMMAND("rightarrow", "→", 0), COMMAND("Rightarrow", "⇒", 0), COMMAND("implies", "⇒", 0),
+    COMMAND("dots", "…", 0), COMMAND("ldots", "…", 0), COMMAND("cdots", "⋯", 0), COMMAND("percent", "%", 0), COMMAND("quad", "  ", 0), COMMAND("qquad", "    ", 0),
+    COMMAND("left", "", 0), COMMAND("right", "", 0), COMMAND("displaystyle", "", 0), COMMAND("text", "", 0), COMMAND("mathrm", "", 0),
+    COMMAND("mathbf", "", 0), COMMAND("textbf", "", 0), COMMAND("boxed", "", 0),
+    COMMAND("frac", "", 1), COMMAND("dfrac", "", 1), COMMAND("tfrac", "", 1),
+};
+
+static void flush(MarkdownParser *p) {
+    if (p->out_len) p->on_span(p->out, p->out_len, p->out_style, p->user_data);
+    p->out_len = 0;
+}
+
+static void emit(MarkdownParser *p, const char *text, size_t len, unsigned style) {
+    if (p->out_len && style != p->out_style) flush(p);
+    p->out_style = style;
+    while (len) {
+        size_t room = sizeof(p->out) - p->out_len;
+        size_t n = len < room ? len : room;
+        memcpy(p->out + p->out_len, text, n);
+        p->out_len += n;
+        text += n;
+        len -= n;
+        if (p->out_len == sizeof(p->out)) flush(p);
+    }
+}
+
+static void emit_char(MarkdownParser *p, char c) {
+    emit(p, &c, 1, p->style);
+}
+
+static void open_math(MarkdownParser *p, char end) {
+    p->style |= MARKDOWN_MATH;
+    p->math_end = end;
+    p->depth = 0;
+    p->frac = 0;
+}
+
+static void close_math(MarkdownParser *p) {
+    p->style &= ~(MARKDOWN_MATH | MARKDOWN_SUPERSCRIPT);
+    p->math_end = 0;
+    p->depth = 0;
+    p->frac = 0;
+}
+
+// Superscript while any open group is one
+static void update_superscript(MarkdownParser *p) {
+    p->style &= ~MARKDOWN_SUPERSCRIPT;
+    for (int i = 0; i < p->depth; i++)
+        if (p->groups[i] == GROUP_SUPERSCRIPT) p->style |= MARKDOWN_SUPERSCRIPT;
+}
+
+static void open_group(MarkdownParser *p, int kind) {
+    if (p->depth < MARKDOWN_MAX_GROUPS) p->groups[p->depth] = kind;
+    p->depth++;
+    update_superscript(p);
+}
+
+static void close_group(MarkdownParser *p) {
+    if (p->depth == 0) return;
+    p->depth--;
+    int kind = p->depth < MARKDOWN_MAX_GROUPS ? p->groups[p->depth] : GROUP_PLAIN;
+    update_superscript(p);
+    if (kind == GROUP_NUMERATOR) {
+        emit_char(p, '/');
+        p->frac = 2;
+    }
+}
+
+// A line break ends everything that is line-scoped in markdown
+static void end_line(MarkdownParser *p) {
+    if ((p->style & MARKDOWN_MATH) && (p->math_end == '$' || p->math_end == 0)) close_math(p);
+    p->style &= ~(MARKDOWN_BOLD | MARKDOWN_ITALIC | MARKDOWN_HEADING | MARKDOWN_SUPERSCRIPT);
+    if (!p->fence) p->style &= ~MARKDOWN_CODE;
+    emit_char(p, '\n');
+    p->line_start = 1;
+}
+
+// Markers at the start of a line. Returns bytes consumed, 0 if nothing
+// matched (the line is then read as text), -1 if more input is needed.
+static int line_prefix(MarkdownParser *p, const char *s, size_t n, int final) {
+    size_t indent = 0;
+    while (indent < n && indent < MAX_INDENT && s[indent] == ' ') indent++;
+    if (indent == n) return final ? 0 : -1;
+    if (n - indent < 3 && !final && s[indent] == '`') return -1;
+    if (n - indent >= 3 && memcmp(s + indent, "```", 3) == 0) {
+        p->fence = !p->fence;
+        if (p->fence) p->style = MARKDOWN_CODE;
+        else p->style &= ~MARKDOWN_CODE;
+        p->skip_line = 1;   // the language name, if any
+        return indent + 3;
+    }
+    if (p->fence) return 0;
+    if (s[indent] == '#') {
+        size_t hashes = 0;
+        while (indent + hashes < n && hashes < 7 && s[indent + hashes] == '#') hashes++;
+        if (indent + hashes == n) return final ? 0 : -1;
+        if (hashes > 6 || s[indent + hashes] != ' ') return 0;
+        p->style |= MARKDOWN_HEADING;
+        return indent + hashes + 1;
+    }
+    if (s[indent] == '-' || s[indent] == '*' || s[indent] == '+') {
+        if (indent + 1 == n) return final ? 0 : -1;
+        if (s[indent + 1] != ' ') return 0;
+        emit(p, s, indent, p->style);
+        emit(p, "• ", strlen("• "), p->style | MARKDOWN_BULLET);
+        return indent + 2;
+    }
+    return 0;
+}
+
+// \name: a symbol, a construct or a literal. s[0] is the backslash.
+static int command(MarkdownParser *p, const char *s, size_t n, int final) {
+    size_t len = 0;
+    while (1 + len < n && len < MAX_COMMAND && isalpha((unsigned char)s[1 + len])) len++;
+    if (1 + len == n && len < MAX_COMMAND && !final) return -1;
+    for (size_t i = 0; i < sizeof(commands) / sizeof(commands[0]); i++) {
+        if (commands[i].len != len || memcmp(commands[i].name, s + 1, len) != 0) continue;
+        if (commands[i].frac) {
+            if (!(p->style & MARKDOWN_MATH)) open_math(p, 0);   // TeX outside $...$: until the fraction ends
+            p->frac = 1;
+        }
+        emit(p, commands[i].text, strlen(commands[i].text), p->style);
+        return 1 + len;
+    }
+    emit(p, s, 1 + len, p->style);
+    return 1 + len;
+}
+
+// Read one construct from s. Returns bytes consumed, or 0 if s does not yet
+// say what it is (never when final, nor once n >= MARKDOWN_HOLD - 2: no
+// construct looks further ahead than that).
+static size_t step(MarkdownParser *p, const char *s, size_t n, int final) {
+    char c = s[0];
+    if (p->skip_line) {
+        if (c == '\n') {
+            p->skip_line = 0;
+            p->line_start = 1;
+        }
+        return 1;
+    }
+    if (p->line_start && !(p->style & MARKDOWN_MATH)) {
+        int used = line_prefix(p, s, n, final);
+        if (used < 0) return 0;
+        p->line_start = 0;
+        p->prev = ' ';
+        if (used > 0) return used;
+    }
+    if (c == '\n') {
+        end_line(p);
+        p->prev = ' ';
+        return 1;
+    }
+    if (c == '\r') return 1;
+    if (p->fence || ((p->style & MARKDOWN_CODE) && c != '`')) {
+        emit_char(p, c);
+        return 1;
+    }
+    // Most of a reply is plain text: take it a run at a time
+    size_t run = 0;
+    if (!p->frac)
+        while (run < n && !special[(unsigned char)s[run]]) run++;
+    if (run) {
+        emit(p, s, run, p->style);
+        p->prev = s[run - 1];
+        return run;
+    }
+
+    size_t used = 1;
+    int math = (p->style & MARKDOWN_MATH) != 0;
+    if (c == '`') {
+        p->style ^= MARKDOWN_CODE;
+    } else if (c == '\\') {
+        if (n < 2 && !final) return 0;
+        char next = n < 2 ? '\0' : s[1];
+        if (!math && (next == '(' || next == '[')) {
+            open_math(p, next == '(' ? ')' : ']');
+            used = 2;
+        } else if (math && next == p->math_end && (next == ')' || next == ']')) {
+            close_math(p);
+            used = 2;
+        } else if (isalpha((unsigned char)next)) {
+            int n_used = command(p, s, n, final);
+            if (n_used < 0) return 0;
+            used = n_used;
+        } else if (math && (next == ',' || next == ';' || next == ':' || next == '\\')) {
+            emit_char(p, ' ');   // TeX spacing (and line breaks, kept on one line)
+            used = 2;
+        } else if (math && next == '!') {
+            used = 2;
+        } else if (next && ispunct((unsigned char)next)) {
+            emit_char(p, next);   // escaped marker
+            used = 2;
+        } else {
+            emit_char(p, c);
+        }
+    } else if (c == '$') {
+        if (n < 2 && !final) return 0;
+        char next = n < 2 ? '\0' : s[1];
+        if (next == '$') {
+            if (!math) open_math(p, 'D');
+            else if (p->math_end == 'D') close_math(p);
+            used = 2;
+        } else if (math && p->math_end == '$') {
+            close_math(p);
+        } else if (!math && (isalpha((unsigned char)next) || next == '\\')) {
+            open_math(p, '$');   // "$x", "$\frac"; "$5" stays money
+        } else {
+            emit_char(p, c);
+        }
+    } else if (c == '*' && !math) {
+        if (n < 2 && !final) return 0;
+        char next = n < 2 ? '\0' : s[1];
+        int after_space = isspace((unsigned char)p->prev) || ispunct((unsigned char)p->prev);
+        if (next == '*') {
+            p->style ^= MARKDOWN_BOLD;
+            used = 2;
+        } else if ((p->style & MARKDOWN_ITALIC) && !isspace((unsigned char)p->prev)) {
+            p->style &= ~MARKDOWN_ITALIC;
+        } else if (after_space && next && !isspace((unsigned char)next)) {
+            p->style |= MARKDOWN_ITALIC;
+        } else {
+            emit_char(p, c);   // "6 * 4", "6*4"
+        }
+    } else if (c == '^') {
+        if (n < 2 && !final) return 0;
+        char next = n < 2 ? '\0' : s[1];
+        if (next == '{') {
+            if (!math) open_math(p, 0);   // x^{2} outside math: just the group
+            open_group(p, GROUP_SUPERSCRIPT);
+            used = 2;
+        } else if (isdigit((unsigned char)next) && !math) {
+            // 2^10: the whole number
+            size_t digits = 1;
+            while (1 + digits < n && digits < MAX_COMMAND && isdigit((unsigned char)s[1 + digits])) digits++;
+            if (1 + digits == n && digits < MAX_COMMAND && !final) return 0;
+            emit(p, s + 1, digits, p->style | MARKDOWN_SUPERSCRIPT);
+            used = 1 + digits;
+        } else if (isalnum((unsigned char)next)) {
+            emit(p, s + 1, 1, p->style | MARKDOWN_SUPERSCRIPT);
+            used = 2;
+        } else {
+            emit_char(p, c);
+        }
+    } else if (c == '{' && math) {
+        open_group(p, p->frac == 1 ? GROUP_NUMERATOR : p->frac == 2 ? GROUP_DENOMINATOR : GROUP_PLAIN);
+        p->frac = 0;
+    } else if (c == '}' && math) {
+        close_group(p);
+        if (p->math_end == 0 && p->depth == 0 && !p->frac) close_math(p);
+    } else if (math && p->frac && c != ' ') {
+        emit_char(p, c);   // \frac12
+        if (p->frac == 1) emit_char(p, '/');
+        p->frac = p->frac == 1 ? 2 : 0;
+        if (p->math_end == 0 && p->depth == 0 && !p->frac) close_math(p);
+    } else {
+        emit_char(p, c);
+    }
+    p->prev = s[used - 1];
+    return used;
+}
+
+void markdown_init(MarkdownParser *parser, MarkdownSpanFunc on_span, void *user_data) {
+    memset(parser, 0, sizeof(*parser));
+    parser->on_span = on_span;
+    parser->user_data = user_data;
+    parser->line_start = 1;
+    parser->prev = ' ';
+}
+
+// Settle as much of the held tail as possible
+static void drain_hold(MarkdownParser *p, int final) {
+    size_t at = 0;
+    while (at < p->hold_len) {
+        size_t used = step(p, p->hold + at, p->hold_len - at, final);
+        if (!used) break;
+        at += used;
+    }
+    memmove(p->hold, p->hold + at, p->hold_len - at);
+    p->hold_len -= at;
+}
+
+void markdown_feed(MarkdownParser *p, const char *text, size_t len) {
+    // A held tail is completed a byte at a time, then the rest is read in place
+    while (p->hold_len && len) {
+        p->hold[p->hold_len++] = *text++;
+        len--;
+        drain_hold(p, 0);
+    }
+    while (len) {
+        size_t used = step(p, text, len, 0);
+        if (!used) {
+            memcpy(p->hold, text, len);   // len < MARKDOWN_HOLD - 2, or step would have decided
+            p->hold_len = len;
+            break;
+        }
+        text += used;
+        len -= used;
+    }
+    flush(p);
+}
+
+void markdown_finish(MarkdownParser *p) {
+    drain_hold(p, 1);
+    flush(p);
+    MarkdownSpanFunc on_span = p->on_span;
+    void *user_data = p->user_data;
+    markdown_init(p, on_span, user_data);
+}
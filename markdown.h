@@ -0,0 +1,59 @@
+// markdown.h
+#ifndef MARKDOWN_H
+#define MARKDOWN_H
+
+#include <stddef.h>
+
+// Incremental reader for the markdown and TeX-style math in Gemini's replies.
+// Text goes in as pieces of any size (a streamed reply), and comes out as
+// spans of display text with the markers removed and a style for each: the
+// same spans whatever the pieces, holding back only the few bytes whose
+// meaning depends on what follows (a '*' that may be "**", a "\fra").
+//   **bold**  *italic*  `code`  ```fenced code```  # heading  - bullet
+//   $x^2$  $$...$$  \(...\)  \[...\]  with \times, \frac{a}{b}, ^{...} etc.
+
+typedef enum {
+    MARKDOWN_BOLD = 1 << 0,
+    MARKDOWN_ITALIC = 1 << 1,
+    MARKDOWN_CODE = 1 << 2,
+    MARKDOWN_MATH = 1 << 3,
+    MARKDOWN_HEADING = 1 << 4,
+    MARKDOWN_SUPERSCRIPT = 1 << 5,
+    MARKDOWN_BULLET = 1 << 6,      // the "•" that replaces a list marker
+} MarkdownStyle;
+
+// A run of display text (UTF-8) in one style, a combination of MarkdownStyle
+typedef void (*MarkdownSpanFunc)(const char *text, size_t len, unsigned style, void *user_data);
+
+#define MARKDOWN_HOLD 16         // most bytes ever held back between pieces
+#define MARKDOWN_MAX_GROUPS 16   // nesting of {...} in math
+
+typedef struct {
+    MarkdownSpanFunc on_span;
+    void *user_data;
+    char hold[MARKDOWN_HOLD];    // undecided tail of the input so far
+    size_t hold_len;
+    unsigned style;              // styles in force
+    int line_start;              // next byte starts a line
+    int skip_line;               // dropping the rest of a ``` line
+    int fence;                   // inside a fenced code block
+    char math_end;               // what closes the math span: '$', 'D' ($$), ')' or ']'
+    unsigned char groups[MARKDOWN_MAX_GROUPS];   // open {...} in math and what each is
+    int depth;
+    int frac;                    // after \frac: 1 numerator next, 2 denominator next
+    char prev;                   // last byte of input, for where '*' may open or close
+    char out[256];               // span being collected
+    size_t out_len;
+    unsigned out_style;
+} MarkdownParser;
+
+void markdown_init(MarkdownParser *parser, MarkdownSpanFunc on_span, void *user_data);
+
+// Spans are delivered as they are decided, the last of them when the piece ends
+void markdown_feed(MarkdownParser *parser, const char *text, size_t len);
+
+// End of the document: settle what was held back and close every style, so
+// the parser is ready for the next one
+void markdown_finish(MarkdownParser *parser);
+
+#endif
@@ -0,0 +1,167 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include "net_trace.h"
+
+#define TRACE_HEADER "# when_us\tlabel\tresult\tstatus\thttp\treused\tdns_us\tconnect_us\ttls_us\t" \
+                     "pretransfer_us\tfirst_byte_us\ttotal_us\tbytes_up\tbytes_down\tdecoded\tencoding\n"
+
+struct NetTrace {
+    char *path;           // NULL: summary only
+    FILE *file;
+    size_t size;          // bytes in the current file
+    size_t max_bytes;
+    int keep;
+    NetTraceEntry window[NET_TRACE_WINDOW];   // ring of the latest entries
+    int next;
+    int count;
+    NetTraceTotals totals;
+};
+
+static int open_file(NetTrace *trace) {
+    trace->file = fopen(trace->path, "a");
+    if (!trace->file) return 0;
+    setvbuf(trace->file, NULL, _IOLBF, 0);   // whole lines, so a crash loses at most one
+    struct stat st;
+    trace->size = fstat(fileno(trace->file), &st) == 0 ? (size_t)st.st_size : 0;
+    if (trace->size == 0) trace->size = fputs(TRACE_HEADER, trace->file) >= 0 ? strlen(TRACE_HEADER) : 0;
+    return 1;
+}
+
+// path -> path.1 -> ... -> path.keep (dropped), then a fresh path
+static void rotate(NetTrace *trace) {
+    fclose(trace->file);
+    trace->file = NULL;
+    size_t len = strlen(trace->path) + 16;
+    char *from = malloc(len), *to = malloc(len);
+    for (int i = trace->keep; i >= 1; i--) {
+        snprintf(to, len, "%s.%d", trace->path, i);
+        if (i > 1) snprintf(from, len, "%s.%d", trace->path, i - 1);
+        else snprintf(from, len, "%s", trace->path);
+        rename(from, to);   // missing older files are fine
+    }
+    if (trace->keep <= 0) remove(trace->path);
+    free(from);
+    free(to);
+    open_file(trace);
+}
+
+NetTrace* net_trace_open(const char *path, size_t max_bytes, int keep) {
+    NetTrace *trace = calloc(1, sizeof(NetTrace));
+    if (!trace) return NULL;
+    trace->max_bytes = max_bytes ? max_bytes : NET_TRACE_DEFAULT_BYTES;
+    trace->keep = keep;
+    if (path) {
+        trace->path = strdup(path);
+        if (!trace->path || !open_file(trace)) {
+            net_trace_close(trace);
+            return NULL;
+        }
+    }
+    return trace;
+}
+
+void net_trace_close(NetTrace *trace) {
+    if (!trace) return;
+    if (trace->file) fclose(trace->file);
+    free(trace->path);
+    free(trace);
+}
+
+void net_trace_add(NetTrace *trace, const NetTraceEntry *entry) {
+    trace->window[trace->next] = *entry;
+    trace->next = (trace->next + 1) % NET_TRACE_WINDOW;
+    if (trace->count < NET_TRACE_WINDOW) trace->count++;
+    net_trace_count(&trace->totals, entry);
+    if (!trace->file) return;
+
+    char line[512];
+    int n = snprintf(line, sizeof(line),
+                     "%lld\t%s\t%d\t%d\t%d\t%d\t%lld\t%lld\t%lld\t%lld\t%lld\t%lld\t%lld\t%lld\t%lld\t%s\n",
+                     (long long)entry->when, entry->label, entry->result, entry->status, entry->http_version,
+                     entry->reused, (long long)entry->dns, (long long)entry->connect, (long long)entry->tls,
+                     (long long)entry->pretransfer, (long long)entry->first_byte, (long long)entry->total,
+                     (long long)entry->bytes_up, (long long)entry->bytes_down, (long long)entry->decoded,
+                     entry->encoding[0] ? entry->encoding : "-");
+    if (n <= 0 || n >= (int)sizeof(line)) return;
+    if (trace->size + n > trace->max_bytes) rotate(trace);
+    if (trace->file && fputs(line, trace->file) >= 0) trace->size += n;
+}
+
+void net_trace_phases(const NetTraceEntry *e, int64_t phases[NET_PHASE_COUNT]) {
+    // curl's times are cumulative; a skipped step reports 0
+    int64_t connected = e->tls ? e->tls : e->connect ? e->connect : e->dns;
+    phases[NET_PHASE_DNS] = e->dns;
+    phases[NET_PHASE_CONNECT] = e->connect ? e->connect - e->dns : 0;
+    phases[NET_PHASE_TLS] = e->tls && e->connect ? e->tls - e->connect : 0;
+    int64_t sent = e->pretransfer > connected ? e->pretransfer : connected;
+    phases[NET_PHASE_WAIT] = (e->first_byte ? e->first_byte : e->total) - sent;
+    phases[NET_PHASE_TRANSFER] = e->first_byte ? e->total - e->first_byte : 0;
+    phases[NET_PHASE_TOTAL] = e->total;
+    for (int i = 0; i < NET_PHASE_COUNT; i++)
+        if (phases[i] < 0) phases[i] = 0;
+}
+
+void net_trace_count(NetTraceTotals *totals, const NetTraceEntry *entry) {
+    totals->requests++;
+    totals->bytes_up += entry->bytes_up;
+    totals->bytes_down += entry->bytes_down;
+    totals->decoded += entry->decoded;
+}
+
+NetTraceTotals net_trace_totals(const NetTrace *trace) {
+    return trace->totals;
+}
+
+int net_trace_format_totals(const NetTraceTotals *t, char *buf, int size) {
+    return snprintf(buf, size, "%lu request%s, %.1f KB (%.1f KB up, %.1f KB down, %.1f KB decoded)", t->requests,
+                    t->requests == 1 ? "" : "s", (t->bytes_up + t->bytes_down) / 1024.0, t->bytes_up / 1024.0,
+                    t->bytes_down / 1024.0, t->decoded / 1024.0);
+}
+
+static int compare_int64(const void *a, const void *b) {
+    int64_t x = *(const int64_t*)a, y = *(const int64_t*)b;
+    return x < y ? -1 : x > y;
+}
+
+void net_trace_summary(const NetTrace *trace, NetTraceSummary *out) {
+    memset(out, 0, sizeof(*out));
+    out->count = trace->count;
+    if (trace->count == 0) return;
+
+    int64_t phases[NET_PHASE_COUNT][NET_TRACE_WINDOW];
+    for (int i = 0; i < trace->count; i++) {
+        const NetTraceEntry *e = &trace->window[i];
+        int64_t p[NET_PHASE_COUNT];
+        net_trace_phases(e, p);
+        for (int k = 0; k < NET_PHASE_COUNT; k++) phases[k][i] = p[k];
+        out->reused += e->reused;
+        out->failed += e->result != 0 || e->status >= 400;
+        out->bytes_up += e->bytes_up;
+        out->bytes_down += e->bytes_down;
+        out->decoded += e->decoded;
+    }
+    for (int k = 0; k < NET_PHASE_COUNT; k++) {
+        qsort(phases[k], trace->count, sizeof(int64_t), compare_int64);
+        out->median[k] = phases[k][(trace->count - 1) / 2];
+        out->worst[k] = phases[k][trace->count - 1];
+    }
+    out->bytes_up /= trace->count;
+    out->bytes_down /= trace->count;
+    out->decoded /= trace->count;
+}
+
+int net_trace_format(const NetTraceSummary *s, char *buf, int size) {
+    if (s->count == 0) return snprintf(buf, size, "Network: no requests yet");
+    static const char *names[NET_PHASE_COUNT] = { "dns", "connect", "tls", "wait", "transfer", "total" };
+    int n = snprintf(buf, size, "Network (last %d, p50/max ms):", s->count);
+    for (int k = 0; k < NET_PHASE_COUNT && n < size; k++)
+        n += snprintf(buf + n, size - n, "%s %s %.0f/%.0f", k ? " |" : "", names[k],
+                      s->median[k] / 1000.0, s->worst[k] / 1000.0);
+    if (n < size)
+        n += snprintf(buf + n, size - n, " | %d%% reused | %.1f KB up, %.1f KB down (%.1f KB decoded)",
+                      100 * s->reused / s->count, s->bytes_up / 1024.0, s->bytes_down / 1024.0, s->decoded / 1024.0);
+    if (s->failed && n < size) n += snprintf(buf + n, size - n, " | %d failed", s->failed);
+    return n;
+}
@@ -0,0 +1,81 @@
+// net_trace.h
+#ifndef NET_TRACE_H
+#define NET_TRACE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Where the time of each request went, written one tab-separated line per
+// request to a trace file that is rotated by size:
+//   <path>  newest, <path>.1 ... <path>.<keep>  older
+// and kept for the most recent NET_TRACE_WINDOW requests for a rolling
+// summary. Called from the main loop only.
+
+#define NET_TRACE_WINDOW 32
+#define NET_TRACE_DEFAULT_BYTES (1024 * 1024)
+#define NET_TRACE_DEFAULT_KEEP 3
+
+typedef struct {
+    int64_t when;          // wall clock at completion, µs since the epoch
+    char label[16];        // what the request was for, e.g. "question"
+    int result;            // CURLcode
+    int status;            // HTTP status, 0 if none arrived
+    int http_version;      // 1, 2 or 3; 0 if unknown
+    int reused;            // sent on an existing connection
+    // µs from the start of the transfer, as curl reports them (0: step skipped)
+    int64_t dns, connect, tls, pretransfer, first_byte, total;
+    int64_t bytes_up;      // request headers and body
+    int64_t bytes_down;    // response headers and body, as received (compressed)
+    int64_t decoded;       // response body after decompression
+    char encoding[16];     // Content-Encoding, "" if none
+} NetTraceEntry;
+
+// Running byte counts over some set of requests (a question, the session)
+typedef struct {
+    unsigned long requests;
+    int64_t bytes_up;
+    int64_t bytes_down;    // on the wire
+    int64_t decoded;       // response bodies after decompression
+} NetTraceTotals;
+
+// Durations of the phases of one request
+typedef enum {
+    NET_PHASE_DNS,
+    NET_PHASE_CONNECT,
+    NET_PHASE_TLS,
+    NET_PHASE_WAIT,        // request sent until the first byte back: upload and server time
+    NET_PHASE_TRANSFER,    // first byte until the last
+    NET_PHASE_TOTAL,
+    NET_PHASE_COUNT
+} NetPhase;
+
+typedef struct {
+    int count;                            // requests in the window
+    int64_t median[NET_PHASE_COUNT];      // µs
+    int64_t worst[NET_PHASE_COUNT];       // µs
+    int reused;                           // of count
+    int failed;
+    int64_t bytes_up, bytes_down;         // averages
+    int64_t decoded;                      // average
+} NetTraceSummary;
+
+typedef struct NetTrace NetTrace;
+
+// path NULL keeps the summary without a file. NULL if the file cannot be opened.
+NetTrace* net_trace_open(const char *path, size_t max_bytes, int keep);
+void net_trace_close(NetTrace *trace);
+
+void net_trace_add(NetTrace *trace, const NetTraceEntry *entry);
+void net_trace_phases(const NetTraceEntry *entry, int64_t phases[NET_PHASE_COUNT]);
+
+void net_trace_count(NetTraceTotals *totals, const NetTraceEntry *entry);
+// Everything added since net_trace_open
+NetTraceTotals net_trace_totals(const NetTrace *trace);
+// "3 requests, 4.1 KB (1.2 KB up, 2.9 KB down, 7.6 KB decoded)"
+int net_trace_format_totals(const NetTraceTotals *totals, char *buf, int size);
+
+void net_trace_summary(const NetTrace *trace, NetTraceSummary *out);
+// "Network (last 12, p50/max ms): dns 0/41 | connect 0/38 | ... | 92% reused | ..."
+int net_trace_format(const NetTraceSummary *summary, char *buf, int size);
+
+#endif
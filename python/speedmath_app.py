@@ -23,41 +23,66 @@ DEFAULT_QUERY = (
 
 # Global variables for timer and average time calculation
 start_time = None
-time_taken = []
+total_time = 0.0  # running sum, so memory stays constant however long the session
 question_count = 0
 running_timer = True
+last_sent = ""  # size of the last request, shown next to the timer
 
 # Global variables for the current question and options
 current_question = None
 current_options = None
 
-# Function to update the timer display
+# Function to update the timer display (runs on the Tk thread via after())
 def update_timer():
-    while running_timer:
-        if start_time:
-            elapsed_time = time.time() - start_time
-            timer_label.config(text=f"Timer: {elapsed_time:.2f} seconds")
-        else:
-            timer_label.config(text="Timer: --")
-        time.sleep(1)
-
-# Function to send queries to Gemini API
-def send_query_to_gemini(query):
+    if not running_timer:
+        return
+    if start_time:
+        elapsed_time = time.perf_counter() - start_time
+        timer_label.config(text=f"Timer: {elapsed_time:.2f} seconds{last_sent}")
+    else:
+        timer_label.config(text=f"Timer: --{last_sent}")
+    root.after(50, update_timer)
+
+# Turns about the question on screen, so Gemini can grade against it. Starts
+# over with every new question; older exchanges are left out past the budget.
+GRADING_INSTRUCTION = "You asked me this practice question for an Indian banking exam. Grade my answer, then give the stepwise complete solution."
+CONTEXT_BUDGET = 8000  # characters, about 2000 tokens
+conversation = []
+
+# The instruction and the question always go, then the newest exchanges that fit
+def trimmed_history():
+    kept, size = [], 0
+    for i in range(len(conversation) - 2, 1, -2):
+        pair = conversation[i:i + 2]
+        size += sum(len(turn["parts"][0]) for turn in pair)
+        if size > CONTEXT_BUDGET:
+            break
+        kept[:0] = pair
+    return conversation[:2] + kept
+
+# Function to send queries to Gemini API (new_question: the reply is a new
+# question, so the turns about the last one are dropped)
+def send_query_to_gemini(query, new_question=False):
+    global conversation, last_sent
     try:
-        chat = model.start_chat(history=[])
+        history = [] if new_question else trimmed_history()
+        chat = model.start_chat(history=history)
         response = chat.send_message(query)
-        all_responses = []
-        for part in response.parts:
-            if part.text:
-                all_responses.append(part.text)
-        return " ".join(all_responses)
+        text = " ".join(part.text for part in response.parts if part.text)
+        sent = len(query) + sum(len(turn["parts"][0]) for turn in history)
+        last_sent = f" | sent {len(history) + 1} turns, {sent} bytes"
+        if new_question:
+            conversation = [{"role": "user", "parts": [GRADING_INSTRUCTION]}, {"role": "model", "parts": [text]}]
+        elif conversation:
+            conversation += [{"role": "user", "parts": [query]}, {"role": "model", "parts": [text]}]
+        return text
     except Exception as e:
         print(f"Error during interaction with Gemini AI: {e}")
         return f"Failed to get response: {e}"
 
 # Function to handle user input
 def on_send():
-    global start_time, time_taken, question_count
+    global start_time, total_time, question_count
 
     user_input = entry.get().strip()
     if user_input:  # Allow any non-empty input
@@ -68,12 +93,12 @@ def on_send():
 
         # Calculate time taken for the current question
         if start_time is not None:
-            elapsed_time = time.time() - start_time
-            time_taken.append(elapsed_time)
+            elapsed_time = time.perf_counter() - start_time
+            total_time += elapsed_time
             question_count += 1
 
             # Display average time
-            avg_time = sum(time_taken) / question_count
+            avg_time = total_time / question_count
             chat_area.config(state='normal')
             chat_area.insert(tk.END, f"Bot: Time taken for this question: {elapsed_time:.2f} seconds.\n")
             chat_area.insert(tk.END, f"Bot: Average time per question: {avg_time:.2f} seconds.\n")
@@ -91,7 +116,7 @@ def on_send():
             chat_area.config(state='disabled')
 
             # Send the next question
-            response_text = send_query_to_gemini("Send the next question only.")
+            response_text = send_query_to_gemini(DEFAULT_QUERY, new_question=True)
             question_match = re.search(r"\*\*Question.*:\*\*([\s\S]+?)\*\*Options", response_text)
             options_match = re.search(r"\*\*Options:\*\*([\s\S]+?)\*\*Note", response_text)
 
@@ -103,7 +128,7 @@ def on_send():
             chat_area.config(state='disabled')
 
             global start_time
-            start_time = time.time()  # Restart the timer for the next question
+            start_time = time.perf_counter()  # Restart the timer for the next question
 
         # Start a thread to handle the response
         thread = Thread(target=handle_response)
@@ -122,7 +147,7 @@ def load_default_query():
     def handle_default_query():
         global current_question, current_options  # Declare globals
 
-        response_text = send_query_to_gemini(DEFAULT_QUERY)
+        response_text = send_query_to_gemini(DEFAULT_QUERY, new_question=True)
 
         # Extract question and options
         question_match = re.search(r"\*\*Question.*:\*\*([\s\S]+?)\*\*Options", response_text)
@@ -136,7 +161,7 @@ def load_default_query():
         chat_area.insert(tk.END, f"Bot: {response_text}\n")
         chat_area.config(state='disabled')
 
-        start_time = time.time()  # Start the timer
+        start_time = time.perf_counter()  # Start the timer
 
     thread = Thread(target=handle_default_query)
     thread.start()
@@ -181,9 +206,8 @@ send_button.pack(side=tk.LEFT, padx=10, pady=10)
 ask_again_button = tk.Button(root, text="Restart", command=on_ask_again)
 ask_again_button.pack(side=tk.LEFT, padx=10, pady=10)
 
-# Start the Timer Thread
-timer_thread = Thread(target=update_timer, daemon=True)
-timer_thread.start()
+# Start the Timer
+update_timer()
 
 # Start the App
 root.protocol("WM_DELETE_WINDOW", on_close)
@@ -31,26 +31,55 @@ session = {
 
 # Global variables for timer and average time calculation
 start_time = None
-time_taken = []
+total_time = 0.0  # running sum, so memory stays constant however long the session
 question_count = 0
 running_timer = True
+last_sent = ""  # size of the last request, shown next to the timer
 
-# Function to update the timer display
+# Function to update the timer display (runs on the Tk thread via after())
 def update_timer():
-    while running_timer:
-        if start_time:
-            elapsed_time = time.time() - start_time
-            timer_label.config(text=f"Timer: {elapsed_time:.2f} seconds")
-        else:
-            timer_label.config(text="Timer: --")
-        time.sleep(1)
-
-# Function to send queries to Gemini API
-def send_query_to_gemini(query):
+    if not running_timer:
+        return
+    if start_time:
+        elapsed_time = time.perf_counter() - start_time
+        timer_label.config(text=f"Timer: {elapsed_time:.2f} seconds{last_sent}")
+    else:
+        timer_label.config(text=f"Timer: --{last_sent}")
+    root.after(50, update_timer)
+
+# Turns about the question on screen, so Gemini can grade against it. Starts
+# over with every new question; older exchanges are left out past the budget.
+GRADING_INSTRUCTION = "You asked me this practice question for an Indian banking exam. Grade my answer, then give the stepwise complete solution."
+CONTEXT_BUDGET = 8000  # characters, about 2000 tokens
+conversation = []
+
+# The instruction and the question always go, then the newest exchanges that fit
+def trimmed_history():
+    kept, size = [], 0
+    for i in range(len(conversation) - 2, 1, -2):
+        pair = conversation[i:i + 2]
+        size += sum(len(turn["parts"][0]) for turn in pair)
+        if size > CONTEXT_BUDGET:
+            break
+        kept[:0] = pair
+    return conversation[:2] + kept
+
+# Function to send queries to Gemini API (new_question: the reply is a new
+# question, so the turns about the last one are dropped)
+def send_query_to_gemini(query, new_question=False):
+    global conversation, last_sent
     try:
-        chat = model.start_chat(history=[])
+        history = [] if new_question else trimmed_history()
+        chat = model.start_chat(history=history)
         response = chat.send_message(query)
-        return " ".join(part.text for part in response.parts if part.text)
+        text = " ".join(part.text for part in response.parts if part.text)
+        sent = len(query) + sum(len(turn["parts"][0]) for turn in history)
+        last_sent = f" | sent {len(history) + 1} turns, {sent} bytes"
+        if new_question:
+            conversation = [{"role": "user", "parts": [GRADING_INSTRUCTION]}, {"role": "model", "parts": [text]}]
+        elif conversation:
+            conversation += [{"role": "user", "parts": [query]}, {"role": "model", "parts": [text]}]
+        return text
     except Exception as e:
         print(f"Error during interaction with Gemini AI: {e}")
         return f"Failed to get response: {e}"
@@ -68,7 +97,7 @@ def validate_user_input(user_input):
 
 # Function to handle user input
 def on_send():
-    global session, time_taken, question_count
+    global session, total_time, question_count
 
     user_input = entry.get().strip()
     if user_input:
@@ -82,11 +111,12 @@ def on_send():
         if validated_input:
             # Timer logic
             if start_time is not None:
-                elapsed_time = time.time() - start_time
-                time_taken.append(elapsed_time)
+                elapsed_time = time.perf_counter() - start_time
+                total_time += elapsed_time
                 question_count += 1
 
-                avg_time = sum(time_taken) / question_count
+                avg_time = total_time / question_count
+                log_attempt(session["current_question"], validated_input, elapsed_time)
                 chat_area.config(state='normal')
                 chat_area.insert(tk.END, f"Bot: Time taken for this question: {elapsed_time:.2f} seconds.\n", "bot")
                 chat_area.insert(tk.END, f"Bot: Average time per question: {avg_time:.2f} seconds.\n", "bot")
@@ -94,9 +124,8 @@ def on_send():
 
             # Check if current question and options exist
             if session["current_question"] and session["current_options"]:
-                response_text = send_query_to_gemini(
-                    f"Check the user's answer '{validated_input}' for the question: '{session['current_question']}'. Provide the solution and correct answer."
-                )
+                # The question goes as an earlier turn, so the answer alone is enough
+                response_text = send_query_to_gemini(f"My answer: {validated_input}")
                 chat_area.config(state='normal')
                 chat_area.insert(tk.END, f"Bot: {response_text}\n", "bot")
                 chat_area.config(state='disabled')
@@ -121,7 +150,7 @@ def load_default_query():
     chat_area.config(state='disabled')
 
     def handle_default_query():
-        response_text = send_query_to_gemini(DEFAULT_QUERY)
+        response_text = send_query_to_gemini(DEFAULT_QUERY, new_question=True)
 
         # Extract question and options
         question_match = re.search(r"\*\*Question.*:\*\*([\s\S]+?)\*\*Options", response_text, re.DOTALL)
@@ -142,7 +171,7 @@ def load_default_query():
         chat_area.insert(tk.END, f"Bot: {response_text}\n", "bot")
         chat_area.config(state='disabled')
 
-        start_time = time.time()  # Start the timer
+        start_time = time.perf_counter()  # Start the timer
 
     thread = Thread(target=handle_default_query)
     thread.start()
@@ -153,10 +182,21 @@ def on_ask_again():
     root.destroy()
     os.execl(sys.executable, sys.executable, *sys.argv)
 
-# Save session state to a file
+# Save session state to a file (written aside and renamed, so a crash never leaves half a file)
 def save_session():
-    with open("session.json", "w") as file:
+    with open("session.json.tmp", "w") as file:
         json.dump(session, file)
+    os.replace("session.json.tmp", "session.json")
+
+# Answers are appended one JSON line each; the file is never rewritten
+attempts_file = None
+
+def log_attempt(question, answer, seconds):
+    global attempts_file
+    if attempts_file is None:
+        attempts_file = open("attempts.jsonl", "a", buffering=1)
+    attempts_file.write(json.dumps({"when": time.time(), "question": question, "answer": answer,
+                                    "seconds": round(seconds, 3)}) + "\n")
 
 # Load session state from a file
 def load_session():
@@ -205,9 +245,8 @@ send_button.pack(side=tk.LEFT, padx=10, pady=10)
 ask_again_button = tk.Button(root, text="Restart", command=on_ask_again)
 ask_again_button.pack(side=tk.LEFT, padx=10, pady=10)
 
-# Start the Timer Thread
-timer_thread = Thread(target=update_timer, daemon=True)
-timer_thread.start()
+# Start the Timer
+update_timer()
 
 # Load session and default query
 load_session()
@@ -0,0 +1,38 @@
+// question.h
+#ifndef QUESTION_H
+#define QUESTION_H
+
+#define QUESTION_TEXT_LENGTH 256
+#define QUESTION_OPTION_COUNT 4
+#define QUESTION_OPTION_LENGTH 32
+
+typedef enum {
+    TOPIC_SIMPLIFICATION,
+    TOPIC_APPROXIMATION,
+    TOPIC_PERCENTAGE,
+    TOPIC_SQUARE_CUBE,
+    TOPIC_FRACTION,
+    TOPIC_COUNT
+} QuestionTopic;
+
+// One multiple-choice question with its exact answer
+typedef struct {
+    char question[QUESTION_TEXT_LENGTH];
+    char year[10];
+    QuestionTopic topic;
+    int difficulty;                 // 1 (easy) to 3 (hard)
+    char options[QUESTION_OPTION_COUNT][QUESTION_OPTION_LENGTH];
+    int correct_option;             // index into options
+    long long answer_num;           // exact answer as a reduced fraction,
+    long long answer_den;           // answer_den > 0
+    int approximate;                // options are rounded ("≈") values
+} Question;
+
+static inline const char* question_topic_name(QuestionTopic topic) {
+    static const char *const names[TOPIC_COUNT] = {
+        "Simplification", "Approximation", "Percentage", "Squares & Cubes", "Fractions"
+    };
+    return topic < TOPIC_COUNT ? names[topic] : "Mixed";
+}
+
+#endif
@@ -0,0 +1,370 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "crc32.h"
+#include "question_bank.h"
+
+#define RANGE_COUNT (TOPIC_COUNT * QUESTION_BANK_DIFFICULTIES)
+
+struct QuestionBank {
+    const unsigned char *map;
+    size_t size;
+    const QuestionBankHeader *header;
+    const QuestionRecord *records;
+    const uint32_t *index;
+    const QuestionBankRange *ranges;
+    const char *strings;
+};
+
+static uint32_t header_checksum(const QuestionBankHeader *header) {
+    return crc32_update(0, header, offsetof(QuestionBankHeader, header_checksum));
+}
+
+static int section_fits(size_t file_size, uint64_t offset, uint64_t size) {
+    return offset % 8 == 0 && offset <= file_size && size <= file_size - offset;
+}
+
+QuestionBank* question_bank_open(const char *path) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        fprintf(stderr, "Error: Could not open %s\n", path);
+        return NULL;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(QuestionBankHeader)) {
+        fprintf(stderr, "Error: %s is not a question bank\n", path);
+        close(fd);
+        return NULL;
+    }
+    void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        fprintf(stderr, "Error: Could not map %s\n", path);
+        return NULL;
+    }
+    // Questions are picked at random, so read-ahead would only inflate RSS
+    madvise(map, st.st_size, MADV_RANDOM);
+
+    const QuestionBankHeader *h = map;
+    size_t size = st.st_size;
+    uint64_t n = h->question_count;
+    if (memcmp(h->magic, QUESTION_BANK_MAGIC, 8) != 0 || h->version != QUESTION_BANK_VERSION ||
+        h->header_checksum != header_checksum(h) ||
+        !section_fits(size, h->records_offset, n * sizeof(QuestionRecord)) ||
+        !section_fits(size, h->index_offset, n * sizeof(uint32_t)) ||
+        !section_fits(size, h->ranges_offset, RANGE_COUNT * sizeof(QuestionBankRange)) ||
+        !section_fits(size, h->strings_offset, h->strings_size) ||
+        h->strings_size == 0 || ((const char *)map)[h->strings_offset + h->strings_size - 1] != '\0') {
+        fprintf(stderr, "Error: %s is corrupt or from another version\n", path);
+        munmap(map, size);
+        return NULL;
+    }
+
+    QuestionBank *bank = calloc(1, sizeof(QuestionBank));
+    if (!bank) {
+        munmap(map, size);
+        return NULL;
+    }
+    bank->map = map;
+    bank->size = size;
+    bank->header = h;
+    bank->records = (const QuestionRecord *)(bank->map + h->records_offset);
+    bank->index = (const uint32_t *)(bank->map + h->index_offset);
+    bank->ranges = (const QuestionBankRange *)(bank->map + h->ranges_offset);
+    bank->strings = (const char *)(bank->map + h->strings_offset);
+    return bank;
+}
+
+void question_bank_close(QuestionBank *bank) {
+    if (!bank) return;
+    munmap((void *)bank->map, bank->size);
+    free(bank);
+}
+
+int question_bank_verify(const QuestionBank *bank) {
+    const QuestionBankHeader *h = bank->header;
+    if (crc32_update(0, bank->records, (size_t)h->question_count * sizeof(QuestionRecord)) != h->records_checksum ||
+        crc32_update(0, bank->index, (size_t)h->question_count * sizeof(uint32_t)) != h->index_checksum ||
+        crc32_update(0, bank->strings, h->strings_size) != h->strings_checksum)
+        return 0;
+
+    for (uint32_t i = 0; i < h->question_count; i++) {
+        const QuestionRecord *r = &bank->records[i];
+        if (bank->index[i] >= h->question_count || r->text >= h->strings_size || r->topic >= TOPIC_COUNT)
+            return 0;
+        for (int k = 0; k < QUESTION_OPTION_COUNT; k++)
+            if (r->options[k] >= h->strings_size) return 0;
+    }
+    for (int i = 0; i < RANGE_COUNT; i++)
+        if ((uint64_t)bank->ranges[i].start + bank->ranges[i].count > h->question_count) return 0;
+    return 1;
+}
+
+uint32_t question_bank_count(const QuestionBank *bank) {
+    return bank->header->question_count;
+}
+
+const QuestionRecord* question_bank_record(const QuestionBank *bank, uint32_t id) {
+    return id < bank->header->question_count ? &bank->records[id] : NULL;
+}
+
+const char* question_bank_string(const QuestionBank *bank, uint32_t offset) {
+    return offset < bank->header->strings_size ? bank->strings + offset : "";
+}
+
+int question_bank_get(const QuestionBank *bank, uint32_t id, Question *out) {
+    const QuestionRecord *r = question_bank_record(bank, id);
+    if (!r) return 0;
+    memset(out, 0, sizeof(*out));
+    snprintf(out->question, sizeof(out->question), "%s", question_bank_string(bank, r->text));
+    if (r->year) snprintf(out->year, sizeof(out->year), "%u", r->year);
+    out->topic = r->topic < TOPIC_COUNT ? (QuestionTopic)r->topic : TOPIC_SIMPLIFICATION;
+    out->difficulty = r->difficulty;
+    for (int k = 0; k < QUESTION_OPTION_COUNT; k++)
+        snprintf(out->options[k], sizeof(out->options[k]), "%s", question_bank_string(bank, r->options[k]));
+    out->correct_option = r->correct_option < QUESTION_OPTION_COUNT ? r->correct_option : 0;
+    out->answer_num = r->answer_num;
+    out->answer_den = r->answer_den > 0 ? r->answer_den : 1;
+    out->approximate = r->approximate;
+    return 1;
+}
+
+// Year of the question at slice[at], or -1 for an id past the records (an
+// unverified bank can hold anything)
+static int year_at(const QuestionBank *bank, const uint32_t *slice, uint32_t at) {
+    const QuestionRecord *r = question_bank_record(bank, slice[at]);
+    return r ? r->year : -1;
+}
+
+uint32_t question_bank_find(const QuestionBank *bank, QuestionTopic topic, int difficulty,
+                            int year_from, int year_to, const uint32_t **ids) {
+    *ids = NULL;
+    if ((unsigned)topic >= TOPIC_COUNT || difficulty < 1 || difficulty > QUESTION_BANK_DIFFICULTIES) return 0;
+    QuestionBankRange range = bank->ranges[topic * QUESTION_BANK_DIFFICULTIES + difficulty - 1];
+    if ((uint64_t)range.start + range.count > bank->header->question_count) return 0;
+    const uint32_t *slice = bank->index + range.start;
+
+    // Years descend within the slice: find the first id with year <= year_to,
+    // then the first with year < year_from
+    uint32_t lo = 0, hi = range.count;
+    if (year_to > 0) {
+        while (lo < hi) {
+            uint32_t mid = lo + (hi - lo) / 2;
+            int year = year_at(bank, slice, mid);
+            if (year < 0) return 0;
+            if (year > year_to) lo = mid + 1; else hi = mid;
+        }
+    }
+    uint32_t first = lo;
+    hi = range.count;
+    if (year_from > 0) {
+        while (lo < hi) {
+            uint32_t mid = lo + (hi - lo) / 2;
+            int year = year_at(bank, slice, mid);
+            if (year < 0) return 0;
+            if (year >= year_from) lo = mid + 1; else hi = mid;
+        }
+    } else {
+        lo = range.count;
+    }
+    *ids = slice + first;
+    return lo - first;
+}
+
+// Writer
+
+struct QuestionBankWriter {
+    QuestionRecord *records;
+    uint32_t count, capacity;
+    char *strings;
+    size_t strings_size, strings_capacity;
+    uint32_t *intern;           // open-addressed table of string offsets + 1
+    size_t intern_capacity, interned;
+};
+
+QuestionBankWriter* question_bank_writer_new(void) {
+    QuestionBankWriter *writer = calloc(1, sizeof(QuestionBankWriter));
+    if (!writer) return NULL;
+    writer->intern_capacity = 1024;
+    writer->intern = calloc(writer->intern_capacity, sizeof(uint32_t));
+    writer->strings = malloc(1);
+    if (!writer->intern || !writer->strings) {
+        question_bank_writer_free(writer);
+        return NULL;
+    }
+    writer->strings[0] = '\0';  // offset 0 is the empty string
+    writer->strings_size = writer->strings_capacity = 1;
+    return writer;
+}
+
+void question_bank_writer_free(QuestionBankWriter *writer) {
+    if (!writer) return;
+    free(writer->records);
+    free(writer->strings);
+    free(writer->intern);
+    free(writer);
+}
+
+static uint32_t hash_string(const char *s) {
+    uint32_t h = 2166136261u;
+    while (*s) h = (h ^ (unsigned char)*s++) * 16777619u;
+    return h;
+}
+
+static int intern_grow(QuestionBankWriter *writer) {
+    size_t capacity = writer->intern_capacity * 2;
+    uint32_t *table = calloc(capacity, sizeof(uint32_t));
+    if (!table) return 0;
+    for (size_t i = 0; i < writer->intern_capacity; i++) {
+        uint32_t slot = writer->intern[i];
+        if (!slot) continue;
+        size_t j = hash_string(writer->strings + slot - 1) & (capacity - 1);
+        while (table[j]) j = (j + 1) & (capacity - 1);
+        table[j] = slot;
+    }
+    free(writer->intern);
+    writer->intern = table;
+    writer->intern_capacity = capacity;
+    return 1;
+}
+
+// Offset of s in the string pool, adding it the first time it is seen
+static int intern(QuestionBankWriter *writer, const char *s, uint32_t *offset) {
+    if (!*s) { *offset = 0; return 1; }
+    if ((writer->interned + 1) * 2 > writer->intern_capacity && !intern_grow(writer)) return 0;
+
+    size_t mask = writer->intern_capacity - 1;
+    size_t i = hash_string(s) & mask;
+    for (; writer->intern[i]; i = (i + 1) & mask) {
+        if (strcmp(writer->strings + writer->intern[i] - 1, s) == 0) {
+            *offset = writer->intern[i] - 1;
+            return 1;
+        }
+    }
+
+    size_t len = strlen(s) + 1;
+    if (writer->strings_size + len >= UINT32_MAX) return 0;
+    if (writer->strings_size + len > writer->strings_capacity) {
+        size_t capacity = writer->strings_capacity * 2;
+        while (capacity < writer->strings_size + len) capacity *= 2;
+        char *grown = realloc(writer->strings, capacity);
+        if (!grown) return 0;
+        writer->strings = grown;
+        writer->strings_capacity = capacity;
+    }
+    memcpy(writer->strings + writer->strings_size, s, len);
+    *offset = (uint32_t)writer->strings_size;
+    writer->intern[i] = *offset + 1;
+    writer->interned++;
+    writer->strings_size += len;
+    return 1;
+}
+
+int question_bank_writer_add_text(QuestionBankWriter *writer, const Question *q, const char *text) {
+    if (writer->count == writer->capacity) {
+        uint32_t capacity = writer->capacity ? writer->capacity * 2 : 1024;
+        QuestionRecord *grown = realloc(writer->records, capacity * sizeof(QuestionRecord));
+        if (!grown) return 0;
+        writer->records = grown;
+        writer->capacity = capacity;
+    }
+    QuestionRecord *r = &writer->records[writer->count];
+    memset(r, 0, sizeof(*r));
+    if (!intern(writer, text, &r->text)) return 0;
+    for (int k = 0; k < QUESTION_OPTION_COUNT; k++)
+        if (!intern(writer, q->options[k], &r->options[k])) return 0;
+    int year = atoi(q->year);
+    r->year = year > 0 && year < 65536 ? (uint16_t)year : 0;
+    r->topic = q->topic < TOPIC_COUNT ? (uint8_t)q->topic : 0;
+    r->difficulty = q->difficulty >= 1 && q->difficulty <= QUESTION_BANK_DIFFICULTIES ? (uint8_t)q->difficulty : 1;
+    r->correct_option = (uint8_t)q->correct_option;
+    r->approximate = (uint8_t)(q->approximate != 0);
+    r->answer_num = q->answer_num;
+    r->answer_den = q->answer_den > 0 ? q->answer_den : 1;
+    writer->count++;
+    return 1;
+}
+
+int question_bank_writer_add(QuestionBankWriter *writer, const Question *q) {
+    return question_bank_writer_add_text(writer, q, q->question);
+}
+
+static const QuestionRecord *sort_records;
+
+// topic, difficulty, newest year first, then id for a stable order
+static int compare_ids(const void *a, const void *b) {
+    uint32_t ia = *(const uint32_t *)a, ib = *(const uint32_t *)b;
+    const QuestionRecord *ra = &sort_records[ia], *rb = &sort_records[ib];
+    if (ra->topic != rb->topic) return ra->topic < rb->topic ? -1 : 1;
+    if (ra->difficulty != rb->difficulty) return ra->difficulty < rb->difficulty ? -1 : 1;
+    if (ra->year != rb->year) return ra->year > rb->year ? -1 : 1;
+    return ia < ib ? -1 : ia > ib;
+}
+
+static uint64_t align8(uint64_t offset) {
+    return (offset + 7) & ~(uint64_t)7;
+}
+
+static int write_at(FILE *file, uint64_t offset, const void *data, size_t size) {
+    return fseek(file, (long)offset, SEEK_SET) == 0 && fwrite(data, 1, size, file) == size;
+}
+
+int question_bank_writer_finish(QuestionBankWriter *writer, const char *path) {
+    uint32_t n = writer->count;
+    uint32_t *index = malloc((n ? n : 1) * sizeof(uint32_t));
+    if (!index) return 0;
+    for (uint32_t i = 0; i < n; i++) index[i] = i;
+    sort_records = writer->records;
+    qsort(index, n, sizeof(uint32_t), compare_ids);
+
+    QuestionBankRange ranges[RANGE_COUNT];
+    memset(ranges, 0, sizeof(ranges));
+    for (uint32_t i = 0; i < n; i++) {
+        const QuestionRecord *r = &writer->records[index[i]];
+        QuestionBankRange *range = &ranges[r->topic * QUESTION_BANK_DIFFICULTIES + r->difficulty - 1];
+        if (range->count == 0) range->start = i;
+        range->count++;
+    }
+
+    QuestionBankHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, QUESTION_BANK_MAGIC, 8);
+    h.version = QUESTION_BANK_VERSION;
+    h.question_count = n;
+    h.records_offset = align8(sizeof(h));
+    h.index_offset = align8(h.records_offset + (uint64_t)n * sizeof(QuestionRecord));
+    h.ranges_offset = align8(h.index_offset + (uint64_t)n * sizeof(uint32_t));
+    h.strings_offset = align8(h.ranges_offset + sizeof(ranges));
+    h.strings_size = writer->strings_size;
+    h.records_checksum = crc32_update(0, writer->records, (size_t)n * sizeof(QuestionRecord));
+    h.index_checksum = crc32_update(0, index, (size_t)n * sizeof(uint32_t));
+    h.strings_checksum = crc32_update(0, writer->strings, writer->strings_size);
+    h.header_checksum = header_checksum(&h);
+
+    // Write next to the target and rename, so readers never map a partial file
+    char tmp_path[4096];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+    FILE *file = fopen(tmp_path, "wb");
+    if (!file) {
+        fprintf(stderr, "Error: Could not create %s\n", tmp_path);
+        free(index);
+        return 0;
+    }
+    int ok = write_at(file, 0, &h, sizeof(h)) &&
+             write_at(file, h.records_offset, writer->records, (size_t)n * sizeof(QuestionRecord)) &&
+             write_at(file, h.index_offset, index, (size_t)n * sizeof(uint32_t)) &&
+             write_at(file, h.ranges_offset, ranges, sizeof(ranges)) &&
+             write_at(file, h.strings_offset, writer->strings, writer->strings_size);
+    ok = fclose(file) == 0 && ok;
+    free(index);
+    if (!ok || rename(tmp_path, path) != 0) {
+        fprintf(stderr, "Error: Could not write %s\n", path);
+        unlink(tmp_path);
+        return 0;
+    }
+    return 1;
+}
@@ -0,0 +1,87 @@
+// question_bank.h
+#ifndef QUESTION_BANK_H
+#define QUESTION_BANK_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "question.h"
+
+// On-disk layout (native byte order, every section 8-byte aligned):
+//   QuestionBankHeader
+//   QuestionRecord[question_count]
+//   uint32_t index[question_count]     question ids sorted by topic, difficulty, year (newest first)
+//   QuestionBankRange[TOPIC_COUNT * 3] slice of index per topic and difficulty
+//   string pool                        interned, NUL-terminated UTF-8
+
+#define QUESTION_BANK_MAGIC "SMQBANK1"
+#define QUESTION_BANK_VERSION 1
+#define QUESTION_BANK_DIFFICULTIES 3
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t question_count;
+    uint64_t records_offset;
+    uint64_t index_offset;
+    uint64_t ranges_offset;
+    uint64_t strings_offset;
+    uint64_t strings_size;
+    uint32_t records_checksum;
+    uint32_t index_checksum;
+    uint32_t strings_checksum;
+    uint32_t header_checksum;   // over every field above
+} QuestionBankHeader;
+
+typedef struct {
+    uint32_t text;              // offsets into the string pool
+    uint32_t options[QUESTION_OPTION_COUNT];
+    uint16_t year;              // 0 when unknown
+    uint8_t topic;
+    uint8_t difficulty;
+    uint8_t correct_option;
+    uint8_t approximate;
+    uint8_t reserved[2];
+    int64_t answer_num;
+    int64_t answer_den;
+} QuestionRecord;
+
+typedef struct {
+    uint32_t start;
+    uint32_t count;
+} QuestionBankRange;
+
+typedef struct QuestionBank QuestionBank;
+
+// Map a bank read-only. Only the header is validated, so opening costs the
+// same for any bank size and pages are read as questions are touched.
+QuestionBank* question_bank_open(const char *path);
+void question_bank_close(QuestionBank *bank);
+
+// Checksum every section (reads the whole file)
+int question_bank_verify(const QuestionBank *bank);
+
+uint32_t question_bank_count(const QuestionBank *bank);
+const QuestionRecord* question_bank_record(const QuestionBank *bank, uint32_t id);
+const char* question_bank_string(const QuestionBank *bank, uint32_t offset);
+
+// Copy a question out of the bank (text longer than Question.question is truncated)
+int question_bank_get(const QuestionBank *bank, uint32_t id, Question *out);
+
+// Ids of questions with the given topic and difficulty (1-3) and
+// year_from <= year <= year_to (0 for no bound), newest first. Matches are
+// contiguous in the index; returns their count and sets *ids. No match
+// (0, NULL) when the bank's slice for them falls outside it (unverified).
+uint32_t question_bank_find(const QuestionBank *bank, QuestionTopic topic, int difficulty,
+                            int year_from, int year_to, const uint32_t **ids);
+
+// Building a bank: add questions, then write the file.
+typedef struct QuestionBankWriter QuestionBankWriter;
+
+QuestionBankWriter* question_bank_writer_new(void);
+int question_bank_writer_add(QuestionBankWriter *writer, const Question *q);
+// Like _add but without the Question text length limit
+int question_bank_writer_add_text(QuestionBankWriter *writer, const Question *q, const char *text);
+int question_bank_writer_finish(QuestionBankWriter *writer, const char *path);
+void question_bank_writer_free(QuestionBankWriter *writer);
+
+#endif
@@ -0,0 +1,298 @@
+#include <stdio.h>
+#include <string.h>
+#include "question_gen.h"
+
+// Small append-only writer, faster than snprintf on the generation path
+typedef struct {
+    char *p;
+    char *end;
+} Text;
+
+static void put_str(Text *t, const char *s) {
+    while (*s && t->p < t->end) *t->p++ = *s++;
+}
+
+static void put_int(Text *t, long long v) {
+    char digits[24];
+    int n = 0;
+    unsigned long long u = v < 0 ? 0ULL - (unsigned long long)v : (unsigned long long)v;
+    do { digits[n++] = (char)('0' + u % 10); u /= 10; } while (u);
+    if (v < 0 && t->p < t->end) *t->p++ = '-';
+    while (n && t->p < t->end) *t->p++ = digits[--n];
+}
+
+// Fixed-point value with two decimals, e.g. 1498 -> "14.98"
+static void put_hundredths(Text *t, long long v) {
+    put_int(t, v / 100);
+    if (t->p + 3 > t->end) return;
+    *t->p++ = '.';
+    *t->p++ = (char)('0' + (v / 10) % 10);
+    *t->p++ = (char)('0' + v % 10);
+}
+
+static void put_fraction(Text *t, long long num, long long den) {
+    put_int(t, num);
+    if (den != 1) {
+        put_str(t, "/");
+        put_int(t, den);
+    }
+}
+
+static void text_begin(Text *t, char *buf, size_t size) {
+    t->p = buf;
+    t->end = buf + size - 1;
+}
+
+static void text_end(Text *t) {
+    *t->p = '\0';
+}
+
+// xorshift64* generator
+static uint64_t next_random(QuestionGen *gen) {
+    uint64_t x = gen->state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    gen->state = x;
+    return x * 0x2545F4914F6CDD1DULL;
+}
+
+// Uniform-ish integer in [lo, hi]
+static long long pick(QuestionGen *gen, long long lo, long long hi) {
+    return lo + (long long)(next_random(gen) % (uint64_t)(hi - lo + 1));
+}
+
+static long long gcd(long long a, long long b) {
+    if (a < 0) a = -a;
+    if (b < 0) b = -b;
+    while (b) { long long r = a % b; a = b; b = r; }
+    return a;
+}
+
+static void set_answer(Question *q, long long num, long long den) {
+    long long g = gcd(num, den);
+    if (g == 0) g = 1;
+    if (den < 0) g = -g;
+    q->answer_num = num / g;
+    q->answer_den = den / g;
+}
+
+static int already_used(const long long (*values)[2], int count, long long num, long long den) {
+    for (int i = 0; i < count; i++)
+        if (values[i][0] * den == num * values[i][1]) return 1;
+    return 0;
+}
+
+// Place the correct value at a random slot and fill the rest with plausible
+// distractors: nearby values at multiples of step (or nearby fractions).
+static void make_options(QuestionGen *gen, Question *q, long long num, long long den, long long step) {
+    long long values[QUESTION_OPTION_COUNT][2];
+    int count = 0;
+    values[count][0] = num;
+    values[count][1] = den;
+    count++;
+
+    static const int offsets[] = { -3, -2, -1, 1, 2, 3, 4, -4 };
+    int start = (int)pick(gen, 0, 7);
+    for (int i = 0; count < QUESTION_OPTION_COUNT && i < 64; i++) {
+        long long dn = num, dd = den;
+        int k = offsets[(start + i) % 8] * (1 + i / 8);
+        if (den == 1) {
+            dn = num + k * step;
+        } else if (i % 2) {
+            dn = num + k;
+        } else {
+            dd = den + k;
+            if (dd <= 0) continue;
+        }
+        long long g = gcd(dn, dd);
+        if (g == 0) continue;
+        dn /= g;
+        dd /= g;
+        if ((num > 0 && dn <= 0) || already_used((const long long (*)[2])values, count, dn, dd)) continue;
+        values[count][0] = dn;
+        values[count][1] = dd;
+        count++;
+    }
+
+    // Shuffle so the answer is not always first
+    q->correct_option = (int)pick(gen, 0, QUESTION_OPTION_COUNT - 1);
+    long long tmp0 = values[0][0], tmp1 = values[0][1];
+    values[0][0] = values[q->correct_option][0];
+    values[0][1] = values[q->correct_option][1];
+    values[q->correct_option][0] = tmp0;
+    values[q->correct_option][1] = tmp1;
+
+    for (int i = 0; i < QUESTION_OPTION_COUNT; i++) {
+        Text t;
+        text_begin(&t, q->options[i], sizeof(q->options[i]));
+        if (i < count) put_fraction(&t, values[i][0], values[i][1]);
+        text_end(&t);
+    }
+}
+
+// a × b + c ÷ e - f = ?
+static void gen_simplification(QuestionGen *gen, Question *q) {
+    int d = q->difficulty;
+    long long a = pick(gen, 11, 20 + 30 * d);
+    long long b = pick(gen, 3, 9 + 10 * d);
+    long long e = pick(gen, 2, 6 + 3 * d);
+    long long c = e * pick(gen, 5, 10 + 20 * d);
+    long long f = pick(gen, 10, 99 * d);
+    if (f >= a * b) f = a * b / 2;   // keep the answer positive
+    long long answer = a * b + c / e - f;
+
+    Text t;
+    text_begin(&t, q->question, sizeof(q->question));
+    put_int(&t, a); put_str(&t, " × "); put_int(&t, b);
+    put_str(&t, " + "); put_int(&t, c); put_str(&t, " ÷ "); put_int(&t, e);
+    put_str(&t, " - "); put_int(&t, f); put_str(&t, " = ?");
+    text_end(&t);
+
+    set_answer(q, answer, 1);
+    make_options(gen, q, answer, 1, pick(gen, 1, 3) * (d > 1 ? 5 : 1));
+}
+
+// Nudge a round value by a few hundredths, e.g. 600 -> 601.02 or 598.97
+static long long blur(QuestionGen *gen, long long whole) {
+    long long v = whole * 100 + pick(gen, 1, 29);
+    return pick(gen, 0, 1) ? v : whole * 200 - v;
+}
+
+// p% of N + a × c ≈ ?, with every operand slightly off a round number
+static void gen_approximation(QuestionGen *gen, Question *q) {
+    static const int percents[] = { 5, 10, 15, 20, 25, 30, 40, 45, 60, 75 };
+    int d = q->difficulty;
+    long long p = percents[pick(gen, 0, 9)];
+    long long n = (100 / gcd(p, 100)) * pick(gen, 2, 10 * d + 5);
+    long long a = pick(gen, 6, 10 + 10 * d);
+    long long c = pick(gen, 4, 9 + 6 * d);
+
+    long long ph = blur(gen, p), nh = blur(gen, n), ah = blur(gen, a), ch = blur(gen, c);
+
+    Text t;
+    text_begin(&t, q->question, sizeof(q->question));
+    put_hundredths(&t, ph); put_str(&t, "% of "); put_hundredths(&t, nh);
+    put_str(&t, " + "); put_hundredths(&t, ah); put_str(&t, " × "); put_hundredths(&t, ch);
+    put_str(&t, " ≈ ?");
+    text_end(&t);
+
+    // Exact value of the printed expression: ph/100 % of nh/100 plus ah/100 × ch/100
+    long long exact = ph * nh + ah * ch * 100;
+    set_answer(q, exact, 1000000);
+    q->approximate = 1;
+
+    // The blur moves the value by up to ~0.3 × (a + c), more than half the
+    // gap between options: key the multiple of step nearest the exact value,
+    // not the sum of the round numbers, so no distractor is closer
+    long long rounded = p * n / 100 + a * c;
+    long long step = rounded >= 200 ? 10 : 5;
+    long long key = (exact + 500000 * step) / (1000000 * step) * step;
+    make_options(gen, q, key, 1, step);
+}
+
+// p% of N (+ r% of M) = ?
+static void gen_percentage(QuestionGen *gen, Question *q) {
+    static const int percents[] = { 5, 8, 12, 15, 16, 20, 25, 35, 40, 45, 60, 75, 125, 150 };
+    int d = q->difficulty;
+    long long p = percents[pick(gen, 0, 13)];
+    long long n = (100 / gcd(p, 100)) * pick(gen, 2, 8 + 8 * d);
+    long long answer = p * n / 100;
+
+    Text t;
+    text_begin(&t, q->question, sizeof(q->question));
+    put_int(&t, p); put_str(&t, "% of "); put_int(&t, n);
+    if (d > 1) {
+        long long r = percents[pick(gen, 0, 13)];
+        long long m = (100 / gcd(r, 100)) * pick(gen, 2, 8 + 8 * d);
+        answer += r * m / 100;
+        put_str(&t, " + "); put_int(&t, r); put_str(&t, "% of "); put_int(&t, m);
+    }
+    put_str(&t, " = ?");
+    text_end(&t);
+
+    set_answer(q, answer, 1);
+    make_options(gen, q, answer, 1, answer >= 100 ? 5 : 1);
+}
+
+// a² + b³ - c = ?  or  √(k²) × a + b² = ?
+static void gen_square_cube(QuestionGen *gen, Question *q) {
+    int d = q->difficulty;
+    long long answer;
+    Text t;
+    text_begin(&t, q->question, sizeof(q->question));
+    if (pick(gen, 0, 1)) {
+        long long a = pick(gen, 11, 15 + 12 * d);
+        long long b = pick(gen, 2, 5 + 4 * d);
+        long long c = pick(gen, 10, 50 * d);
+        answer = a * a + b * b * b - c;
+        put_int(&t, a); put_str(&t, "² + "); put_int(&t, b); put_str(&t, "³ - ");
+        put_int(&t, c); put_str(&t, " = ?");
+    } else {
+        long long k = pick(gen, 6, 15 + 10 * d);
+        long long a = pick(gen, 3, 9 + 3 * d);
+        long long b = pick(gen, 11, 12 + 10 * d);
+        answer = k * a + b * b;
+        put_str(&t, "√"); put_int(&t, k * k); put_str(&t, " × "); put_int(&t, a);
+        put_str(&t, " + "); put_int(&t, b); put_str(&t, "² = ?");
+    }
+    text_end(&t);
+
+    set_answer(q, answer, 1);
+    make_options(gen, q, answer, 1, pick(gen, 1, 2) * (d > 1 ? 10 : 1));
+}
+
+// a/b of N + c/e of M = ?  or  a/b + c/e = ?
+static void gen_fraction(QuestionGen *gen, Question *q) {
+    int d = q->difficulty;
+    long long b = pick(gen, 2, 6 + 3 * d), e = pick(gen, 2, 6 + 3 * d);
+    long long a = pick(gen, 1, b - 1), c = pick(gen, 1, e - 1);
+    Text t;
+    text_begin(&t, q->question, sizeof(q->question));
+    if (pick(gen, 0, 1)) {
+        long long n = b * pick(gen, 3, 10 + 10 * d), m = e * pick(gen, 3, 10 + 10 * d);
+        long long answer = a * n / b + c * m / e;
+        put_fraction(&t, a, b); put_str(&t, " of "); put_int(&t, n); put_str(&t, " + ");
+        put_fraction(&t, c, e); put_str(&t, " of "); put_int(&t, m); put_str(&t, " = ?");
+        set_answer(q, answer, 1);
+        make_options(gen, q, answer, 1, answer >= 100 ? 5 : 1);
+    } else {
+        put_fraction(&t, a, b); put_str(&t, " + "); put_fraction(&t, c, e); put_str(&t, " = ?");
+        set_answer(q, a * e + c * b, b * e);
+        make_options(gen, q, q->answer_num, q->answer_den, 1);
+    }
+    text_end(&t);
+}
+
+void question_gen_init(QuestionGen *gen, uint64_t seed) {
+    // splitmix64 so that nearby seeds give unrelated streams (state must be non-zero)
+    uint64_t z = seed + 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    z ^= z >> 31;
+    gen->state = z ? z : 0x9E3779B97F4A7C15ULL;
+}
+
+void question_gen_next(QuestionGen *gen, QuestionTopic topic, int difficulty, Question *out) {
+    memset(out, 0, sizeof(*out));
+    out->topic = topic < TOPIC_COUNT ? topic : (QuestionTopic)pick(gen, 0, TOPIC_COUNT - 1);
+    out->difficulty = difficulty >= 1 && difficulty <= 3 ? difficulty : (int)pick(gen, 1, 3);
+    strcpy(out->year, "Practice");
+
+    switch (out->topic) {
+    case TOPIC_SIMPLIFICATION: gen_simplification(gen, out); break;
+    case TOPIC_APPROXIMATION:  gen_approximation(gen, out); break;
+    case TOPIC_PERCENTAGE:     gen_percentage(gen, out); break;
+    case TOPIC_SQUARE_CUBE:    gen_square_cube(gen, out); break;
+    case TOPIC_FRACTION:       gen_fraction(gen, out); break;
+    default: break;
+    }
+}
+
+size_t question_format(const Question *q, char *buf, size_t size) {
+    int n = snprintf(buf, size, "%s (%s, %s)\n%s\n", question_topic_name(q->topic), q->year,
+                     q->approximate ? "approximate value" : "exact value", q->question);
+    for (int i = 0; i < QUESTION_OPTION_COUNT && n >= 0 && (size_t)n < size; i++)
+        n += snprintf(buf + n, size - n, "%c) %s\n", 'A' + i, q->options[i]);
+    return n < 0 ? 0 : (size_t)n < size ? (size_t)n : size - 1;
+}
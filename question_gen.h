@@ -0,0 +1,25 @@
+// question_gen.h
+#ifndef QUESTION_GEN_H
+#define QUESTION_GEN_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "question.h"
+
+#define QUESTION_GEN_ANY_TOPIC TOPIC_COUNT
+
+// Offline generator for banking-exam style speed math questions
+typedef struct {
+    uint64_t state;
+} QuestionGen;
+
+void question_gen_init(QuestionGen *gen, uint64_t seed);
+
+// Fill out with a new question; topic may be QUESTION_GEN_ANY_TOPIC and
+// difficulty 0 for a random one
+void question_gen_next(QuestionGen *gen, QuestionTopic topic, int difficulty, Question *out);
+
+// Render the question and its lettered options for display
+size_t question_format(const Question *q, char *buf, size_t size);
+
+#endif
@@ -0,0 +1,81 @@
+#include "question_queue.h"
+
+struct QuestionQueue {
+    GQueue *ready;
+    guint capacity;
+    guint in_flight;
+    QuestionFetchFunc fetch;
+    gpointer fetch_data;
+    GDestroyNotify free_question;
+    QuestionReadyFunc waiting;     // consumer blocked on a miss
+    gpointer waiting_data;
+    gulong hits;
+    gulong misses;
+};
+
+QuestionQueue* question_queue_new(guint capacity, QuestionFetchFunc fetch, gpointer fetch_data,
+                                  GDestroyNotify free_question) {
+    QuestionQueue *queue = g_new0(QuestionQueue, 1);
+    queue->ready = g_queue_new();
+    queue->capacity = capacity ? capacity : 1;
+    queue->fetch = fetch;
+    queue->fetch_data = fetch_data;
+    queue->free_question = free_question;
+    return queue;
+}
+
+void question_queue_free(QuestionQueue *queue) {
+    if (!queue) return;
+    g_queue_free_full(queue->ready, queue->free_question);
+    g_free(queue);
+}
+
+void question_queue_refill(QuestionQueue *queue) {
+    // A waiting consumer counts as demand for one more question
+    guint want = queue->capacity + (queue->waiting ? 1 : 0);
+    while (g_queue_get_length(queue->ready) + queue->in_flight < want) {
+        queue->in_flight++;
+        queue->fetch(queue, queue->fetch_data);
+    }
+}
+
+void question_queue_push(QuestionQueue *queue, gpointer question) {
+    if (queue->in_flight) queue->in_flight--;
+
+    if (question) {
+        if (queue->waiting) {
+            QuestionReadyFunc ready = queue->waiting;
+            queue->waiting = NULL;
+            ready(question, queue->waiting_data);
+        } else {
+            g_queue_push_tail(queue->ready, question);
+        }
+        question_queue_refill(queue);
+    }
+    // On failure the slot stays empty until the next pop or explicit refill,
+    // so a dead network does not turn into a tight retry loop.
+}
+
+void question_queue_next(QuestionQueue *queue, QuestionReadyFunc ready, gpointer user_data) {
+    gpointer question = g_queue_pop_head(queue->ready);
+    if (question) {
+        queue->hits++;
+        queue->waiting = NULL;
+        ready(question, user_data);
+    } else {
+        queue->misses++;
+        queue->waiting = ready;
+        queue->waiting_data = user_data;
+    }
+    question_queue_refill(queue);
+}
+
+QuestionQueueStats question_queue_stats(const QuestionQueue *queue) {
+    QuestionQueueStats stats;
+    stats.ready = g_queue_get_length(queue->ready);
+    stats.in_flight = queue->in_flight;
+    stats.capacity = queue->capacity;
+    stats.hits = queue->hits;
+    stats.misses = queue->misses;
+    return stats;
+}
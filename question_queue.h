@@ -0,0 +1,41 @@
+// question_queue.h
+#ifndef QUESTION_QUEUE_H
+#define QUESTION_QUEUE_H
+
+#include <glib.h>
+
+// Bounded queue of ready-to-show questions, refilled in the background.
+typedef struct QuestionQueue QuestionQueue;
+
+// Start producing one question; the producer later calls question_queue_push
+// (with NULL if it failed). Runs on the main loop.
+typedef void (*QuestionFetchFunc)(QuestionQueue *queue, gpointer user_data);
+
+// Receives the next question; ownership passes to the callee.
+typedef void (*QuestionReadyFunc)(gpointer question, gpointer user_data);
+
+typedef struct {
+    guint ready;        // questions waiting in the queue
+    guint in_flight;    // fetches started but not yet pushed
+    guint capacity;
+    gulong hits;        // next-question requests served without waiting
+    gulong misses;      // next-question requests that had to wait for a fetch
+} QuestionQueueStats;
+
+QuestionQueue* question_queue_new(guint capacity, QuestionFetchFunc fetch, gpointer fetch_data,
+                                  GDestroyNotify free_question);
+void question_queue_free(QuestionQueue *queue);
+
+// Start fetches until ready + in_flight reaches the capacity
+void question_queue_refill(QuestionQueue *queue);
+
+// Deliver a fetched question (or NULL on failure) and top the queue up again
+void question_queue_push(QuestionQueue *queue, gpointer question);
+
+// Hand the next question to ready: immediately on a hit, or as soon as the
+// next fetch completes on a miss. A newer call replaces a pending one.
+void question_queue_next(QuestionQueue *queue, QuestionReadyFunc ready, gpointer user_data);
+
+QuestionQueueStats question_queue_stats(const QuestionQueue *queue);
+
+#endif
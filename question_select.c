@@ -0,0 +1,270 @@
+#include <stdlib.h>
+#include <string.h>
+#include "question_select.h"
+
+#define NO_GROUP 0xFF
+#define IN_HEAP 0x80000000u   // slot bit: the rest indexes the heap, else the unseen pool
+#define MAX_STREAK 16
+
+typedef struct {
+    uint64_t *heap;           // seen questions, soonest review first: due tick << 32 | id
+    uint32_t heap_count;
+    uint32_t *unseen;         // in no order; drawn at random
+    uint32_t unseen_count;
+    uint32_t capacity;        // of each array
+    // Weakness
+    uint64_t attempts;
+    double time;              // EWMA of solve times, seconds
+    double error;             // EWMA of wrong answers (0 or 1)
+    double weight;
+} Group;
+
+struct QuestionSelect {
+    uint32_t count;
+    uint32_t tick;            // questions chosen so far
+    uint64_t state;           // xorshift64*
+    // Per question, by id
+    uint8_t *group;
+    uint8_t *streak;          // quick right answers in a row
+    uint32_t *slot;           // where it is in its group
+    Group groups[QUESTION_SELECT_GROUPS];
+    uint64_t attempts;
+    double time;              // EWMA over every group
+};
+
+static uint64_t next_random(QuestionSelect *select) {
+    uint64_t x = select->state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    select->state = x;
+    return x * 0x2545F4914F6CDD1DULL;
+}
+
+static int group_of(QuestionTopic topic, int difficulty) {
+    if (difficulty < 1) difficulty = 1;
+    if (difficulty > QUESTION_SELECT_DIFFICULTIES) difficulty = QUESTION_SELECT_DIFFICULTIES;
+    return (int)topic * QUESTION_SELECT_DIFFICULTIES + difficulty - 1;
+}
+
+// Slow groups weigh up to 3 times more, fast ones half; errors add on top
+// of a floor that keeps mastered groups coming up now and then. Untried
+// groups count as half wrong, so they get explored early.
+static void update_weight(const QuestionSelect *select, Group *g) {
+    double slow = 1;
+    if (g->attempts && select->time > 0) {
+        slow = g->time / select->time;
+        if (slow < 0.5) slow = 0.5;
+        if (slow > 3) slow = 3;
+    }
+    g->weight = slow * (0.15 + (g->attempts ? g->error : 0.5));
+}
+
+QuestionSelect* question_select_new(uint32_t count, uint64_t seed) {
+    QuestionSelect *select = calloc(1, sizeof(*select));
+    if (!select) return NULL;
+    select->count = count;
+    select->state = seed ? seed : 0x9E3779B97F4A7C15ULL;
+    if (count) {
+        select->group = malloc(count);
+        select->streak = calloc(count, 1);
+        select->slot = malloc(count * sizeof(uint32_t));
+        if (!select->group || !select->streak || !select->slot) {
+            question_select_free(select);
+            return NULL;
+        }
+        memset(select->group, NO_GROUP, count);
+    }
+    for (int i = 0; i < QUESTION_SELECT_GROUPS; i++) update_weight(select, &select->groups[i]);
+    return select;
+}
+
+void question_select_free(QuestionSelect *select) {
+    if (!select) return;
+    for (int i = 0; i < QUESTION_SELECT_GROUPS; i++) {
+        free(select->groups[i].heap);
+        free(select->groups[i].unseen);
+    }
+    free(select->group);
+    free(select->streak);
+    free(select->slot);
+    free(select);
+}
+
+int question_select_add(QuestionSelect *select, uint32_t id, QuestionTopic topic, int difficulty) {
+    if (id >= select->count || select->group[id] != NO_GROUP || (unsigned)topic >= TOPIC_COUNT) return 0;
+    int index = group_of(topic, difficulty);
+    Group *g = &select->groups[index];
+    // A question moves between the arrays but is in only one: each needs
+    // room for every question of the group
+    if (g->heap_count + g->unseen_count == g->capacity) {
+        uint32_t capacity = g->capacity ? g->capacity * 2 : 64;
+        uint64_t *heap = realloc(g->heap, capacity * sizeof(uint64_t));
+        if (heap) g->heap = heap;
+        uint32_t *unseen = realloc(g->unseen, capacity * sizeof(uint32_t));
+        if (unseen) g->unseen = unseen;
+        if (!heap || !unseen) return 0;
+        g->capacity = capacity;
+    }
+    select->group[id] = (uint8_t)index;
+    select->slot[id] = g->unseen_count;
+    g->unseen[g->unseen_count++] = id;
+    return 1;
+}
+
+// The key holds the review tick above the id, so one compare orders by
+// tick and then id (the same order every run), and sifting never has to
+// look a question up elsewhere
+static uint32_t key_id(uint64_t key) {
+    return (uint32_t)key;
+}
+
+static uint32_t key_due(uint64_t key) {
+    return (uint32_t)(key >> 32);
+}
+
+static void heap_place(QuestionSelect *select, Group *g, uint32_t at, uint64_t key) {
+    g->heap[at] = key;
+    select->slot[key_id(key)] = at | IN_HEAP;
+}
+
+// Give the question at heap position at a new review tick
+static void heap_update(QuestionSelect *select, Group *g, uint32_t at, uint32_t due) {
+    uint64_t key = (uint64_t)due << 32 | key_id(g->heap[at]);
+    while (at > 0) {
+        uint32_t parent = (at - 1) / 2;
+        if (key >= g->heap[parent]) break;
+        heap_place(select, g, at, g->heap[parent]);
+        at = parent;
+    }
+    for (;;) {
+        uint32_t child = 2 * at + 1;
+        if (child >= g->heap_count) break;
+        if (child + 1 < g->heap_count && g->heap[child + 1] < g->heap[child]) child++;
+        if (g->heap[child] >= key) break;
+        heap_place(select, g, at, g->heap[child]);
+        at = child;
+    }
+    heap_place(select, g, at, key);
+}
+
+// A question is seen: out of the unseen pool (swapping the last into its
+// place) and into the heap
+static void mark_seen(QuestionSelect *select, Group *g, uint32_t id) {
+    if (select->slot[id] & IN_HEAP) return;
+    uint32_t last = g->unseen[--g->unseen_count];
+    g->unseen[select->slot[id]] = last;
+    select->slot[last] = select->slot[id];
+    heap_place(select, g, g->heap_count++, id);   // due 0 for now: schedule places it
+}
+
+static void schedule(QuestionSelect *select, uint32_t id, uint64_t after) {
+    uint64_t due = (uint64_t)select->tick + after;
+    heap_update(select, &select->groups[select->group[id]], select->slot[id] & ~IN_HEAP,
+                due > UINT32_MAX ? UINT32_MAX : (uint32_t)due);
+}
+
+static int allowed(const QuestionSelect *select, int index, QuestionTopic topic, int difficulty) {
+    if ((unsigned)topic < TOPIC_COUNT && index / QUESTION_SELECT_DIFFICULTIES != (int)topic) return 0;
+    if (difficulty && index % QUESTION_SELECT_DIFFICULTIES != group_of(0, difficulty)) return 0;
+    const Group *g = &select->groups[index];
+    return !select->count || g->heap_count || g->unseen_count;
+}
+
+// Weighted draw over the matching groups; -1 if none has questions
+static int draw_group(QuestionSelect *select, QuestionTopic topic, int difficulty) {
+    double total = 0;
+    for (int i = 0; i < QUESTION_SELECT_GROUPS; i++)
+        if (allowed(select, i, topic, difficulty)) total += select->groups[i].weight;
+    if (total <= 0) return -1;
+    double r = (double)(next_random(select) >> 11) * 0x1.0p-53 * total;
+    int last = -1;
+    for (int i = 0; i < QUESTION_SELECT_GROUPS; i++) {
+        if (!allowed(select, i, topic, difficulty)) continue;
+        last = i;
+        r -= select->groups[i].weight;
+        if (r < 0) break;
+    }
+    return last;
+}
+
+void question_select_group(QuestionSelect *select, QuestionTopic topic, int difficulty,
+                           QuestionTopic *out_topic, int *out_difficulty) {
+    int index = draw_group(select, topic, difficulty);
+    if (index < 0) index = group_of((unsigned)topic < TOPIC_COUNT ? topic : 0, difficulty ? difficulty : 2);
+    *out_topic = (QuestionTopic)(index / QUESTION_SELECT_DIFFICULTIES);
+    *out_difficulty = index % QUESTION_SELECT_DIFFICULTIES + 1;
+}
+
+int question_select_next(QuestionSelect *select, QuestionTopic topic, int difficulty, uint32_t *id) {
+    if (!select->count) return 0;
+    int index = draw_group(select, topic, difficulty);
+    if (index < 0) return 0;
+    Group *g = &select->groups[index];
+    select->tick++;
+    uint32_t chosen;
+    if (g->heap_count && (key_due(g->heap[0]) <= select->tick || !g->unseen_count)) {
+        chosen = key_id(g->heap[0]);
+    } else {
+        chosen = g->unseen[next_random(select) % g->unseen_count];
+        mark_seen(select, g, chosen);
+    }
+    schedule(select, chosen, QUESTION_SELECT_RETRY);
+    *id = chosen;
+    return 1;
+}
+
+static void record(QuestionSelect *select, Group *g, double seconds, int correct) {
+    if (!(seconds >= 0)) return;
+    double a = STATS_EWMA_ALPHA;
+    g->time = g->attempts ? g->time + a * (seconds - g->time) : seconds;
+    g->error = g->attempts ? g->error + a * (!correct - g->error) : !correct;
+    g->attempts++;
+    select->time = select->attempts ? select->time + a * (seconds - select->time) : seconds;
+    select->attempts++;
+    // The student's pace moved, so every group's slowness did too
+    for (int i = 0; i < QUESTION_SELECT_GROUPS; i++) update_weight(select, &select->groups[i]);
+}
+
+void question_select_record(QuestionSelect *select, uint32_t id, double seconds, int correct) {
+    if (id >= select->count || select->group[id] == NO_GROUP) return;
+    Group *g = &select->groups[select->group[id]];
+    mark_seen(select, g, id);
+    if (!correct) {
+        select->streak[id] = 0;
+        schedule(select, id, QUESTION_SELECT_RETRY);
+    } else {
+        // A right but slow answer is not mastered yet: the interval stays
+        if (!g->attempts || seconds <= g->time * 1.5) {
+            if (select->streak[id] < MAX_STREAK) select->streak[id]++;
+        }
+        int streak = select->streak[id] ? select->streak[id] - 1 : 0;
+        schedule(select, id, (uint64_t)QUESTION_SELECT_REVIEW << streak);
+    }
+    record(select, g, seconds, correct);
+}
+
+void question_select_record_group(QuestionSelect *select, QuestionTopic topic, int difficulty,
+                                  double seconds, int correct) {
+    if ((unsigned)topic >= TOPIC_COUNT) return;
+    record(select, &select->groups[group_of(topic, difficulty)], seconds, correct);
+}
+
+void question_select_seed_topic(QuestionSelect *select, QuestionTopic topic, const StreamStats *times,
+                                uint64_t correct) {
+    if ((unsigned)topic >= TOPIC_COUNT || !times->count) return;
+    for (int d = 1; d <= QUESTION_SELECT_DIFFICULTIES; d++) {
+        Group *g = &select->groups[group_of(topic, d)];
+        g->attempts = times->count;
+        g->time = times->ewma;
+        g->error = 1 - (double)correct / times->count;
+    }
+    select->time = (select->time * select->attempts + times->ewma * times->count) / (select->attempts + times->count);
+    select->attempts += times->count;
+    for (int i = 0; i < QUESTION_SELECT_GROUPS; i++) update_weight(select, &select->groups[i]);
+}
+
+double question_select_weight(const QuestionSelect *select, QuestionTopic topic, int difficulty) {
+    if ((unsigned)topic >= TOPIC_COUNT) return 0;
+    return select->groups[group_of(topic, difficulty)].weight;
+}
@@ -0,0 +1,61 @@
+// question_select.h
+#ifndef QUESTION_SELECT_H
+#define QUESTION_SELECT_H
+
+#include <stdint.h>
+#include "question.h"
+#include "stats.h"
+
+// Adaptive choice of the next question among up to millions (a question
+// bank's ids), by weakness:
+//   - a topic and difficulty is drawn with a weight that grows with its
+//     recent solve times relative to the student's and its recent errors
+//   - within it, the question most overdue for review comes first (a wrong
+//     answer brings it back a few questions later, right answers push it out
+//     further each time), else one not seen yet, at random
+// Each topic and difficulty keeps an indexed min-heap of seen questions by
+// review time and a pool of unseen ones, so choosing and recording an
+// answer are O(log n) and nothing is ever scanned.
+// Time is counted in questions chosen, not in seconds.
+
+#define QUESTION_SELECT_DIFFICULTIES 3
+#define QUESTION_SELECT_GROUPS (TOPIC_COUNT * QUESTION_SELECT_DIFFICULTIES)
+#define QUESTION_SELECT_RETRY 4       // questions until a wrong one comes back
+#define QUESTION_SELECT_REVIEW 40     // until a first right one does; doubles with each quick one
+
+typedef struct QuestionSelect QuestionSelect;
+
+// Room for count questions, ids 0 to count - 1; with 0 it only tracks
+// weakness (question_select_group, for generated questions)
+QuestionSelect* question_select_new(uint32_t count, uint64_t seed);
+void question_select_free(QuestionSelect *select);
+
+// File a question under its topic and difficulty (1-3), once, before it
+// can be chosen; more can be added at any time. Returns 0 if id is out of
+// range or already filed, or on running out of memory.
+int question_select_add(QuestionSelect *select, uint32_t id, QuestionTopic topic, int difficulty);
+
+// Start the topic's weakness from earlier sessions (attempt_log_stats)
+void question_select_seed_topic(QuestionSelect *select, QuestionTopic topic, const StreamStats *times,
+                                uint64_t correct);
+
+// The weakest topic and difficulty to drill next (drawn by weight), within
+// topic (TOPIC_COUNT, i.e. QUESTION_GEN_ANY_TOPIC, for any) and difficulty (0 for any)
+void question_select_group(QuestionSelect *select, QuestionTopic topic, int difficulty,
+                           QuestionTopic *out_topic, int *out_difficulty);
+
+// The next question's id, chosen as above. It is set aside for a few
+// questions, so skipping it moves on. Returns 0 if no question matches.
+int question_select_next(QuestionSelect *select, QuestionTopic topic, int difficulty, uint32_t *id);
+
+// An answer to question id: reschedules it and updates its group's weakness
+void question_select_record(QuestionSelect *select, uint32_t id, double seconds, int correct);
+
+// An answer to a question that is not in the selector (generated)
+void question_select_record_group(QuestionSelect *select, QuestionTopic topic, int difficulty,
+                                  double seconds, int correct);
+
+// A group's current weight, relative to the others
+double question_select_weight(const QuestionSelect *select, QuestionTopic topic, int difficulty);
+
+#endif
@@ -0,0 +1,86 @@
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "question_timer.h"
+
+int64_t timer_now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+// Credit the time since the last (re)start to the current phase
+static void settle(QuestionTimer *timer, int64_t now) {
+    if (timer->running && !timer->paused)
+        timer->phase_us[timer->phase] += now - timer->since;
+    timer->since = now;
+}
+
+void question_timer_start(QuestionTimer *timer) {
+    memset(timer, 0, sizeof(*timer));
+    timer->phase = TIMER_PHASE_READ;
+    timer->running = 1;
+    timer->since = timer_now_us();
+}
+
+void question_timer_advance(QuestionTimer *timer, TimerPhase phase) {
+    if (!timer->running || phase <= timer->phase || phase >= TIMER_PHASE_COUNT) return;
+    settle(timer, timer_now_us());
+    timer->phase = phase;
+}
+
+void question_timer_pause(QuestionTimer *timer) {
+    if (!timer->running || timer->paused) return;
+    settle(timer, timer_now_us());
+    timer->paused = 1;
+}
+
+void question_timer_resume(QuestionTimer *timer) {
+    if (!timer->running || !timer->paused) return;
+    timer->paused = 0;
+    timer->since = timer_now_us();
+}
+
+int64_t question_timer_stop(QuestionTimer *timer) {
+    if (timer->running) {
+        settle(timer, timer_now_us());
+        timer->running = 0;
+        timer->paused = 0;
+    }
+    return question_timer_elapsed(timer);
+}
+
+int64_t question_timer_phase(const QuestionTimer *timer, TimerPhase phase) {
+    int64_t us = timer->phase_us[phase];
+    if (timer->running && !timer->paused && phase == timer->phase)
+        us += timer_now_us() - timer->since;
+    return us;
+}
+
+int64_t question_timer_elapsed(const QuestionTimer *timer) {
+    int64_t total = 0;
+    for (int p = 0; p < TIMER_PHASE_COUNT; p++)
+        total += question_timer_phase(timer, (TimerPhase)p);
+    return total;
+}
+
+const char* timer_phase_name(TimerPhase phase) {
+    switch (phase) {
+    case TIMER_PHASE_READ: return "read";
+    case TIMER_PHASE_THINK: return "think";
+    case TIMER_PHASE_TYPE: return "type";
+    default: return "?";
+    }
+}
+
+size_t timer_format(int64_t us, char *buf, size_t size) {
+    if (us < 0) us = 0;
+    int64_t cs = us / 10000;
+    int hundredths = (int)(cs % 100);
+    int64_t seconds = cs / 100;
+    int s = (int)(seconds % 60), m = (int)(seconds / 60 % 60);
+    long h = (long)(seconds / 3600);
+    int n = h ? snprintf(buf, size, "%ld:%02d:%02d.%02d", h, m, s, hundredths)
+              : snprintf(buf, size, "%02d:%02d.%02d", m, s, hundredths);
+    return n < 0 ? 0 : (size_t)n < size ? (size_t)n : size ? size - 1 : 0;
+}
@@ -0,0 +1,53 @@
+// question_timer.h
+#ifndef QUESTION_TIMER_H
+#define QUESTION_TIMER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Per-question stopwatch on the monotonic clock, in microseconds.
+// A question moves through READ (question on screen) -> THINK (attention
+// on the answer box) -> TYPE (first keystroke) until the answer is
+// submitted. Paused time counts towards no phase.
+typedef enum {
+    TIMER_PHASE_READ,
+    TIMER_PHASE_THINK,
+    TIMER_PHASE_TYPE,
+    TIMER_PHASE_COUNT
+} TimerPhase;
+
+typedef struct {
+    int64_t phase_us[TIMER_PHASE_COUNT];   // completed time per phase
+    int64_t since;       // when the current phase last (re)started
+    TimerPhase phase;
+    int running;
+    int paused;
+} QuestionTimer;
+
+// Monotonic clock in microseconds (never jumps with wall-clock changes)
+int64_t timer_now_us(void);
+
+// Reset and start in READ
+void question_timer_start(QuestionTimer *timer);
+
+// Move forward to phase; going back or staying put is ignored, so the
+// caller can report every keystroke without checking the state
+void question_timer_advance(QuestionTimer *timer, TimerPhase phase);
+
+void question_timer_pause(QuestionTimer *timer);
+void question_timer_resume(QuestionTimer *timer);
+
+// Stop the clock; returns the total (pauses excluded)
+int64_t question_timer_stop(QuestionTimer *timer);
+
+// Totals so far, including the running phase
+int64_t question_timer_elapsed(const QuestionTimer *timer);
+int64_t question_timer_phase(const QuestionTimer *timer, TimerPhase phase);
+
+const char* timer_phase_name(TimerPhase phase);
+
+// "MM:SS.cc" (or "H:MM:SS.cc" past an hour) into buf, without allocating.
+// Returns the length written.
+size_t timer_format(int64_t us, char *buf, size_t size);
+
+#endif
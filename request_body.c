@@ -0,0 +1,168 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "request_body.h"
+
+#define TURN_OVERHEAD 64   // {"role":"model","parts":[{"text":""}]}, and the end of the body
+
+void request_body_init(RequestBody *body) {
+    memset(body, 0, sizeof(*body));
+}
+
+void request_body_free(RequestBody *body) {
+    free(body->data);
+    memset(body, 0, sizeof(*body));
+}
+
+void request_body_reset(RequestBody *body) {
+    body->len = 0;
+    body->items = 0;
+    body->failed = 0;
+    if (body->data) body->data[0] = '\0';
+}
+
+int request_body_reserve(RequestBody *body, size_t len) {
+    if (body->failed) return 0;
+    if (body->len + len + 1 <= body->cap) return 1;
+    size_t cap = body->cap ? body->cap : 256;
+    while (cap < body->len + len + 1) cap *= 2;
+    char *data = realloc(body->data, cap);
+    if (!data) {
+        body->failed = 1;
+        return 0;
+    }
+    body->data = data;
+    body->cap = cap;
+    return 1;
+}
+
+int request_body_append(RequestBody *body, const char *json, size_t len) {
+    if (!request_body_reserve(body, len)) return 0;
+    memcpy(body->data + body->len, json, len);
+    body->len += len;
+    body->data[body->len] = '\0';
+    body->copied += len;
+    return 1;
+}
+
+static int needs_escape(unsigned char c) {
+    return c < 0x20 || c == '"' || c == '\\';
+}
+
+// First byte in [p, end) that needs escaping. Eight bytes are checked at a
+// time: a word has such a byte if one is below 0x20 or equals '"' or '\\'.
+static const char* skip_plain(const char *p, const char *end) {
+    const uint64_t ones = 0x0101010101010101ull, highs = 0x8080808080808080ull;
+    while (end - p >= 8) {
+        uint64_t w;
+        memcpy(&w, p, 8);
+        uint64_t quote = w ^ (ones * '"'), backslash = w ^ (ones * '\\');
+        uint64_t hit = ((w - ones * 0x20) & ~w) |
+                       ((quote - ones) & ~quote) |
+                       ((backslash - ones) & ~backslash);
+        if (hit & highs) break;
+        p += 8;
+    }
+    while (p < end && !needs_escape((unsigned char)*p)) p++;
+    return p;
+}
+
+int request_body_append_escaped(RequestBody *body, const char *text, size_t len) {
+    // Most text needs no escaping: room for all of it, then copy whole runs
+    if (!request_body_reserve(body, len)) return 0;
+    const char *p = text, *end = text + len;
+    while (p < end) {
+        const char *run = p;
+        p = skip_plain(p, end);
+        if (p > run && !request_body_append(body, run, p - run)) return 0;
+        if (p == end) break;
+
+        char escape[7];
+        unsigned char c = (unsigned char)*p++;
+        switch (c) {
+        case '"': memcpy(escape, "\\\"", 3); break;
+        case '\\': memcpy(escape, "\\\\", 3); break;
+        case '\n': memcpy(escape, "\\n", 3); break;
+        case '\r': memcpy(escape, "\\r", 3); break;
+        case '\t': memcpy(escape, "\\t", 3); break;
+        default: snprintf(escape, sizeof(escape), "\\u%04x", c); break;
+        }
+        if (!request_body_append(body, escape, strlen(escape))) return 0;
+    }
+    return 1;
+}
+
+char* request_body_steal(RequestBody *body, size_t *len) {
+    if (body->failed || !request_body_reserve(body, 0)) return NULL;
+    char *data = body->data;
+    if (len) *len = body->len;
+    body->data = NULL;
+    body->len = body->cap = 0;
+    body->items = 0;
+    return data;
+}
+
+int request_template_init(RequestTemplate *tmpl, const RequestOptions *options) {
+    RequestBody head;
+    request_body_init(&head);
+    request_body_append(&head, "{", 1);
+    if (options && options->system_prompt && *options->system_prompt) {
+        static const char open[] = "\"systemInstruction\":{\"parts\":[{\"text\":\"";
+        request_body_append(&head, open, sizeof(open) - 1);
+        request_body_append_escaped(&head, options->system_prompt, strlen(options->system_prompt));
+        request_body_append(&head, "\"}]},", 5);
+    }
+    if (options && (options->temperature >= 0 || options->max_output_tokens > 0)) {
+        char config[128];
+        int n = snprintf(config, sizeof(config), "\"generationConfig\":{");
+        // Written by hand: %g follows the locale, and GTK may pick one with decimal commas
+        long milli = (long)(options->temperature * 1000 + 0.5);
+        if (options->temperature >= 0)
+            n += snprintf(config + n, sizeof(config) - n, "\"temperature\":%ld.%03ld%s", milli / 1000, milli % 1000,
+                          options->max_output_tokens > 0 ? "," : "");
+        if (options->max_output_tokens > 0)
+            n += snprintf(config + n, sizeof(config) - n, "\"maxOutputTokens\":%d", options->max_output_tokens);
+        snprintf(config + n, sizeof(config) - n, "},");
+        request_body_append(&head, config, strlen(config));
+    }
+    static const char contents[] = "\"contents\":[";
+    request_body_append(&head, contents, sizeof(contents) - 1);
+
+    tmpl->head = request_body_steal(&head, &tmpl->head_len);
+    request_body_free(&head);
+    return tmpl->head != NULL;
+}
+
+void request_template_free(RequestTemplate *tmpl) {
+    free(tmpl->head);
+    tmpl->head = NULL;
+    tmpl->head_len = 0;
+}
+
+int request_body_begin(RequestBody *body, const RequestTemplate *tmpl, size_t expect_len) {
+    request_body_reset(body);
+    return request_body_reserve(body, tmpl->head_len + expect_len + TURN_OVERHEAD) &&
+           request_body_append(body, tmpl->head, tmpl->head_len);
+}
+
+int request_body_add_turn(RequestBody *body, const char *role, const char *text, size_t len) {
+    static const char parts[] = "\",\"parts\":[{\"text\":\"";
+    if (body->items++ && !request_body_append(body, ",", 1)) return 0;
+    return request_body_append(body, "{\"role\":\"", 9) &&
+           request_body_append(body, role, strlen(role)) &&
+           request_body_append(body, parts, sizeof(parts) - 1) &&
+           request_body_append_escaped(body, text, len) &&
+           request_body_append(body, "\"}]}", 4);
+}
+
+int request_body_end(RequestBody *body) {
+    return request_body_append(body, "]}", 2);
+}
+
+int request_body_build(RequestBody *body, const RequestTemplate *tmpl, const char *text) {
+    size_t len = strlen(text);
+    return request_body_begin(body, tmpl, len) &&
+           request_body_add_turn(body, "user", text, len) &&
+           request_body_end(body);
+}
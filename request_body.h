@@ -0,0 +1,61 @@
+// request_body.h
+#ifndef REQUEST_BODY_H
+#define REQUEST_BODY_H
+
+#include <stddef.h>
+
+// Growable JSON request body. Text is escaped as it is appended, so any
+// prompt gives valid JSON, and nothing is ever truncated.
+typedef struct {
+    char *data;        // always NUL-terminated once anything was appended
+    size_t len;
+    size_t cap;
+    size_t copied;     // bytes written since init (for measuring)
+    int items;         // turns added since request_body_begin, for commas
+    int failed;        // out of memory: the body is incomplete
+} RequestBody;
+
+void request_body_init(RequestBody *body);
+void request_body_free(RequestBody *body);
+// Empty the body but keep the allocation
+void request_body_reset(RequestBody *body);
+// Make room for len more bytes (plus the NUL) in one allocation
+int request_body_reserve(RequestBody *body, size_t len);
+
+int request_body_append(RequestBody *body, const char *json, size_t len);   // as is
+// Text as the inside of a JSON string: quotes, backslashes and control
+// characters escaped
+int request_body_append_escaped(RequestBody *body, const char *text, size_t len);
+
+// Take the contents (malloc'd, NUL-terminated); the body is left empty
+char* request_body_steal(RequestBody *body, size_t *len);
+
+// Options that are the same for every request
+typedef struct {
+    const char *system_prompt;   // systemInstruction text; NULL for none
+    double temperature;          // < 0 for the model default
+    int max_output_tokens;       // 0 for the model default
+} RequestOptions;
+
+// A generateContent body serialized once up to the contents array:
+//   {"systemInstruction":...,"generationConfig":...,"contents":[
+// so a request only adds its turns and "]}".
+typedef struct {
+    char *head;
+    size_t head_len;
+} RequestTemplate;
+
+int request_template_init(RequestTemplate *tmpl, const RequestOptions *options);
+void request_template_free(RequestTemplate *tmpl);
+
+// Start a request from the template; expect_len (the text about to be
+// added, 0 if unknown) sizes the one allocation up front
+int request_body_begin(RequestBody *body, const RequestTemplate *tmpl, size_t expect_len);
+// role is "user" or "model"
+int request_body_add_turn(RequestBody *body, const char *role, const char *text, size_t len);
+int request_body_end(RequestBody *body);
+
+// One-turn request: begin, a user turn with text, end
+int request_body_build(RequestBody *body, const RequestTemplate *tmpl, const char *text);
+
+#endif
@@ -0,0 +1,401 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "request_engine.h"
+#include "connection_pool.h"
+#include "response_buffer.h"
+
+#define MAX_IDLE_REQUESTS 4
+
+// One transfer owned by the engine
+typedef struct {
+    guint id;
+    CURL *easy;
+    struct curl_slist *headers;
+    GBytes *post_body;      // sent in place (request_engine_post_bytes)
+    ResponseBuffer body;
+    RequestDataFunc data;   // when set, the body is streamed instead of collected
+    gint64 decoded;         // body bytes after curl undid the Content-Encoding
+    RequestDoneFunc done;
+    gpointer user_data;
+    gboolean started;       // added to the multi handle, else waiting
+} Request;
+
+// GLib watch for one socket curl asked us to monitor
+typedef struct {
+    GIOChannel *channel;
+    guint source_id;
+} SocketWatch;
+
+struct RequestEngine {
+    CURLM *multi;
+    ConnectionPool *pool;
+    GQueue *idle_requests;  // finished requests whose handle and buffer are reused
+    GHashTable *requests;   // id -> Request*, started or waiting
+    GQueue *waiting;        // beyond the pool's transfer limit, oldest first
+    guint started;          // requests in the multi handle
+    guint next_id;
+    guint timer_id;
+    int running;
+    Request *finishing;     // request whose done callback is running
+};
+
+static void check_multi_info(RequestEngine *engine);
+static void start_waiting(RequestEngine *engine);
+
+// Write Callback for CURL
+static size_t write_callback(char *contents, size_t size, size_t nmemb, void *userp) {
+    Request *req = userp;
+    size_t total_size = size * nmemb;
+    req->decoded += total_size;
+    if (!req->data)
+        return response_buffer_write_callback(contents, size, nmemb, &req->body);
+    req->data(req->id, contents, total_size, req->user_data);
+    return total_size;
+}
+
+static void request_destroy(gpointer data) {
+    Request *req = data;
+    curl_easy_cleanup(req->easy);
+    response_buffer_free(&req->body);
+    g_free(req);
+}
+
+// Recycle a finished request; its easy handle keeps curl's caches warm and
+// its buffer keeps its capacity
+static void request_free(RequestEngine *engine, Request *req) {
+    curl_slist_free_all(req->headers);
+    req->headers = NULL;
+    if (req->post_body) g_bytes_unref(req->post_body);
+    req->post_body = NULL;
+    if (g_queue_get_length(engine->idle_requests) >= MAX_IDLE_REQUESTS) {
+        request_destroy(req);
+        return;
+    }
+    curl_easy_reset(req->easy);
+    response_buffer_reset(&req->body);
+    req->data = NULL;
+    req->done = NULL;
+    req->user_data = NULL;
+    g_queue_push_tail(engine->idle_requests, req);
+}
+
+// Detach a request from the multi handle and report it to its owner
+static void request_finish(RequestEngine *engine, Request *req, CURLcode result) {
+    long http_status = 0;
+    if (result == CURLE_OK) {
+        curl_easy_getinfo(req->easy, CURLINFO_RESPONSE_CODE, &http_status);
+        connection_pool_record(engine->pool, req->easy);
+    }
+
+    if (req->started) {
+        curl_multi_remove_handle(engine->multi, req->easy);
+        req->started = FALSE;
+        engine->started--;
+    } else {
+        g_queue_remove(engine->waiting, req);
+    }
+    g_hash_table_remove(engine->requests, GUINT_TO_POINTER(req->id));
+    // The freed slot goes to the oldest waiting request, before done can
+    // queue a new one
+    start_waiting(engine);
+
+    engine->finishing = req;
+    if (req->done)
+        req->done(req->id, result, http_status, response_buffer_str(&req->body), req->body.len, req->user_data);
+    engine->finishing = NULL;
+    request_free(engine, req);
+}
+
+// Socket activity reported by the main loop
+static gboolean on_socket_event(GIOChannel *channel, GIOCondition condition, gpointer data) {
+    RequestEngine *engine = data;
+    int action = 0;
+    if (condition & G_IO_IN) action |= CURL_CSELECT_IN;
+    if (condition & G_IO_OUT) action |= CURL_CSELECT_OUT;
+    if (condition & (G_IO_ERR | G_IO_HUP)) action |= CURL_CSELECT_ERR;
+
+    curl_multi_socket_action(engine->multi, g_io_channel_unix_get_fd(channel), action, &engine->running);
+    check_multi_info(engine);
+    return G_SOURCE_CONTINUE;
+}
+
+// CURLMOPT_SOCKETFUNCTION: mirror curl's interest in a socket as a GLib watch
+static int on_socket_update(CURL *easy, curl_socket_t fd, int what, void *userp, void *socketp) {
+    RequestEngine *engine = userp;
+    SocketWatch *watch = socketp;
+
+    if (what == CURL_POLL_REMOVE) {
+        if (watch) {
+            g_source_remove(watch->source_id);
+            g_io_channel_unref(watch->channel);
+            g_free(watch);
+            curl_multi_assign(engine->multi, fd, NULL);
+        }
+        return 0;
+    }
+
+    if (!watch) {
+        watch = g_new0(SocketWatch, 1);
+        watch->channel = g_io_channel_unix_new(fd);
+        curl_multi_assign(engine->multi, fd, watch);
+    } else {
+        g_source_remove(watch->source_id);
+    }
+
+    GIOCondition condition = G_IO_ERR | G_IO_HUP;
+    if (what & CURL_POLL_IN) condition |= G_IO_IN;
+    if (what & CURL_POLL_OUT) condition |= G_IO_OUT;
+    watch->source_id = g_io_add_watch(watch->channel, condition, on_socket_event, engine);
+    return 0;
+}
+
+static gboolean on_timeout(gpointer data) {
+    RequestEngine *engine = data;
+    engine->timer_id = 0;
+    curl_multi_socket_action(engine->multi, CURL_SOCKET_TIMEOUT, 0, &engine->running);
+    check_multi_info(engine);
+    return G_SOURCE_REMOVE;
+}
+
+// CURLMOPT_TIMERFUNCTION: keep a single main-loop timeout in sync with curl
+static int on_timer_update(CURLM *multi, long timeout_ms, void *userp) {
+    RequestEngine *engine = userp;
+    if (engine->timer_id) {
+        g_source_remove(engine->timer_id);
+        engine->timer_id = 0;
+    }
+    if (timeout_ms >= 0)
+        engine->timer_id = g_timeout_add(timeout_ms, on_timeout, engine);
+    return 0;
+}
+
+static void check_multi_info(RequestEngine *engine) {
+    CURLMsg *msg;
+    int pending;
+    while ((msg = curl_multi_info_read(engine->multi, &pending))) {
+        if (msg->msg != CURLMSG_DONE) continue;
+        Request *req = NULL;
+        curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, (char **)&req);
+        request_finish(engine, req, msg->data.result);
+    }
+}
+
+RequestEngine* request_engine_new(void) {
+    RequestEngine *engine = g_new0(RequestEngine, 1);
+    engine->multi = curl_multi_init();
+    if (!engine->multi) {
+        fprintf(stderr, "Error: Failed to initialize CURL multi handle\n");
+        g_free(engine);
+        return NULL;
+    }
+    engine->pool = connection_pool_new();
+    if (!engine->pool) {
+        curl_multi_cleanup(engine->multi);
+        g_free(engine);
+        return NULL;
+    }
+    engine->idle_requests = g_queue_new();
+    engine->waiting = g_queue_new();
+    engine->requests = g_hash_table_new(g_direct_hash, g_direct_equal);
+    engine->next_id = 1;
+
+    connection_pool_setup_multi(engine->pool, engine->multi);
+
+    curl_multi_setopt(engine->multi, CURLMOPT_SOCKETFUNCTION, on_socket_update);
+    curl_multi_setopt(engine->multi, CURLMOPT_SOCKETDATA, engine);
+    curl_multi_setopt(engine->multi, CURLMOPT_TIMERFUNCTION, on_timer_update);
+    curl_multi_setopt(engine->multi, CURLMOPT_TIMERDATA, engine);
+    return engine;
+}
+
+void request_engine_free(RequestEngine *engine) {
+    if (!engine) return;
+    request_engine_cancel_all(engine);
+    if (engine->timer_id) g_source_remove(engine->timer_id);
+    curl_multi_cleanup(engine->multi);
+    g_queue_free_full(engine->idle_requests, request_destroy);
+    connection_pool_free(engine->pool);
+    g_hash_table_destroy(engine->requests);
+    g_queue_free(engine->waiting);
+    g_free(engine);
+}
+
+// Set up a transfer with the options shared by every request kind
+static Request* request_new(RequestEngine *engine, const char *url, const char *const *headers,
+                            RequestDoneFunc done, gpointer user_data) {
+    Request *req = g_queue_pop_head(engine->idle_requests);
+    if (!req) {
+        CURL *easy = curl_easy_init();
+        if (!easy) {
+            fprintf(stderr, "Error: Failed to initialize CURL.\n");
+            return NULL;
+        }
+        req = g_new0(Request, 1);
+        req->easy = easy;
+        response_buffer_init(&req->body, RESPONSE_BUFFER_DEFAULT_LIMIT);
+    }
+    CURL *easy = req->easy;
+    req->id = engine->next_id++;
+    if (engine->next_id == 0) engine->next_id = 1;
+    req->done = done;
+    req->user_data = user_data;
+    req->decoded = 0;
+    for (; headers && *headers; headers++)
+        req->headers = curl_slist_append(req->headers, *headers);
+
+    connection_pool_setup_easy(engine->pool, easy);
+    curl_easy_setopt(easy, CURLOPT_URL, url);
+    curl_easy_setopt(easy, CURLOPT_HTTPHEADER, req->headers);
+    curl_easy_setopt(easy, CURLOPT_WRITEFUNCTION, write_callback);
+    curl_easy_setopt(easy, CURLOPT_WRITEDATA, req);
+    curl_easy_setopt(easy, CURLOPT_PRIVATE, req);
+    curl_easy_setopt(easy, CURLOPT_NOSIGNAL, 1L);
+    // Offer every encoding this libcurl can undo (gzip, deflate, br, zstd);
+    // it decodes as data arrives, so parsers still see plain text in pieces
+    curl_easy_setopt(easy, CURLOPT_ACCEPT_ENCODING, "");
+    return req;
+}
+
+static CURLMcode request_add(RequestEngine *engine, Request *req) {
+    CURLMcode rc = curl_multi_add_handle(engine->multi, req->easy);
+    if (rc != CURLM_OK) {
+        fprintf(stderr, "Error: Could not queue request: %s\n", curl_multi_strerror(rc));
+        return rc;
+    }
+    req->started = TRUE;
+    engine->started++;
+    return rc;
+}
+
+// Hand waiting transfers to the multi handle while there is room, in the
+// order they were made
+static void start_waiting(RequestEngine *engine) {
+    while (engine->started < connection_pool_transfer_limit(engine->pool) && !g_queue_is_empty(engine->waiting)) {
+        Request *req = g_queue_pop_head(engine->waiting);
+        if (request_add(engine, req) != CURLM_OK) request_finish(engine, req, CURLE_FAILED_INIT);
+    }
+}
+
+// Hand a prepared transfer to the multi handle, or queue it while the
+// pool's connections are all busy
+static guint request_start(RequestEngine *engine, Request *req) {
+    g_hash_table_insert(engine->requests, GUINT_TO_POINTER(req->id), req);
+    if (engine->started >= connection_pool_transfer_limit(engine->pool) || !g_queue_is_empty(engine->waiting)) {
+        g_queue_push_tail(engine->waiting, req);
+        return req->id;
+    }
+    if (request_add(engine, req) != CURLM_OK) {
+        g_hash_table_remove(engine->requests, GUINT_TO_POINTER(req->id));
+        request_free(engine, req);
+        return 0;
+    }
+    return req->id;
+}
+
+guint request_engine_post(RequestEngine *engine, const char *url, const char *body,
+                          const char *const *headers, RequestDoneFunc done, gpointer user_data) {
+    Request *req = request_new(engine, url, headers, done, user_data);
+    if (!req) return 0;
+    curl_easy_setopt(req->easy, CURLOPT_COPYPOSTFIELDS, body);
+    return request_start(engine, req);
+}
+
+guint request_engine_post_stream(RequestEngine *engine, const char *url, const char *body,
+                                 const char *const *headers, RequestDataFunc data,
+                                 RequestDoneFunc done, gpointer user_data) {
+    Request *req = request_new(engine, url, headers, done, user_data);
+    if (!req) return 0;
+    req->data = data;
+    curl_easy_setopt(req->easy, CURLOPT_COPYPOSTFIELDS, body);
+    return request_start(engine, req);
+}
+
+guint request_engine_post_bytes(RequestEngine *engine, const char *url, GBytes *body,
+                                const char *const *headers, RequestDataFunc data,
+                                RequestDoneFunc done, gpointer user_data) {
+    Request *req = request_new(engine, url, headers, done, user_data);
+    if (!req) return 0;
+    req->data = data;
+    req->post_body = g_bytes_ref(body);
+    gsize len;
+    const void *bytes = g_bytes_get_data(body, &len);
+    curl_easy_setopt(req->easy, CURLOPT_POSTFIELDSIZE_LARGE, (curl_off_t)len);
+    curl_easy_setopt(req->easy, CURLOPT_POSTFIELDS, bytes);
+    return request_start(engine, req);
+}
+
+guint request_engine_warm(RequestEngine *engine, const char *url, RequestDoneFunc done, gpointer user_data) {
+    Request *req = request_new(engine, url, NULL, done, user_data);
+    if (!req) return 0;
+    curl_easy_setopt(req->easy, CURLOPT_NOBODY, 1L);
+    return request_start(engine, req);
+}
+
+void request_engine_cancel(RequestEngine *engine, guint id) {
+    Request *req = g_hash_table_lookup(engine->requests, GUINT_TO_POINTER(id));
+    if (req)
+        request_finish(engine, req, CURLE_ABORTED_BY_CALLBACK);
+}
+
+void request_engine_cancel_all(RequestEngine *engine) {
+    // Waiting requests first, so cancelling the others does not start them
+    GList *ids = NULL;
+    GHashTableIter iter;
+    gpointer id, req;
+    g_hash_table_iter_init(&iter, engine->requests);
+    while (g_hash_table_iter_next(&iter, &id, &req))
+        if (((Request *)req)->started) ids = g_list_prepend(ids, id);
+    for (GList *l = engine->waiting->tail; l; l = l->prev)
+        ids = g_list_prepend(ids, GUINT_TO_POINTER(((Request *)l->data)->id));
+    for (GList *l = ids; l; l = l->next)
+        request_engine_cancel(engine, GPOINTER_TO_UINT(l->data));
+    g_list_free(ids);
+}
+
+gboolean request_engine_timings(RequestEngine *engine, guint id, RequestTimings *timings) {
+    Request *req = engine->finishing && engine->finishing->id == id
+        ? engine->finishing : g_hash_table_lookup(engine->requests, GUINT_TO_POINTER(id));
+    if (!req) return FALSE;
+    curl_off_t dns = 0, connect = 0, tls = 0, pretransfer = 0, first_byte = 0, total = 0, up = 0, down = 0;
+    long request_size = 0, header_size = 0, version = 0, connects = 0;
+    curl_easy_getinfo(req->easy, CURLINFO_NAMELOOKUP_TIME_T, &dns);
+    curl_easy_getinfo(req->easy, CURLINFO_CONNECT_TIME_T, &connect);
+    curl_easy_getinfo(req->easy, CURLINFO_APPCONNECT_TIME_T, &tls);
+    curl_easy_getinfo(req->easy, CURLINFO_PRETRANSFER_TIME_T, &pretransfer);
+    curl_easy_getinfo(req->easy, CURLINFO_STARTTRANSFER_TIME_T, &first_byte);
+    curl_easy_getinfo(req->easy, CURLINFO_TOTAL_TIME_T, &total);
+    curl_easy_getinfo(req->easy, CURLINFO_SIZE_UPLOAD_T, &up);
+    curl_easy_getinfo(req->easy, CURLINFO_SIZE_DOWNLOAD_T, &down);
+    curl_easy_getinfo(req->easy, CURLINFO_REQUEST_SIZE, &request_size);
+    curl_easy_getinfo(req->easy, CURLINFO_HEADER_SIZE, &header_size);
+    curl_easy_getinfo(req->easy, CURLINFO_HTTP_VERSION, &version);
+    curl_easy_getinfo(req->easy, CURLINFO_NUM_CONNECTS, &connects);
+    timings->dns = dns;
+    timings->connect = connect;
+    timings->tls = tls;
+    timings->pretransfer = pretransfer;
+    timings->first_byte = first_byte;
+    timings->total = total;
+    // Bodies small enough to go out with the headers are in request_size too
+    timings->bytes_up = request_size >= up ? request_size : request_size + up;
+    timings->bytes_down = header_size + down;
+    timings->body_wire = down;
+    timings->body_decoded = req->decoded;
+    struct curl_header *encoding = NULL;
+    timings->encoding[0] = '\0';
+    if (curl_easy_header(req->easy, "Content-Encoding", 0, CURLH_HEADER, -1, &encoding) == CURLHE_OK)
+        g_strlcpy(timings->encoding, encoding->value, sizeof(timings->encoding));
+    timings->http_version = version == CURL_HTTP_VERSION_3 ? 3 : version == CURL_HTTP_VERSION_2_0 ? 2 :
+                            version ? 1 : 0;
+    timings->reused = connects == 0;
+    return TRUE;
+}
+
+guint request_engine_in_flight(RequestEngine *engine) {
+    return g_hash_table_size(engine->requests);
+}
+
+ConnectionStats request_engine_connection_stats(RequestEngine *engine) {
+    return connection_pool_stats(engine->pool);
+}
@@ -0,0 +1,75 @@
+// request_engine.h
+#ifndef REQUEST_ENGINE_H
+#define REQUEST_ENGINE_H
+
+#include <glib.h>
+#include <curl/curl.h>
+#include "connection_pool.h"
+
+// Asynchronous HTTP engine: curl multi handle driven by the GLib main loop.
+typedef struct RequestEngine RequestEngine;
+
+// Called on the main loop when a request finishes or is cancelled.
+// result is CURLE_ABORTED_BY_CALLBACK for cancelled requests.
+typedef void (*RequestDoneFunc)(guint id, CURLcode result, long http_status,
+                                const char *body, size_t body_len, gpointer user_data);
+
+// Called on the main loop for each piece of a streamed response body, as it
+// arrives. Must not cancel requests or free the engine.
+typedef void (*RequestDataFunc)(guint id, const char *data, size_t len, gpointer user_data);
+
+RequestEngine* request_engine_new(void);
+void request_engine_free(RequestEngine *engine);
+
+// Queue a POST request; returns an id (never 0) usable with request_engine_cancel.
+guint request_engine_post(RequestEngine *engine, const char *url, const char *body,
+                          const char *const *headers, RequestDoneFunc done, gpointer user_data);
+
+// Like request_engine_post, but hand the body to data chunk by chunk;
+// done then receives an empty body.
+guint request_engine_post_stream(RequestEngine *engine, const char *url, const char *body,
+                                 const char *const *headers, RequestDataFunc data,
+                                 RequestDoneFunc done, gpointer user_data);
+
+// Like request_engine_post_stream (data may be NULL to collect the body),
+// but the request body is sent from body itself, which the request holds a
+// reference to until it finishes: no copy, and one body can serve many requests
+guint request_engine_post_bytes(RequestEngine *engine, const char *url, GBytes *body,
+                                const char *const *headers, RequestDataFunc data,
+                                RequestDoneFunc done, gpointer user_data);
+
+// Open (or keep open) a connection to url's host in the background so the
+// next request skips DNS, TCP and TLS setup. Returns a request id; done
+// (may be NULL) is called once the connection is up or has failed.
+guint request_engine_warm(RequestEngine *engine, const char *url, RequestDoneFunc done, gpointer user_data);
+
+// Cancel a request in flight; done is called before this returns.
+// Unknown or already finished ids are ignored.
+void request_engine_cancel(RequestEngine *engine, guint id);
+void request_engine_cancel_all(RequestEngine *engine);
+
+// Microseconds from the start of a transfer to each milestone (0 when the
+// step was skipped, e.g. on a reused connection), and what went over the wire
+typedef struct {
+    gint64 dns;           // name resolved
+    gint64 connect;       // TCP connected
+    gint64 tls;           // TLS handshake done
+    gint64 pretransfer;   // about to send the request
+    gint64 first_byte;    // first response byte received
+    gint64 total;
+    gint64 bytes_up;      // request headers and body
+    gint64 bytes_down;    // response headers and body
+    gint64 body_wire;     // response body as received, still compressed if it was
+    gint64 body_decoded;  // response body as handed to the caller
+    char encoding[16];    // Content-Encoding of the response, "" if none
+    int http_version;     // 1, 2 or 3; 0 before a response
+    gboolean reused;      // no new connection was opened
+} RequestTimings;
+
+// Timings of a request in flight, or of the one whose done callback is running
+gboolean request_engine_timings(RequestEngine *engine, guint id, RequestTimings *timings);
+
+guint request_engine_in_flight(RequestEngine *engine);
+ConnectionStats request_engine_connection_stats(RequestEngine *engine);
+
+#endif
@@ -0,0 +1,66 @@
+#include <stdlib.h>
+#include <string.h>
+#include "response_buffer.h"
+
+#define INITIAL_CAPACITY 4096
+
+void response_buffer_init(ResponseBuffer *buf, size_t limit) {
+    memset(buf, 0, sizeof(*buf));
+    buf->limit = limit ? limit : RESPONSE_BUFFER_DEFAULT_LIMIT;
+}
+
+void response_buffer_free(ResponseBuffer *buf) {
+    free(buf->data);
+    buf->data = NULL;
+    buf->len = buf->cap = 0;
+    buf->truncated = 0;
+}
+
+void response_buffer_reset(ResponseBuffer *buf) {
+    buf->len = 0;
+    buf->truncated = 0;
+    if (buf->data) buf->data[0] = '\0';
+}
+
+// Make room for len + need bytes plus the terminator, doubling the capacity
+static int reserve(ResponseBuffer *buf, size_t need) {
+    size_t want = buf->len + need + 1;
+    if (want <= buf->cap) return 1;
+    size_t new_cap = buf->cap ? buf->cap : INITIAL_CAPACITY;
+    while (new_cap < want) new_cap *= 2;
+    if (new_cap > buf->limit + 1) new_cap = buf->limit + 1;
+    char *grown = realloc(buf->data, new_cap);
+    if (!grown) return 0;
+    buf->data = grown;
+    buf->cap = new_cap;
+    return 1;
+}
+
+int response_buffer_append(ResponseBuffer *buf, const void *data, size_t len) {
+    size_t room = buf->limit - buf->len;
+    size_t take = len < room ? len : room;
+    if (!reserve(buf, take)) {
+        buf->truncated = 1;
+        return 0;
+    }
+    memcpy(buf->data + buf->len, data, take);
+    buf->len += take;
+    buf->data[buf->len] = '\0';
+    if (take < len) {
+        buf->truncated = 1;
+        return 0;
+    }
+    return 1;
+}
+
+const char* response_buffer_str(const ResponseBuffer *buf) {
+    return buf->data ? buf->data : "";
+}
+
+// Write Callback for CURL
+size_t response_buffer_write_callback(char *contents, size_t size, size_t nmemb, void *userp) {
+    size_t total_size = size * nmemb;
+    if (!response_buffer_append(userp, contents, total_size))
+        return 0;
+    return total_size;
+}
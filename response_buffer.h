@@ -0,0 +1,35 @@
+// response_buffer.h
+#ifndef RESPONSE_BUFFER_H
+#define RESPONSE_BUFFER_H
+
+#include <stddef.h>
+
+#define RESPONSE_BUFFER_DEFAULT_LIMIT (4u * 1024 * 1024)
+
+// Growable response body: amortized O(1) appends, a hard size cap, and
+// storage that is kept across requests by response_buffer_reset.
+typedef struct {
+    char *data;        // always NUL-terminated once anything was appended
+    size_t len;
+    size_t cap;
+    size_t limit;      // largest body accepted, in bytes
+    int truncated;     // set when an append hit the limit
+} ResponseBuffer;
+
+void response_buffer_init(ResponseBuffer *buf, size_t limit);
+void response_buffer_free(ResponseBuffer *buf);
+
+// Forget the contents but keep the allocation for the next request
+void response_buffer_reset(ResponseBuffer *buf);
+
+// Returns 0 (keeping what fits) when the limit or memory runs out
+int response_buffer_append(ResponseBuffer *buf, const void *data, size_t len);
+
+// Contents as a C string ("" when empty)
+const char* response_buffer_str(const ResponseBuffer *buf);
+
+// CURLOPT_WRITEFUNCTION with a ResponseBuffer* as CURLOPT_WRITEDATA; aborts
+// the transfer (CURLE_WRITE_ERROR) when the body exceeds the limit.
+size_t response_buffer_write_callback(char *contents, size_t size, size_t nmemb, void *userp);
+
+#endif
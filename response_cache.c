@@ -0,0 +1,321 @@
+#include <string.h>
+#include <glib/gstdio.h>
+#include "response_cache.h"
+
+// On-disk entry: one file per key, a small header followed by the body
+#define CACHE_FILE_MAGIC "SMCACHE1"
+
+typedef struct {
+    char magic[8];
+    gint64 stored;      // unix seconds
+    guint64 len;
+} CacheFileHeader;
+
+typedef struct {
+    char *key;
+    GBytes *data;        // NULL while the body is only on disk
+    gsize size;
+    gint64 stored;       // unix seconds, -1 until read from disk
+    GList *memory_link;  // in memory_lru while data is loaded
+    GList *disk_link;    // in disk_lru while a file exists
+} CacheEntry;
+
+struct ResponseCache {
+    GHashTable *entries;     // key -> CacheEntry
+    GQueue memory_lru;       // most recently used first
+    GQueue disk_lru;
+    char *dir;
+    gsize memory_budget;
+    gsize disk_budget;
+    gsize memory_bytes;
+    gsize disk_bytes;
+    gint64 ttl;
+    gulong hits;
+    gulong misses;
+    guint64 bytes_saved;
+};
+
+static gint64 now_seconds(void) {
+    return g_get_real_time() / G_USEC_PER_SEC;
+}
+
+static char* entry_path(const ResponseCache *cache, const char *key) {
+    return g_build_filename(cache->dir, key, NULL);
+}
+
+static void touch(GQueue *lru, GList *link) {
+    if (lru->head == link) return;
+    g_queue_unlink(lru, link);
+    g_queue_push_head_link(lru, link);
+}
+
+static void drop_memory(ResponseCache *cache, CacheEntry *entry) {
+    if (!entry->memory_link) return;
+    g_queue_delete_link(&cache->memory_lru, entry->memory_link);
+    entry->memory_link = NULL;
+    g_bytes_unref(entry->data);
+    entry->data = NULL;
+    cache->memory_bytes -= entry->size;
+}
+
+static void drop_disk(ResponseCache *cache, CacheEntry *entry) {
+    if (!entry->disk_link) return;
+    g_queue_delete_link(&cache->disk_lru, entry->disk_link);
+    entry->disk_link = NULL;
+    char *path = entry_path(cache, entry->key);
+    g_unlink(path);
+    g_free(path);
+    cache->disk_bytes -= entry->size + sizeof(CacheFileHeader);
+}
+
+// Forget an entry that is neither in memory nor on disk any more
+static void forget_if_empty(ResponseCache *cache, CacheEntry *entry) {
+    if (!entry->memory_link && !entry->disk_link)
+        g_hash_table_remove(cache->entries, entry->key);
+}
+
+static void entry_free(gpointer data) {
+    CacheEntry *entry = data;
+    if (entry->data) g_bytes_unref(entry->data);
+    g_free(entry->key);
+    g_free(entry);
+}
+
+// Evict least recently used entries until each tier fits its budget
+static void enforce_budgets(ResponseCache *cache) {
+    while (cache->memory_bytes > cache->memory_budget && cache->memory_lru.tail) {
+        CacheEntry *entry = cache->memory_lru.tail->data;
+        drop_memory(cache, entry);
+        forget_if_empty(cache, entry);
+    }
+    while (cache->disk_bytes > cache->disk_budget && cache->disk_lru.tail) {
+        CacheEntry *entry = cache->disk_lru.tail->data;
+        drop_disk(cache, entry);
+        forget_if_empty(cache, entry);
+    }
+}
+
+static void keep_in_memory(ResponseCache *cache, CacheEntry *entry, GBytes *data) {
+    if (entry->size > cache->memory_budget) return;
+    entry->data = g_bytes_ref(data);
+    g_queue_push_head(&cache->memory_lru, entry);
+    entry->memory_link = cache->memory_lru.head;
+    cache->memory_bytes += entry->size;
+}
+
+static CacheEntry* entry_new(ResponseCache *cache, const char *key, gsize size, gint64 stored) {
+    CacheEntry *entry = g_new0(CacheEntry, 1);
+    entry->key = g_strdup(key);
+    entry->size = size;
+    entry->stored = stored;
+    g_hash_table_insert(cache->entries, entry->key, entry);
+    return entry;
+}
+
+typedef struct {
+    CacheEntry *entry;
+    gint64 used;         // file mtime: last store or hit
+} FoundFile;
+
+static gint compare_found(gconstpointer a, gconstpointer b) {
+    gint64 x = ((const FoundFile *)a)->used, y = ((const FoundFile *)b)->used;
+    return x < y ? -1 : x > y;
+}
+
+// Index the files left by earlier runs (headers are read lazily on first use)
+static void scan_dir(ResponseCache *cache) {
+    GDir *dir = g_dir_open(cache->dir, 0, NULL);
+    if (!dir) return;
+
+    GArray *found = g_array_new(FALSE, FALSE, sizeof(FoundFile));
+    const char *name;
+    while ((name = g_dir_read_name(dir))) {
+        if (strlen(name) != RESPONSE_CACHE_KEY_SIZE - 1) continue;
+        char *path = entry_path(cache, name);
+        GStatBuf st;
+        if (g_stat(path, &st) == 0 && (gsize)st.st_size >= sizeof(CacheFileHeader)) {
+            FoundFile file = { entry_new(cache, name, st.st_size - sizeof(CacheFileHeader), -1), st.st_mtime };
+            g_array_append_val(found, file);
+        }
+        g_free(path);
+    }
+    g_dir_close(dir);
+
+    // Oldest first, so the most recently used file ends up at the head
+    g_array_sort(found, compare_found);
+    for (guint i = 0; i < found->len; i++) {
+        CacheEntry *entry = g_array_index(found, FoundFile, i).entry;
+        g_queue_push_head(&cache->disk_lru, entry);
+        entry->disk_link = cache->disk_lru.head;
+        cache->disk_bytes += entry->size + sizeof(CacheFileHeader);
+    }
+    g_array_free(found, TRUE);
+    enforce_budgets(cache);
+}
+
+ResponseCache* response_cache_new(const char *dir, gsize memory_budget, gsize disk_budget, gint64 ttl_seconds) {
+    ResponseCache *cache = g_new0(ResponseCache, 1);
+    cache->entries = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, entry_free);
+    g_queue_init(&cache->memory_lru);
+    g_queue_init(&cache->disk_lru);
+    cache->memory_budget = memory_budget;
+    cache->disk_budget = disk_budget;
+    cache->ttl = ttl_seconds;
+    if (dir && g_mkdir_with_parents(dir, 0700) == 0) {
+        cache->dir = g_strdup(dir);
+        scan_dir(cache);
+    }
+    return cache;
+}
+
+void response_cache_free(ResponseCache *cache) {
+    if (!cache) return;
+    g_queue_clear(&cache->memory_lru);
+    g_queue_clear(&cache->disk_lru);
+    g_hash_table_destroy(cache->entries);
+    g_free(cache->dir);
+    g_free(cache);
+}
+
+void response_cache_key(const char *model, const char *endpoint, const char *body,
+                        char key[RESPONSE_CACHE_KEY_SIZE]) {
+    GChecksum *sum = g_checksum_new(G_CHECKSUM_SHA256);
+    // NUL separators keep ("ab", "c") and ("a", "bc") apart
+    g_checksum_update(sum, (const guchar *)model, strlen(model) + 1);
+    g_checksum_update(sum, (const guchar *)endpoint, strlen(endpoint) + 1);
+    g_checksum_update(sum, (const guchar *)body, strlen(body));
+    g_strlcpy(key, g_checksum_get_string(sum), RESPONSE_CACHE_KEY_SIZE);
+    g_checksum_free(sum);
+}
+
+// Read an entry's file; NULL (and the file removed) when it is damaged
+static GBytes* load_from_disk(ResponseCache *cache, CacheEntry *entry) {
+    char *path = entry_path(cache, entry->key);
+    char *contents = NULL;
+    gsize len = 0;
+    GBytes *data = NULL;
+    if (g_file_get_contents(path, &contents, &len, NULL) && len >= sizeof(CacheFileHeader)) {
+        CacheFileHeader header;
+        memcpy(&header, contents, sizeof(header));
+        if (memcmp(header.magic, CACHE_FILE_MAGIC, sizeof(header.magic)) == 0 &&
+            header.len == len - sizeof(header) && header.len == entry->size) {
+            entry->stored = header.stored;
+            GBytes *file = g_bytes_new_take(contents, len);
+            contents = NULL;
+            data = g_bytes_new_from_bytes(file, sizeof(header), header.len);
+            g_bytes_unref(file);
+            g_utime(path, NULL);   // record the use for LRU order across runs
+        }
+    }
+    g_free(contents);
+    g_free(path);
+    if (!data) drop_disk(cache, entry);
+    return data;
+}
+
+static int expired(const ResponseCache *cache, const CacheEntry *entry) {
+    return cache->ttl > 0 && entry->stored >= 0 && now_seconds() - entry->stored > cache->ttl;
+}
+
+GBytes* response_cache_lookup(ResponseCache *cache, const char *key, ResponseCachePolicy policy) {
+    if (policy != RESPONSE_CACHE_NORMAL) return NULL;
+
+    CacheEntry *entry = g_hash_table_lookup(cache->entries, key);
+    GBytes *data = NULL;
+    if (entry && !expired(cache, entry)) {
+        if (entry->data) {
+            data = g_bytes_ref(entry->data);
+            touch(&cache->memory_lru, entry->memory_link);
+            if (entry->disk_link) touch(&cache->disk_lru, entry->disk_link);
+        } else if (entry->disk_link && (data = load_from_disk(cache, entry))) {
+            touch(&cache->disk_lru, entry->disk_link);
+            if (expired(cache, entry)) {
+                g_bytes_unref(data);
+                data = NULL;
+            } else {
+                keep_in_memory(cache, entry, data);
+                enforce_budgets(cache);
+            }
+        }
+    }
+    if (entry && !data) {
+        // Expired or unreadable: make room for the fresh response
+        response_cache_remove(cache, key);
+    }
+
+    if (data) {
+        cache->hits++;
+        cache->bytes_saved += g_bytes_get_size(data);
+    } else {
+        cache->misses++;
+    }
+    return data;
+}
+
+static void save_to_disk(ResponseCache *cache, CacheEntry *entry, const char *data, gsize len) {
+    if (!cache->dir || len + sizeof(CacheFileHeader) > cache->disk_budget) return;
+
+    CacheFileHeader header;
+    memcpy(header.magic, CACHE_FILE_MAGIC, sizeof(header.magic));
+    header.stored = entry->stored;
+    header.len = len;
+    char *contents = g_malloc(sizeof(header) + len);
+    memcpy(contents, &header, sizeof(header));
+    memcpy(contents + sizeof(header), data, len);
+
+    // g_file_set_contents writes a temporary file and renames it into place
+    char *path = entry_path(cache, entry->key);
+    if (g_file_set_contents(path, contents, sizeof(header) + len, NULL)) {
+        g_queue_push_head(&cache->disk_lru, entry);
+        entry->disk_link = cache->disk_lru.head;
+        cache->disk_bytes += len + sizeof(header);
+    }
+    g_free(path);
+    g_free(contents);
+}
+
+void response_cache_store(ResponseCache *cache, const char *key, const char *data, gsize len,
+                          ResponseCachePolicy policy) {
+    if (policy == RESPONSE_CACHE_BYPASS) return;
+    response_cache_remove(cache, key);
+
+    CacheEntry *entry = entry_new(cache, key, len, now_seconds());
+    GBytes *bytes = g_bytes_new(data, len);
+    keep_in_memory(cache, entry, bytes);
+    g_bytes_unref(bytes);
+    save_to_disk(cache, entry, data, len);
+    forget_if_empty(cache, entry);
+    enforce_budgets(cache);
+}
+
+void response_cache_remove(ResponseCache *cache, const char *key) {
+    CacheEntry *entry = g_hash_table_lookup(cache->entries, key);
+    if (!entry) return;
+    drop_memory(cache, entry);
+    drop_disk(cache, entry);
+    g_hash_table_remove(cache->entries, key);
+}
+
+void response_cache_clear(ResponseCache *cache) {
+    while (cache->disk_lru.head) {
+        CacheEntry *entry = cache->disk_lru.head->data;
+        drop_disk(cache, entry);
+        forget_if_empty(cache, entry);
+    }
+    while (cache->memory_lru.head) {
+        CacheEntry *entry = cache->memory_lru.head->data;
+        drop_memory(cache, entry);
+        forget_if_empty(cache, entry);
+    }
+}
+
+ResponseCacheStats response_cache_stats(const ResponseCache *cache) {
+    ResponseCacheStats stats;
+    stats.hits = cache->hits;
+    stats.misses = cache->misses;
+    stats.bytes_saved = cache->bytes_saved;
+    stats.entries = g_hash_table_size(cache->entries);
+    stats.memory_bytes = cache->memory_bytes;
+    stats.disk_bytes = cache->disk_bytes;
+    return stats;
+}
@@ -0,0 +1,54 @@
+// response_cache.h
+#ifndef RESPONSE_CACHE_H
+#define RESPONSE_CACHE_H
+
+#include <glib.h>
+
+// Content-addressed cache of response bodies: an in-memory LRU in front of
+// an optional on-disk store, each with its own size budget.
+typedef struct ResponseCache ResponseCache;
+
+#define RESPONSE_CACHE_KEY_SIZE 65                        // SHA-256 in hex, NUL-terminated
+#define RESPONSE_CACHE_DEFAULT_MEMORY (4u * 1024 * 1024)
+#define RESPONSE_CACHE_DEFAULT_DISK (64u * 1024 * 1024)
+#define RESPONSE_CACHE_DEFAULT_TTL (7 * 24 * 3600)        // seconds
+
+typedef enum {
+    RESPONSE_CACHE_NORMAL,     // serve from the cache, store fresh responses
+    RESPONSE_CACHE_REFRESH,    // skip the lookup but store the fresh response
+    RESPONSE_CACHE_BYPASS      // neither look up nor store
+} ResponseCachePolicy;
+
+typedef struct {
+    gulong hits;
+    gulong misses;           // lookups that had to go to the network (bypasses not counted)
+    guint64 bytes_saved;     // response bytes served from the cache
+    guint entries;           // in memory or on disk
+    gsize memory_bytes;
+    gsize disk_bytes;
+} ResponseCacheStats;
+
+// dir is created if needed; NULL keeps the cache in memory only.
+// ttl_seconds <= 0 means entries never expire.
+ResponseCache* response_cache_new(const char *dir, gsize memory_budget, gsize disk_budget, gint64 ttl_seconds);
+void response_cache_free(ResponseCache *cache);
+
+// Key for a request: hash of model, endpoint and request body (not the API key)
+void response_cache_key(const char *model, const char *endpoint, const char *body,
+                        char key[RESPONSE_CACHE_KEY_SIZE]);
+
+// Cached body for key (a new reference), or NULL on a miss, after expiry or
+// when policy skips lookups
+GBytes* response_cache_lookup(ResponseCache *cache, const char *key, ResponseCachePolicy policy);
+
+// Remember a successful response body for key (ignored for RESPONSE_CACHE_BYPASS)
+void response_cache_store(ResponseCache *cache, const char *key, const char *data, gsize len,
+                          ResponseCachePolicy policy);
+
+// Drop one entry, or every entry, from memory and disk
+void response_cache_remove(ResponseCache *cache, const char *key);
+void response_cache_clear(ResponseCache *cache);
+
+ResponseCacheStats response_cache_stats(const ResponseCache *cache);
+
+#endif
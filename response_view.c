@@ -0,0 +1,296 @@
+#include <string.h>
+#include "response_view.h"
+#include "markdown.h"
+
+#define TRIM_SLACK 1000              // lines over the limit before trimming
+#define MAX_BATCH_BYTES (64 * 1024)  // a batch is handed over at least this often
+
+// Styles beyond MarkdownStyle's bits, for text the view adds itself
+enum {
+    STYLE_NOTE_APP = 1 << 8,
+    STYLE_NOTE_USER = 1 << 9,
+    STYLE_NOTE_ERROR = 1 << 10,
+    STYLE_SEPARATOR = 1 << 11,
+    STYLE_BITS = 12
+};
+
+typedef enum { JOB_BEGIN, JOB_MARKDOWN, JOB_END, JOB_NOTE, JOB_QUIT } JobKind;
+
+// Work for the worker, in order
+typedef struct {
+    JobKind kind;
+    ResponseNote note;
+    size_t len;
+    char text[];
+} Job;
+
+// Styled text ready to insert: spans index into text
+typedef struct {
+    guint offset;
+    guint len;
+    guint style;
+} Span;
+
+typedef struct {
+    GString *text;
+    GArray *spans;
+} Batch;
+
+struct ResponseView {
+    GtkWidget *scrolled;
+    GtkWidget *text_view;
+    GtkTextBuffer *buffer;
+    GtkTextMark *end;             // right gravity: always the end, for scrolling
+    GtkTextMark *insert_start;    // left gravity: start of the text just inserted
+    GtkTextTag *tags[STYLE_BITS]; // by style bit
+    ResponseViewStats stats;
+
+    GThread *worker;
+    GAsyncQueue *jobs;
+
+    GMutex lock;                  // guards ready and idle_id
+    GPtrArray *ready;             // Batch*, oldest first
+    guint idle_id;
+
+    // Worker only
+    MarkdownParser parser;
+    Batch *batch;
+    gboolean at_line_start;
+    gboolean empty;
+};
+
+static Batch* batch_new(void) {
+    Batch *batch = g_new(Batch, 1);
+    batch->text = g_string_sized_new(1024);
+    batch->spans = g_array_new(FALSE, FALSE, sizeof(Span));
+    return batch;
+}
+
+static void batch_free(gpointer data) {
+    Batch *batch = data;
+    g_string_free(batch->text, TRUE);
+    g_array_free(batch->spans, TRUE);
+    g_free(batch);
+}
+
+// Main loop: insert every batch the worker has finished
+static gboolean apply_batches(gpointer data) {
+    ResponseView *view = data;
+    g_mutex_lock(&view->lock);
+    GPtrArray *ready = view->ready;
+    view->ready = g_ptr_array_new_with_free_func(batch_free);
+    view->idle_id = 0;
+    g_mutex_unlock(&view->lock);
+
+    gint64 start = g_get_monotonic_time();
+    GtkAdjustment *adjustment = gtk_scrolled_window_get_vadjustment(GTK_SCROLLED_WINDOW(view->scrolled));
+    gboolean at_bottom = gtk_adjustment_get_value(adjustment) + gtk_adjustment_get_page_size(adjustment) >=
+                         gtk_adjustment_get_upper(adjustment) - 1;
+    GtkTextIter end, from;
+    for (guint i = 0; i < ready->len; i++) {
+        Batch *batch = g_ptr_array_index(ready, i);
+        for (guint k = 0; k < batch->spans->len; k++) {
+            const Span *span = &g_array_index(batch->spans, Span, k);
+            gtk_text_buffer_get_end_iter(view->buffer, &end);   // tagging invalidates iterators
+            gtk_text_buffer_move_mark(view->buffer, view->insert_start, &end);
+            gtk_text_buffer_insert(view->buffer, &end, batch->text->str + span->offset, span->len);
+            if (!span->style) continue;
+            gtk_text_buffer_get_iter_at_mark(view->buffer, &from, view->insert_start);
+            for (int bit = 0; bit < STYLE_BITS; bit++)
+                if ((span->style & (1u << bit)) && view->tags[bit])
+                    gtk_text_buffer_apply_tag(view->buffer, view->tags[bit], &from, &end);
+        }
+        view->stats.bytes += batch->text->len;
+    }
+    g_ptr_array_free(ready, TRUE);
+
+    // Drop the oldest lines a block at a time, not a line per insertion
+    int lines = gtk_text_buffer_get_line_count(view->buffer);
+    if (lines > RESPONSE_VIEW_MAX_LINES + TRIM_SLACK) {
+        GtkTextIter first, cut;
+        gtk_text_buffer_get_start_iter(view->buffer, &first);
+        gtk_text_buffer_get_iter_at_line(view->buffer, &cut, lines - RESPONSE_VIEW_MAX_LINES);
+        gtk_text_buffer_delete(view->buffer, &first, &cut);
+        lines = gtk_text_buffer_get_line_count(view->buffer);
+    }
+    // Follow the end only if the reader is there; scrolling to a mark lays
+    // out just the lines around it
+    if (at_bottom) gtk_text_view_scroll_mark_onscreen(GTK_TEXT_VIEW(view->text_view), view->end);
+
+    gint64 took = g_get_monotonic_time() - start;
+    view->stats.batches++;
+    view->stats.total_apply_us += took;
+    if (took > view->stats.worst_apply_us) view->stats.worst_apply_us = took;
+    view->stats.lines = lines;
+    return G_SOURCE_REMOVE;
+}
+
+// Worker: hand the batch so far to the main loop
+static void publish(ResponseView *view) {
+    if (view->batch->text->len == 0) return;
+    g_mutex_lock(&view->lock);
+    g_ptr_array_add(view->ready, view->batch);
+    if (!view->idle_id) view->idle_id = g_idle_add_full(G_PRIORITY_DEFAULT, apply_batches, view, NULL);
+    g_mutex_unlock(&view->lock);
+    view->batch = batch_new();
+}
+
+static void add(ResponseView *view, const char *text, size_t len, guint style) {
+    if (len == 0) return;
+    Batch *batch = view->batch;
+    Span *last = batch->spans->len ? &g_array_index(batch->spans, Span, batch->spans->len - 1) : NULL;
+    if (last && last->style == style) {
+        last->len += len;
+    } else {
+        Span span = { (guint)batch->text->len, (guint)len, style };
+        g_array_append_val(batch->spans, span);
+    }
+    g_string_append_len(batch->text, text, len);
+    view->at_line_start = text[len - 1] == '\n';
+    view->empty = FALSE;
+}
+
+static void on_span(const char *text, size_t len, unsigned style, void *data) {
+    add(data, text, len, style);
+}
+
+static void new_line(ResponseView *view) {
+    if (!view->at_line_start) add(view, "\n", 1, 0);
+}
+
+static void run_job(ResponseView *view, const Job *job) {
+    static const guint note_styles[] = { STYLE_NOTE_APP, STYLE_NOTE_USER, STYLE_NOTE_ERROR };
+    switch (job->kind) {
+    case JOB_BEGIN:
+        markdown_finish(&view->parser);
+        if (view->empty) break;
+        new_line(view);
+        add(view, "\n", 1, STYLE_SEPARATOR);
+        break;
+    case JOB_MARKDOWN:
+        markdown_feed(&view->parser, job->text, job->len);
+        break;
+    case JOB_END:
+        markdown_finish(&view->parser);
+        break;
+    case JOB_NOTE:
+        markdown_finish(&view->parser);
+        new_line(view);
+        add(view, job->text, job->len, note_styles[job->note]);
+        new_line(view);
+        break;
+    case JOB_QUIT:
+        break;
+    }
+}
+
+static gpointer worker_main(gpointer data) {
+    ResponseView *view = data;
+    for (;;) {
+        Job *job = g_async_queue_pop(view->jobs);
+        JobKind kind = job->kind;
+        run_job(view, job);
+        g_free(job);
+        if (kind == JOB_QUIT) break;
+        // Whatever piled up meanwhile goes in the same batch
+        if (g_async_queue_length(view->jobs) <= 0 || view->batch->text->len >= MAX_BATCH_BYTES) publish(view);
+    }
+    return NULL;
+}
+
+static void push_job(ResponseView *view, JobKind kind, ResponseNote note, const char *text, size_t len) {
+    Job *job = g_malloc(sizeof(Job) + len);
+    job->kind = kind;
+    job->note = note;
+    job->len = len;
+    if (len) memcpy(job->text, text, len);
+    g_async_queue_push(view->jobs, job);
+}
+
+static void create_tags(ResponseView *view) {
+    GtkTextBuffer *b = view->buffer;
+    GtkTextTag **t = view->tags;
+    t[0] = gtk_text_buffer_create_tag(b, "bold", "weight", PANGO_WEIGHT_BOLD, NULL);
+    t[1] = gtk_text_buffer_create_tag(b, "italic", "style", PANGO_STYLE_ITALIC, NULL);
+    t[2] = gtk_text_buffer_create_tag(b, "code", "family", "monospace", "background", "#f0f0f0", NULL);
+    t[3] = gtk_text_buffer_create_tag(b, "math", "foreground", "#1a5fb4", NULL);
+    t[4] = gtk_text_buffer_create_tag(b, "heading", "weight", PANGO_WEIGHT_BOLD, "scale", PANGO_SCALE_LARGE,
+                                      "pixels-above-lines", 6, NULL);
+    t[5] = gtk_text_buffer_create_tag(b, "superscript", "rise", 4 * PANGO_SCALE, "scale", PANGO_SCALE_SMALL, NULL);
+    t[6] = gtk_text_buffer_create_tag(b, "bullet", "foreground", "#77767b", NULL);
+    t[8] = gtk_text_buffer_create_tag(b, "note-app", NULL);
+    t[9] = gtk_text_buffer_create_tag(b, "note-user", "foreground", "#26a269", "weight", PANGO_WEIGHT_BOLD, NULL);
+    t[10] = gtk_text_buffer_create_tag(b, "note-error", "foreground", "#c01c28", NULL);
+    t[11] = gtk_text_buffer_create_tag(b, "separator", "pixels-above-lines", 4, "pixels-below-lines", 4,
+                                       "paragraph-background", "#deddda", "scale", 0.25, NULL);
+}
+
+ResponseView* response_view_new(void) {
+    ResponseView *view = g_new0(ResponseView, 1);
+    view->buffer = gtk_text_buffer_new(NULL);
+    view->text_view = gtk_text_view_new_with_buffer(view->buffer);
+    g_object_unref(view->buffer);   // the view holds it
+    gtk_text_view_set_wrap_mode(GTK_TEXT_VIEW(view->text_view), GTK_WRAP_WORD_CHAR);
+    gtk_text_view_set_editable(GTK_TEXT_VIEW(view->text_view), FALSE);
+    gtk_text_view_set_cursor_visible(GTK_TEXT_VIEW(view->text_view), FALSE);
+    gtk_text_view_set_left_margin(GTK_TEXT_VIEW(view->text_view), 6);
+    gtk_text_view_set_right_margin(GTK_TEXT_VIEW(view->text_view), 6);
+    create_tags(view);
+    GtkTextIter end;
+    gtk_text_buffer_get_end_iter(view->buffer, &end);
+    view->end = gtk_text_buffer_create_mark(view->buffer, NULL, &end, FALSE);
+    view->insert_start = gtk_text_buffer_create_mark(view->buffer, NULL, &end, TRUE);
+
+    view->scrolled = gtk_scrolled_window_new(NULL, NULL);
+    gtk_scrolled_window_set_policy(GTK_SCROLLED_WINDOW(view->scrolled), GTK_POLICY_NEVER, GTK_POLICY_AUTOMATIC);
+    gtk_widget_set_hexpand(view->scrolled, TRUE);
+    gtk_widget_set_vexpand(view->scrolled, TRUE);
+    gtk_container_add(GTK_CONTAINER(view->scrolled), view->text_view);
+
+    g_mutex_init(&view->lock);
+    view->ready = g_ptr_array_new_with_free_func(batch_free);
+    markdown_init(&view->parser, on_span, view);
+    view->batch = batch_new();
+    view->at_line_start = TRUE;
+    view->empty = TRUE;
+    view->jobs = g_async_queue_new();
+    view->worker = g_thread_new("markdown", worker_main, view);
+    return view;
+}
+
+// After the window is gone; the widgets go with it
+void response_view_free(ResponseView *view) {
+    if (!view) return;
+    push_job(view, JOB_QUIT, 0, NULL, 0);
+    g_thread_join(view->worker);
+    g_async_queue_unref(view->jobs);
+    if (view->idle_id) g_source_remove(view->idle_id);
+    g_ptr_array_free(view->ready, TRUE);
+    batch_free(view->batch);
+    g_mutex_clear(&view->lock);
+    g_free(view);
+}
+
+GtkWidget* response_view_widget(ResponseView *view) {
+    return view->scrolled;
+}
+
+void response_view_begin(ResponseView *view) {
+    push_job(view, JOB_BEGIN, 0, NULL, 0);
+}
+
+void response_view_markdown(ResponseView *view, const char *text, size_t len) {
+    if (len) push_job(view, JOB_MARKDOWN, 0, text, len);
+}
+
+void response_view_end(ResponseView *view) {
+    push_job(view, JOB_END, 0, NULL, 0);
+}
+
+void response_view_note(ResponseView *view, ResponseNote kind, const char *text) {
+    push_job(view, JOB_NOTE, kind, text, strlen(text));
+}
+
+ResponseViewStats response_view_stats(ResponseView *view) {
+    return view->stats;
+}
@@ -0,0 +1,50 @@
+// response_view.h
+#ifndef RESPONSE_VIEW_H
+#define RESPONSE_VIEW_H
+
+#include <gtk/gtk.h>
+
+// The session's transcript (questions, answers, Gemini's replies) in a
+// scrolling GtkTextView. Text is only ever appended at the end, so GTK lays
+// out just the new lines however long the transcript grows; the markdown and
+// math in replies (markdown.c) become text tags on a worker thread, and the
+// main loop only inserts finished spans, once per batch.
+typedef struct ResponseView ResponseView;
+
+// Lines kept; older ones are dropped a block at a time past this
+#define RESPONSE_VIEW_MAX_LINES 10000
+
+typedef enum {
+    RESPONSE_NOTE_APP,      // the app's own text, e.g. a grading result
+    RESPONSE_NOTE_USER,     // what the user typed
+    RESPONSE_NOTE_ERROR,
+} ResponseNote;
+
+typedef struct {
+    guint64 batches;        // main loop insertions
+    guint64 bytes;
+    gint64 worst_apply_us;  // longest single insertion, the cost to a frame
+    gint64 total_apply_us;
+    int lines;
+} ResponseViewStats;
+
+// Call from the main loop only, like GTK itself
+ResponseView* response_view_new(void);
+void response_view_free(ResponseView *view);
+
+// The widget to pack (a scrolled window that expands)
+GtkWidget* response_view_widget(ResponseView *view);
+
+// Start a new entry, set apart from the previous one
+void response_view_begin(ResponseView *view);
+
+// Append a piece of markdown (a streamed reply); response_view_end closes it
+void response_view_markdown(ResponseView *view, const char *text, size_t len);
+void response_view_end(ResponseView *view);
+
+// Append text as is, on lines of its own
+void response_view_note(ResponseView *view, ResponseNote kind, const char *text);
+
+ResponseViewStats response_view_stats(ResponseView *view);
+
+#endif
@@ -0,0 +1,106 @@
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+#include "speedmath.h"
+
+const char* speedmath_setting(const char *name) {
+    const char *value = g_getenv(name);
+    return value ? value : config_get(config_default(), name);
+}
+
+double speedmath_setting_number(const char *name, double min, double max, double fallback) {
+    const char *text = speedmath_setting(name);
+    if (!text) return fallback;
+    char *end;
+    double value = g_ascii_strtod(text, &end);
+    while (g_ascii_isspace(*end)) end++;
+    if (end == text || *end || !(value >= min && value <= max)) {
+        fprintf(stderr, "Error: %s=%s is not a number from %g to %g; using %g\n", name, text, min, max, fallback);
+        return fallback;
+    }
+    return value;
+}
+
+long speedmath_setting_integer(const char *name, long min, long max, long fallback) {
+    const char *text = speedmath_setting(name);
+    if (!text) return fallback;
+    char *end;
+    errno = 0;
+    long value = strtol(text, &end, 10);
+    while (g_ascii_isspace(*end)) end++;
+    if (end == text || *end || errno || value < min || value > max) {
+        fprintf(stderr, "Error: %s=%s is not a whole number from %ld to %ld; using %ld\n", name, text, min, max, fallback);
+        return fallback;
+    }
+    return value;
+}
+
+int speedmath_api_init(SpeedmathApi *api) {
+    memset(api, 0, sizeof(*api));
+    api->url = SPEEDMATH_HOST_URL;
+    if (speedmath_setting("SPEEDMATH_OFFLINE")) {
+        api->offline = 1;
+        return 0;
+    }
+    const char *url = speedmath_setting("SPEEDMATH_API_URL");
+    if (url) api->url = url;
+    const char *key = config_api_key(config_default());
+    if (!key && url) key = "none";
+    if (!key) {
+        api->offline = 1;
+        return 0;
+    }
+    g_strlcpy(api->key, key, sizeof(api->key));
+    return 1;
+}
+
+int speedmath_api_url(const SpeedmathApi *api, int stream, char *buf, size_t size) {
+    return snprintf(buf, size, "%sv1beta/models/" SPEEDMATH_MODEL ":%s?%skey=%s", api->url,
+                    stream ? "streamGenerateContent" : "generateContent", stream ? "alt=sse&" : "", api->key);
+}
+
+const char* const* speedmath_api_headers(const SpeedmathApi *api, SpeedmathHeaders *storage) {
+    snprintf(storage->authorization, sizeof(storage->authorization), "Authorization: Bearer %s", api->key);
+    storage->list[0] = "Content-Type: application/json";
+    storage->list[1] = storage->authorization;
+    storage->list[2] = NULL;
+    return storage->list;
+}
+
+void speedmath_request_options(RequestOptions *options) {
+    const char *temperature = speedmath_setting("SPEEDMATH_TEMPERATURE");
+    const char *max_tokens = speedmath_setting("SPEEDMATH_MAX_TOKENS");
+    options->system_prompt = speedmath_setting("SPEEDMATH_SYSTEM_PROMPT");
+    options->temperature = temperature ? g_ascii_strtod(temperature, NULL) : -1;
+    options->max_output_tokens = max_tokens ? atoi(max_tokens) : 0;
+}
+
+QuestionBank* speedmath_open_bank(void) {
+    const char *path = speedmath_setting("SPEEDMATH_BANK");
+    // Without a bank questions are generated: only one asked for by name is missed
+    if (!path && !g_file_test(SPEEDMATH_BANK_PATH, G_FILE_TEST_EXISTS)) return NULL;
+    QuestionBank *bank = question_bank_open(path ? path : SPEEDMATH_BANK_PATH);
+    if (bank && question_bank_count(bank) == 0) {
+        question_bank_close(bank);
+        bank = NULL;
+    }
+    return bank;
+}
+
+AttemptLog* speedmath_open_history(void) {
+    const char *path = speedmath_setting("SPEEDMATH_HISTORY");
+    if (path && strcmp(path, "off") == 0) return NULL;
+    char *default_path = NULL;
+    if (!path) {
+        char *dir = g_build_filename(g_get_user_data_dir(), "speedmath", NULL);
+        g_mkdir_with_parents(dir, 0700);
+        path = default_path = g_build_filename(dir, "attempts.log", NULL);
+        g_free(dir);
+    }
+    AttemptLog *log = attempt_log_open(path);
+    if (!log) fprintf(stderr, "Could not open the answer history %s\n", path);
+    g_free(default_path);
+    return log;
+}
@@ -0,0 +1,80 @@
+// speedmath.h
+#ifndef SPEEDMATH_H
+#define SPEEDMATH_H
+
+// The core library (libspeedmath.a, see Makefile): every module that needs
+// no toolkit, and below them the setup each front end used to repeat, so the
+// GTK app, the terminal and the tools agree on settings, files and endpoints.
+#include "config.h"
+#include "request_engine.h"
+#include "connection_pool.h"
+#include "response_buffer.h"
+#include "request_body.h"
+#include "gemini_json.h"
+#include "gemini_stream.h"
+#include "conversation.h"
+#include "response_cache.h"
+#include "net_trace.h"
+#include "markdown.h"
+#include "question.h"
+#include "question_gen.h"
+#include "question_bank.h"
+#include "question_queue.h"
+#include "question_select.h"
+#include "answer_check.h"
+#include "question_timer.h"
+#include "stats.h"
+#include "attempt_log.h"
+#include "startup.h"
+
+#define SPEEDMATH_HOST_URL "https://generativelanguage.googleapis.com/"
+#define SPEEDMATH_MODEL "gemini-1.5-flash"
+#define SPEEDMATH_BANK_PATH "questions.bank"
+
+// SPEEDMATH_* settings: the environment wins over the .env files
+const char* speedmath_setting(const char *name);
+
+// A numeric setting from min to max, or fallback when it is not set; a
+// value that is not a number or out of range is reported and not used
+double speedmath_setting_number(const char *name, double min, double max, double fallback);
+// The same for a whole number
+long speedmath_setting_integer(const char *name, long min, long max, long fallback);
+
+// Where Gemini requests go, and with which key
+typedef struct {
+    char key[256];
+    const char *url;     // base URL, ends with '/'
+    int offline;         // no key: questions are generated locally
+} SpeedmathApi;
+
+// SPEEDMATH_OFFLINE, then the .env key; a stand-in server at
+// SPEEDMATH_API_URL (e.g. bench/mock_server) takes any key.
+// Returns 0 when offline.
+int speedmath_api_init(SpeedmathApi *api);
+
+// generateContent, or streamGenerateContent as SSE, with the key; returns
+// the length snprintf would have written
+int speedmath_api_url(const SpeedmathApi *api, int stream, char *buf, size_t size);
+
+// The request headers: content type and authorization, NULL-terminated.
+// Points into storage, which must outlive the request's setup.
+typedef struct {
+    char authorization[300];
+    const char *list[3];
+} SpeedmathHeaders;
+
+const char* const* speedmath_api_headers(const SpeedmathApi *api, SpeedmathHeaders *storage);
+
+// System prompt, temperature and token limit from the settings
+void speedmath_request_options(RequestOptions *options);
+
+// SPEEDMATH_BANK or questions.bank; NULL if it is missing or empty. A
+// missing questions.bank is not an error; an unreadable one is.
+QuestionBank* speedmath_open_bank(void);
+
+// Answer history (SPEEDMATH_HISTORY: the log's path, or "off" for NULL),
+// by default in the user data directory. Opening replays it, which takes
+// milliseconds even for years of answers.
+AttemptLog* speedmath_open_history(void);
+
+#endif
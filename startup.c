@@ -0,0 +1,97 @@
+#include "startup.h"
+
+typedef struct {
+    const char *name;
+    gint64 begin;
+    gint64 end;        // -1 while running
+    gboolean ok;
+} StartupPhase;
+
+struct Startup {
+    GMutex lock;       // phases are opened and closed from worker threads too
+    gint64 origin;
+    StartupPhase phases[STARTUP_MAX_PHASES];
+    guint count;
+};
+
+Startup* startup_new(void) {
+    Startup *startup = g_new0(Startup, 1);
+    g_mutex_init(&startup->lock);
+    startup->origin = g_get_monotonic_time();
+    return startup;
+}
+
+void startup_free(Startup *startup) {
+    if (!startup) return;
+    g_mutex_clear(&startup->lock);
+    g_free(startup);
+}
+
+gint64 startup_elapsed(const Startup *startup) {
+    return g_get_monotonic_time() - startup->origin;
+}
+
+guint startup_begin(Startup *startup, const char *name) {
+    gint64 now = startup_elapsed(startup);
+    g_mutex_lock(&startup->lock);
+    guint phase = startup->count;
+    if (phase < STARTUP_MAX_PHASES) {
+        startup->phases[phase] = (StartupPhase){ name, now, -1, FALSE };
+        startup->count++;
+    }
+    g_mutex_unlock(&startup->lock);
+    return phase;
+}
+
+void startup_end(Startup *startup, guint phase, gboolean ok) {
+    gint64 now = startup_elapsed(startup);
+    g_mutex_lock(&startup->lock);
+    if (phase < startup->count && startup->phases[phase].end < 0) {
+        startup->phases[phase].end = now;
+        startup->phases[phase].ok = ok;
+    }
+    g_mutex_unlock(&startup->lock);
+}
+
+void startup_add(Startup *startup, const char *name, gint64 begin_us, gint64 end_us, gboolean ok) {
+    g_mutex_lock(&startup->lock);
+    if (startup->count < STARTUP_MAX_PHASES)
+        startup->phases[startup->count++] = (StartupPhase){ name, begin_us, end_us, ok };
+    g_mutex_unlock(&startup->lock);
+}
+
+guint startup_pending(Startup *startup) {
+    guint pending = 0;
+    g_mutex_lock(&startup->lock);
+    for (guint i = 0; i < startup->count; i++)
+        if (startup->phases[i].end < 0) pending++;
+    g_mutex_unlock(&startup->lock);
+    return pending;
+}
+
+void startup_print(Startup *startup, FILE *out) {
+    g_mutex_lock(&startup->lock);
+    // Insertion sort by start time; there are only a handful of phases
+    StartupPhase sorted[STARTUP_MAX_PHASES];
+    guint count = startup->count;
+    for (guint i = 0; i < count; i++) {
+        guint j = i;
+        for (; j > 0 && sorted[j - 1].begin > startup->phases[i].begin; j--)
+            sorted[j] = sorted[j - 1];
+        sorted[j] = startup->phases[i];
+    }
+    g_mutex_unlock(&startup->lock);
+
+    gint64 last = 0;
+    for (guint i = 0; i < count; i++) {
+        const StartupPhase *p = &sorted[i];
+        if (p->end < 0) {
+            fprintf(out, "startup: %-14s at %8.1f ms  (still running)\n", p->name, p->begin / 1000.0);
+            continue;
+        }
+        fprintf(out, "startup: %-14s at %8.1f ms  took %8.1f ms%s\n", p->name, p->begin / 1000.0,
+                (p->end - p->begin) / 1000.0, p->ok ? "" : "  FAILED");
+        if (p->end > last) last = p->end;
+    }
+    fprintf(out, "startup: ready after %.1f ms\n", last / 1000.0);
+}
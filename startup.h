@@ -0,0 +1,32 @@
+// startup.h
+#ifndef STARTUP_H
+#define STARTUP_H
+
+#include <stdio.h>
+#include <glib.h>
+
+// Timeline of the startup phases, which may run on several threads at once.
+// Times are microseconds since startup_new.
+typedef struct Startup Startup;
+
+#define STARTUP_MAX_PHASES 16
+
+Startup* startup_new(void);
+void startup_free(Startup *startup);
+
+// Open a phase; returns its handle for startup_end (thread-safe)
+guint startup_begin(Startup *startup, const char *name);
+void startup_end(Startup *startup, guint phase, gboolean ok);
+
+// Record a phase measured elsewhere, e.g. from curl's transfer timings
+void startup_add(Startup *startup, const char *name, gint64 begin_us, gint64 end_us, gboolean ok);
+
+gint64 startup_elapsed(const Startup *startup);
+
+// Phases begun but not yet ended
+guint startup_pending(Startup *startup);
+
+// One line per phase in start order: offset, duration and result
+void startup_print(Startup *startup, FILE *out);
+
+#endif
@@ -0,0 +1,128 @@
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include "stats.h"
+
+// Bucket i holds values in (MIN * gamma^(i-1), MIN * gamma^i], with
+// gamma = (1 + a) / (1 - a); reporting a bucket's midpoint keeps the
+// relative error within a.
+static double gamma_log(void) {
+    return log((1 + STATS_SKETCH_ACCURACY) / (1 - STATS_SKETCH_ACCURACY));   // folded at compile time
+}
+
+static int bucket_of(double seconds) {
+    if (seconds <= STATS_SKETCH_MIN) return 0;
+    double index = ceil(log(seconds / STATS_SKETCH_MIN) / gamma_log());
+    return index >= STATS_SKETCH_BUCKETS ? STATS_SKETCH_BUCKETS - 1 : (int)index;
+}
+
+static double bucket_value(int bucket) {
+    if (bucket == 0) return STATS_SKETCH_MIN;
+    double g = gamma_log();
+    // 2 / (1 + gamma) * upper bound: the point equally far (relatively) from both ends
+    return STATS_SKETCH_MIN * exp(bucket * g) * 2 / (1 + exp(g));
+}
+
+void stream_stats_init(StreamStats *stats) {
+    memset(stats, 0, sizeof(*stats));
+}
+
+void stream_stats_add(StreamStats *stats, double seconds) {
+    if (!(seconds >= 0)) return;   // also drops NaN
+    stats->count++;
+    double delta = seconds - stats->mean;
+    stats->mean += delta / stats->count;
+    stats->m2 += delta * (seconds - stats->mean);
+
+    if (stats->count == 1) {
+        stats->min = stats->max = stats->ewma = seconds;
+    } else {
+        if (seconds < stats->min) stats->min = seconds;
+        if (seconds > stats->max) stats->max = seconds;
+        stats->ewma += STATS_EWMA_ALPHA * (seconds - stats->ewma);
+    }
+
+    uint32_t *bucket = &stats->buckets[bucket_of(seconds)];
+    if (*bucket < UINT32_MAX) (*bucket)++;
+}
+
+void stream_stats_merge(StreamStats *into, const StreamStats *from) {
+    if (!from->count) return;
+    if (!into->count) {
+        *into = *from;
+        return;
+    }
+    // Chan et al. parallel update of mean and M2
+    uint64_t n = into->count + from->count;
+    double delta = from->mean - into->mean;
+    into->mean += delta * from->count / n;
+    into->m2 += from->m2 + delta * delta * ((double)into->count * from->count / n);
+    into->count = n;
+    if (from->min < into->min) into->min = from->min;
+    if (from->max > into->max) into->max = from->max;
+    // Recency has no order across streams; from is taken as the newer one
+    into->ewma = from->ewma;
+
+    for (int i = 0; i < STATS_SKETCH_BUCKETS; i++) {
+        uint64_t sum = (uint64_t)into->buckets[i] + from->buckets[i];
+        into->buckets[i] = sum > UINT32_MAX ? UINT32_MAX : (uint32_t)sum;
+    }
+}
+
+double stream_stats_variance(const StreamStats *stats) {
+    return stats->count > 1 ? stats->m2 / (stats->count - 1) : 0;
+}
+
+double stream_stats_stddev(const StreamStats *stats) {
+    return sqrt(stream_stats_variance(stats));
+}
+
+double stream_stats_quantile(const StreamStats *stats, double q) {
+    if (!stats->count) return 0;
+    if (q <= 0) return stats->min;
+    if (q >= 1) return stats->max;
+
+    uint64_t total = 0;
+    for (int i = 0; i < STATS_SKETCH_BUCKETS; i++) total += stats->buckets[i];
+    uint64_t rank = (uint64_t)(q * (total - 1));
+    uint64_t seen = 0;
+    for (int i = 0; i < STATS_SKETCH_BUCKETS; i++) {
+        seen += stats->buckets[i];
+        if (seen > rank) {
+            double value = bucket_value(i);
+            // The sketch never reports outside what was actually seen
+            return value < stats->min ? stats->min : value > stats->max ? stats->max : value;
+        }
+    }
+    return stats->max;
+}
+
+void session_stats_init(SessionStats *stats) {
+    memset(stats, 0, sizeof(*stats));
+}
+
+void session_stats_record(SessionStats *stats, QuestionTopic topic, double seconds, int correct) {
+    stream_stats_add(&stats->all, seconds);
+    if (correct) stats->correct++;
+    if (topic < TOPIC_COUNT) {
+        stream_stats_add(&stats->topic[topic], seconds);
+        if (correct) stats->topic_correct[topic]++;
+    }
+}
+
+void session_stats_merge(SessionStats *into, const SessionStats *from) {
+    stream_stats_merge(&into->all, &from->all);
+    into->correct += from->correct;
+    for (int t = 0; t < TOPIC_COUNT; t++) {
+        stream_stats_merge(&into->topic[t], &from->topic[t]);
+        into->topic_correct[t] += from->topic_correct[t];
+    }
+}
+
+int stream_stats_format(const StreamStats *stats, char *buf, int size) {
+    if (!stats->count) return snprintf(buf, size, "no attempts yet");
+    return snprintf(buf, size, "avg %.2f s ± %.2f | recent %.2f s | p50 %.2f p90 %.2f p99 %.2f s (n=%llu)",
+                    stats->mean, stream_stats_stddev(stats), stats->ewma,
+                    stream_stats_quantile(stats, 0.5), stream_stats_quantile(stats, 0.9),
+                    stream_stats_quantile(stats, 0.99), (unsigned long long)stats->count);
+}
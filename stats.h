@@ -0,0 +1,54 @@
+// stats.h
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdint.h>
+#include "question.h"
+
+// Streaming solve-time statistics in constant memory: running mean and
+// variance (Welford), an EWMA of recent times, and a log-bucketed quantile
+// sketch with 1% relative error that merges by adding counts.
+// Times are in seconds.
+
+#define STATS_EWMA_ALPHA 0.2          // weight of the newest time
+#define STATS_SKETCH_ACCURACY 0.01    // relative error of quantiles
+#define STATS_SKETCH_MIN 0.001        // 1 ms; faster times share the first bucket
+#define STATS_SKETCH_BUCKETS 800      // covers up to ~2.5 hours at 1%
+
+typedef struct {
+    uint64_t count;
+    double mean;
+    double m2;             // sum of squared deviations from the mean
+    double min;
+    double max;
+    double ewma;
+    uint32_t buckets[STATS_SKETCH_BUCKETS];
+} StreamStats;
+
+void stream_stats_init(StreamStats *stats);
+void stream_stats_add(StreamStats *stats, double seconds);
+// Combine two streams as if every value had been added to into
+void stream_stats_merge(StreamStats *into, const StreamStats *from);
+
+double stream_stats_variance(const StreamStats *stats);   // sample variance
+double stream_stats_stddev(const StreamStats *stats);
+// q in [0, 1]; 0 when empty. Within STATS_SKETCH_ACCURACY of the true value.
+double stream_stats_quantile(const StreamStats *stats, double q);
+
+// One practice session: all attempts, and per topic
+typedef struct {
+    StreamStats all;
+    StreamStats topic[TOPIC_COUNT];
+    uint64_t correct;
+    uint64_t topic_correct[TOPIC_COUNT];
+} SessionStats;
+
+void session_stats_init(SessionStats *stats);
+void session_stats_record(SessionStats *stats, QuestionTopic topic, double seconds, int correct);
+void session_stats_merge(SessionStats *into, const SessionStats *from);
+
+// "avg 12.3 s ± 2.1 | recent 10.2 s | p50 11.0 p90 15.2 p99 20.1 s (n=42)"
+// into buf; returns the length written
+int stream_stats_format(const StreamStats *stats, char *buf, int size);
+
+#endif